@@ -24,6 +24,9 @@ from pymbdfparser.model.signal_encoding_type import PhysicalEncoding
 from ast import literal_eval
 from datetime import datetime
 
+# frame types of byte rows from low level analyzer
+BYTE_FRAME_TYPES = ('breakfield', 'header_ID1', 'header_ID2', 'instruction_byte1', 'instruction_byte2', 'data', 'crc1', 'crc2', 'ack')
+
 # High level analyzers must subclass the HighLevelAnalyzer class.
 class Hla(HighLevelAnalyzer):
     
@@ -95,6 +98,7 @@ class Hla(HighLevelAnalyzer):
         self.found_slave = False
         self.matched_frame = False
         self.unique_frame = True
+        self.packet_rows = None # decided by first byte or packet frame; frames of the other kind are ignored
                 
     def get_info_from_ids_melibu1(self):      
         # extract values from id fields
@@ -449,13 +453,69 @@ class Hla(HighLevelAnalyzer):
         return AnalyzerFrame('crc', self.crc_start, frame.end_time, {'raw_value': '0x' + hex(self.crc)[2:].upper()})
         
 
+    def decode_packet(self, frame:AnalyzerFrame):
+        # whole message in one frame from low level analyzer ("Table rows" with message rows)
+        self.id1 = frame.data['id1']
+        self.id2 = frame.data['id2']
+        self.inst_word = frame.data['instruction'] if 'instruction' in frame.data else 0
+        self.id1_start = frame.start_time
+        self.data_array = []
+        self.data_length = 0
+        self.info_str = ''
+
+        # byte field times from bit time; 10 bits per byte field
+        payload = frame.data['payload']
+        bit_time = frame.data['bit_time']
+        ack_time = 10 * bit_time if 'ack' in frame.data else 0
+        crc_time = 20 * bit_time if 'crc' in frame.data else 0
+        if len(payload) > 0:
+            data_start = frame.start_time + GraphTimeDelta(second = frame.data['data_offset'])
+        else:
+            data_start = frame.end_time - GraphTimeDelta(second = crc_time + ack_time)
+
+        # header frame ends where data starts
+        header_field = AnalyzerFrame('header', frame.start_time, data_start)
+        if self.protocol_version < 2.0:
+            slave_adr, rt, func, inst, frame_size = self.get_info_from_ids_melibu1()
+            self.check_slave(slave_adr)
+            frames = [self.match_frame_melibu1(header_field, rt, func, inst, frame_size)]
+        else:
+            slave_adr, rt, func, inst, frame_size = self.get_info_from_ids_melibu2()
+            self.check_slave(slave_adr)
+            frames = [self.match_frame_melibu2(header_field, rt, func, inst, frame_size, self.inst_word)]
+
+        # payload bytes are decoded the same way as data frames of byte rows
+        for i in range(len(payload)):
+            start = data_start + GraphTimeDelta(second = 10 * bit_time * i)
+            data_field = AnalyzerFrame('data', start, start + GraphTimeDelta(second = 10 * bit_time), {'data': '0x{:02X}'.format(payload[i])})
+            if self.matched_frame and self.unique_frame:
+                frames.extend(self.decode_unique_data(data_field))
+            elif self.matched_frame:
+                frames.extend(self.decode_data(data_field))
+            else:
+                frames.append(AnalyzerFrame('raw data', data_field.start_time, data_field.end_time, {'raw_value': data_field.data['data']}))
+
+        if 'crc' in frame.data:
+            crc_end = frame.end_time - GraphTimeDelta(second = ack_time)
+            frames.append(AnalyzerFrame('crc', crc_end - GraphTimeDelta(second = crc_time), crc_end, {'raw_value': '0x' + hex(frame.data['crc'])[2:].upper()}))
+        if 'ack' in frame.data:
+            frames.append(AnalyzerFrame('ack', frame.end_time - GraphTimeDelta(second = ack_time), frame.end_time))
+        return frames
+
     def decode(self, frame: AnalyzerFrame):
         '''
         Process a frame from the input analyzer, and optionally return a single `AnalyzerFrame` or a list of `AnalyzerFrame`s.
 
         The type and data values in `frame` will depend on the input analyzer.
         '''
-        if frame.type == 'breakfield':
+        if self.packet_rows is None and (frame.type == 'packet' or frame.type in BYTE_FRAME_TYPES):
+            # with byte and message rows the first message starts with byte frames, so byte frames are used
+            self.packet_rows = frame.type == 'packet'
+        if frame.type == 'packet':
+            return self.decode_packet(frame) if self.packet_rows else []
+        elif self.packet_rows and (frame.type in BYTE_FRAME_TYPES):
+            return [] # message is decoded from packet frame
+        elif frame.type == 'breakfield':
             return AnalyzerFrame('breakfield', frame.start_time, frame.end_time)
         elif frame.type == 'header_ID1':
             self.decode_id1(frame)
@@ -0,0 +1,232 @@
+'''
+Compile MBDF file to signal layout for MeLiBu low level analyzer.
+
+usage: python mbdf_to_layout.py [--binary] <mbdf file> <layout file>
+
+Low level analyzer loads layout file (setting "Signal layout") and adds a table row with raw and physical
+value of each signal, so MBDF is parsed once here and not every time capture is decoded.
+Frames are matched and signals extracted the same way as in HighLevelAnalyzer.py.
+Default output is a text layout; --binary writes a layout that analyzer maps into memory without parsing
+(records as in MELIBUSignalLayout.h).
+'''
+
+import struct
+import sys
+from pathlib import Path
+
+LAYOUT_FORMAT = 1
+BINARY_FORMAT = 1
+BINARY_MAGIC = b'MLBLAYT\0'
+
+# MELIBUSignalLayoutHeader and records; little endian, no padding
+HEADER = struct.Struct('<8sIIdBBH' + 'II' * 9 + 'I')
+FRAME = struct.Struct('<IBBHII')
+SIGNAL = struct.Struct('<IIIi')
+CHUNK = struct.Struct('<HH')
+ENCODING_TYPE = struct.Struct('<III')
+ENCODING = struct.Struct('<IIIIdd')
+SLOT = struct.Struct('<III')
+ENCODING_LOGICAL = 0
+ENCODING_PHYSICAL = 1
+
+
+def frame_header_melibu1(frame):
+    # R/T and F bits of ID1 and ID2 without slave address; same fields as match_frame_melibu1 in HLA
+    f_bit = 0 if frame.function_type == 'Command' else 1
+    id1 = (frame.r_t_bit << 1) | f_bit
+    if f_bit == 0:
+        id2 = (frame.ext_instruction << 5) | (frame.sub_address << 2)
+    else:
+        id2 = frame.sub_address << 2
+    return id1, id2, None
+
+
+def frame_header_melibu2(frame):
+    # same fields as match_frame_melibu2 in HLA; instruction word only if I bit is set
+    f_bit = 0 if frame.function_type == 'Command' else 1
+    id2 = frame.r_t_bit | (f_bit << 1) | (frame.i_bit << 2) | (frame.pl_length << 3)
+    instruction = frame.instruction_word if frame.i_bit != 0 else None
+    return 0, id2, instruction
+
+
+def name(text):
+    # names are separated by spaces in text layout
+    return str(text).replace(' ', '_')
+
+
+def compile_layout(model):
+    ''' Layout of model as plain values; shared by text and binary output. '''
+    version = float(model.bus_protocol_version)
+    layout = {
+        'version': version,
+        'masks': (0x03, 0xFC) if version < 2 else (0x00, 0x3F),  # MeLiBu 1: R/T, F and ID2; MeLiBu 2: R/T, F, I, length
+        'slaves': [node.configured_nad for node in model.nodes.values()
+                   if node.__class__.__name__ == 'SlaveNode' and node.configured_nad is not None],
+        'encoding_types': [],  # (name, [(type, min, max, scale, offset, text)])
+        'frames': [],          # (name, id1, id2, instruction or None, [(name, encoding type index or -1, [(offset, size)])])
+    }
+
+    encoding_types = {}
+    for frame_name, frame in model.frames.items():
+        if version < 2:
+            id1, id2, instruction = frame_header_melibu1(frame)
+            chunks = frame.signal_chunks_big_endian
+        else:
+            id1, id2, instruction = frame_header_melibu2(frame)
+            chunks = frame.signal_chunks_little_endian
+
+        # signals in order of first chunk in payload; chunks are joined in order of significance like in HLA
+        signals = []
+        for chunk in sorted(chunks, key=lambda x: x.real_offset):
+            if chunk.signal not in signals:
+                signals.append(chunk.signal)
+        frame_signals = []
+        for signal in signals:
+            encoding_type = signal.encoding_type
+            type_index = -1
+            if encoding_type is not None:
+                if encoding_type.name not in encoding_types:
+                    encoding_types[encoding_type.name] = len(layout['encoding_types'])
+                    encodings = []
+                    for encoding in encoding_type.encodings:
+                        if encoding.__class__.__name__ == 'PhysicalEncoding':
+                            encodings.append((ENCODING_PHYSICAL, int(encoding.min_value), int(encoding.max_value),
+                                              float(encoding.scale), float(encoding.offset), encoding.text or ''))
+                        else:
+                            encodings.append((ENCODING_LOGICAL, int(encoding.value), int(encoding.value), 1.0, 0.0,
+                                              encoding.text or ''))
+                    layout['encoding_types'].append((name(encoding_type.name), encodings))
+                type_index = encoding_types[encoding_type.name]
+            signal_chunks = sorted([c for c in chunks if c.signal is signal], key=lambda x: x.significance)
+            frame_signals.append((name(signal.name), type_index, [(c.real_offset, c.size) for c in signal_chunks]))
+        layout['frames'].append((name(frame_name), id1, id2, instruction, frame_signals))
+    return layout
+
+
+def write_text(layout, out):
+    out.write('melibu_signal_layout {}\n'.format(LAYOUT_FORMAT))
+    out.write('protocol {}\n'.format(layout['version']))
+    out.write('header_mask 0x{:02X} 0x{:02X}\n'.format(*layout['masks']))
+    for nad in layout['slaves']:
+        out.write('slave 0x{:02X}\n'.format(nad))
+    for type_name, encodings in layout['encoding_types']:
+        out.write('encoding_type {}\n'.format(type_name))
+        for kind, minimum, maximum, scale, offset, text in encodings:
+            if kind == ENCODING_PHYSICAL:
+                out.write('physical {} {} {!r} {!r} {}\n'.format(minimum, maximum, scale, offset, text))
+            else:
+                out.write('logical {} {}\n'.format(minimum, text))
+    for frame_name, id1, id2, instruction, signals in layout['frames']:
+        out.write('frame {} 0x{:02X} 0x{:02X} {}\n'.format(frame_name, id1, id2,
+                                                           '-' if instruction is None else '0x{:04X}'.format(instruction)))
+        for signal_name, type_index, chunks in signals:
+            encoding_type = '-' if type_index < 0 else layout['encoding_types'][type_index][0]
+            out.write('signal {} {} {}\n'.format(signal_name, encoding_type,
+                                                 ' '.join('{}:{}'.format(offset, size) for offset, size in chunks)))
+
+
+def hash_key(key):
+    # MELIBUSignalLayout::Hash
+    value = (key * 0x9E3779B1) & 0xFFFFFFFF
+    return value ^ (value >> 16)
+
+
+def write_binary(layout, out):
+    mask1, mask2 = layout['masks']
+    names = bytearray()
+
+    def add_name(text):
+        offset = len(names)
+        names.extend(text.encode('utf-8') + b'\0')
+        return offset
+
+    encoding_types = bytearray()
+    encodings = bytearray()
+    encoding_count = 0
+    for type_name, type_encodings in layout['encoding_types']:
+        encoding_types += ENCODING_TYPE.pack(add_name(type_name), encoding_count, len(type_encodings))
+        for kind, minimum, maximum, scale, offset, text in type_encodings:
+            encodings += ENCODING.pack(kind, add_name(text), minimum, maximum, scale, offset)
+        encoding_count += len(type_encodings)
+
+    frames = bytearray()
+    signals = bytearray()
+    chunks = bytearray()
+    signal_count = 0
+    chunk_count = 0
+    keys = {}  # key: frame indices, in order of first frame like MELIBUSignalLayout::BuildIndex
+    for index, (frame_name, id1, id2, instruction, frame_signals) in enumerate(layout['frames']):
+        id1 &= mask1
+        id2 &= mask2
+        instruction = instruction or 0
+        frames += FRAME.pack(add_name(frame_name), id1, id2, instruction, signal_count, len(frame_signals))
+        for signal_name, type_index, signal_chunks in frame_signals:
+            signals += SIGNAL.pack(add_name(signal_name), chunk_count, len(signal_chunks), type_index)
+            for offset, size in signal_chunks:
+                chunks += CHUNK.pack(offset, size)
+            chunk_count += len(signal_chunks)
+        signal_count += len(frame_signals)
+        keys.setdefault((id1 << 24) | (id2 << 16) | instruction, []).append(index)
+
+    # open addressing with linear probing; at least half of slots stay empty
+    num_slots = 1
+    while num_slots < 2 * len(keys) + 1:
+        num_slots <<= 1
+    slots = [(0, 0, 0)] * num_slots
+    index_frames = []
+    for key, key_frames in keys.items():
+        slot = hash_key(key) & (num_slots - 1)
+        while slots[slot][2] != 0:
+            slot = (slot + 1) & (num_slots - 1)
+        slots[slot] = (key, len(index_frames), len(key_frames))
+        index_frames.extend(key_frames)
+
+    if len(names) == 0:
+        add_name('')
+    sections = [
+        (frames, len(layout['frames'])),
+        (signals, signal_count),
+        (chunks, chunk_count),
+        (encoding_types, len(layout['encoding_types'])),
+        (encodings, encoding_count),
+        (bytes(layout['slaves']), len(layout['slaves'])),
+        (names, len(names)),
+        (b''.join(SLOT.pack(*slot) for slot in slots), num_slots),
+        (struct.pack('<{}I'.format(len(index_frames)), *index_frames), len(index_frames)),
+    ]
+
+    # sections start at multiples of 8 after header
+    body = bytearray()
+    table = []
+    for data, count in sections:
+        body += bytes(-(HEADER.size + len(body)) % 8)
+        table += [HEADER.size + len(body), count]
+        body += data
+    header = HEADER.pack(BINARY_MAGIC, BINARY_FORMAT, HEADER.size + len(body), layout['version'],
+                         mask1, mask2, 0, *table, 0)
+    out.write(header)
+    out.write(body)
+
+
+def main(argv):
+    binary = '--binary' in argv
+    args = [arg for arg in argv[1:] if arg != '--binary']
+    if len(args) != 2:
+        print(__doc__.strip())
+        return 2
+
+    from pymbdfparser import ParserApplication
+    app = ParserApplication(Path(args[0]))
+    app.run()
+    layout = compile_layout(app.model)
+    if binary:
+        with open(args[1], 'wb') as out:
+            write_binary(layout, out)
+    else:
+        with open(args[1], 'w') as out:
+            write_text(layout, out)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
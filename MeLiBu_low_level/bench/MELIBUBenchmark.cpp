@@ -0,0 +1,333 @@
+// microbenchmarks of decoder hot paths; uses only the decoder core (no Analyzer SDK)
+// usage: MELIBUBenchmark [seconds per measurement, default 0.2]
+
+#include "MELIBUCrc.h"
+#include "MELIBUDecoder.h"
+#include "MELIBUEdgeChannel.h"
+#include "MELIBUFormat.h"
+#include "MELIBUFrameLayout.h"
+#include "MELIBUPacketStore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    double gMinSeconds = 0.2;
+
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds( Clock::time_point start ) {
+        return std::chrono::duration < double >( Clock::now() - start ).count();
+    }
+
+    void Report( const char* name, double seconds, double items, const char* unit ) {
+        printf( "%-44s %10.2f ns/%s %12.3f M%s/s\n", name, seconds * 1e9 / items, unit, items / seconds / 1e6, unit );
+    }
+
+    // run function repeatedly until minimum time is reached; function returns number of processed items
+    template < class F >
+    void Measure( const char* name, const char* unit, F function ) {
+        double items = 0;
+        Clock::time_point start = Clock::now();
+        do {
+            items += function();
+        } while( Seconds( start ) < gMinSeconds );
+        Report( name, Seconds( start ), items, unit );
+    }
+
+    U16 CrcBitwise( const U8* data, size_t length ) {
+        U16 crc = 0xFFFF;
+        for( size_t i = 0; i < length; i++ ) {
+            crc ^= ( U16 )data[ i ] << 8;
+            for( int bit = 0; bit < 8; bit++ )
+                crc = ( crc & 0x8000 ) ? ( U16 )( ( crc << 1 ) ^ 0x1021 ) : ( U16 )( crc << 1 );
+        }
+        return crc;
+    }
+
+    // table driven crc must give the same result as bitwise calculation for all lengths and alignments
+    bool CheckCrc() {
+        std::mt19937 rng( 1 );
+        std::vector < U8 > data( 1024 );
+        for( auto& byte : data )
+            byte = rng();
+        for( size_t offset = 0; offset < 8; offset++ ) {
+            for( size_t length = 0; length + offset <= data.size(); length += 1 + length / 8 ) {
+                U16 expected = CrcBitwise( &data[ offset ], length );
+                MELIBUCrc crc;
+                for( size_t i = 0; i < length; i++ )
+                    crc.add( data[ offset + i ] );
+                if( crc.result() != expected || MELIBUCrc::calculate( &data[ offset ], length ) != expected )
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void BenchCrc() {
+        std::vector < U8 > data( 1 << 16 );
+        std::mt19937 rng( 2 );
+        for( auto& byte : data )
+            byte = rng();
+
+        printf( "crc self-check: %s\n", CheckCrc() ? "OK" : "FAILED" );
+        volatile U16 sink = 0;
+        Measure( "crc bitwise reference", "byte", [ & ]() {
+            sink = CrcBitwise( data.data(), data.size() );
+            return ( double )data.size();
+        } );
+        Measure( "crc add(U8)", "byte", [ & ]() {
+            MELIBUCrc crc;
+            for( U8 byte : data )
+                crc.add( byte );
+            sink = crc.result();
+            return ( double )data.size();
+        } );
+        Measure( "crc add(data, length)", "byte", [ & ]() {
+            sink = MELIBUCrc::calculate( data.data(), data.size() );
+            return ( double )data.size();
+        } );
+    }
+
+    void BenchLayout() {
+        const char* names[] = { "MeLiBu 1", "MeLiBu 1 extended", "MeLiBu 2" };
+        const double versions[] = { 1.0, 1.1, 2.0 };
+        volatile U32 sink = 0;
+        for( int v = 0; v < 3; v++ ) {
+            MELIBUDecoderSettings settings;
+            settings.mSampleRateHz = 10000000;
+            settings.mMELIBUVersion = versions[ v ];
+            MELIBUDecoder decoder( nullptr, nullptr );
+            decoder.Setup( settings );
+
+            std::string name = std::string( "NumberOfDataBytes " ) + names[ v ];
+            Measure( name.c_str(), "id", [ & ]() {
+                U32 sum = 0;
+                for( U32 id = 0; id < 65536; id++ )
+                    sum += decoder.NumberOfDataBytes( id >> 8, id & 0xFF );
+                sink = sum;
+                return 65536.0;
+            } );
+        }
+    }
+
+    // edge stream of valid messages with random ids and payload; bits are exactly oversampling samples long
+    struct EdgeStream
+    {
+        std::vector < U64 > mEdges;
+        U64 mEndSample;
+        U64 mBytes; // byte fields including break
+    };
+
+    class EdgeWriter
+    {
+     public:
+        EdgeWriter( std::vector < U64 >& edges, U32 oversampling ) : mEdges( edges ), mOversampling( oversampling ), mBit( 4 ), mHigh( true ) {}
+
+        void Bits( bool high, U32 count ) {
+            if( high != this->mHigh ) {
+                this->mEdges.push_back( this->mBit * this->mOversampling );
+                this->mHigh = high;
+            }
+            this->mBit += count;
+        }
+
+        void Byte( U8 value, bool lsb_first ) {
+            Bits( false, 1 );
+            for( U32 i = 0; i < 8; i++ )
+                Bits( ( ( lsb_first ? value >> i : value >> ( 7 - i ) ) & 1 ) != 0, 1 );
+            Bits( true, 1 );
+        }
+
+        U64 Sample() {
+            return this->mBit * this->mOversampling;
+        }
+
+     protected:
+        std::vector < U64 >& mEdges;
+        U32 mOversampling;
+        U64 mBit;
+        bool mHigh;
+    };
+
+    EdgeStream MakeEdgeStream( double version, U32 oversampling, U32 messages ) {
+        MELIBUProtocol::tVersion protocol = MELIBUProtocol::FromVersion( version );
+        const MELIBUFrameLayoutTable& layouts = MELIBUFrameLayoutTable::Get( protocol );
+        bool lsb_first = protocol == MELIBUProtocol::MeLiBu2;
+        bool crc_msb_first = MELIBUProtocol::CrcMsbFirst( protocol );
+        U32 break_bits = lsb_first ? 11 : 13;
+
+        EdgeStream stream;
+        stream.mBytes = 0;
+        EdgeWriter writer( stream.mEdges, oversampling );
+        std::mt19937 rng( 3 );
+        for( U32 m = 0; m < messages; m++ ) {
+            std::vector < U8 > bytes;
+            bytes.push_back( rng() );
+            bytes.push_back( rng() );
+            const MELIBUFrameLayout& layout = layouts.Lookup( bytes[ 0 ], bytes[ 1 ] );
+            U32 length = layout.mDataLength + ( ( layout.mFlags & MELIBUFrameLayout::hasInstruction ) ? 2 : 0 );
+            for( U32 i = 0; i < length; i++ )
+                bytes.push_back( rng() );
+            U16 crc = MELIBUCrc::calculate( bytes.data(), bytes.size() );
+            bytes.push_back( crc_msb_first ? crc >> 8 : crc & 0xFF );
+            bytes.push_back( crc_msb_first ? crc & 0xFF : crc >> 8 );
+
+            writer.Bits( false, break_bits );
+            writer.Bits( true, 1 );
+            for( U8 byte : bytes )
+                writer.Byte( byte, lsb_first );
+            writer.Bits( true, 2 ); // inter frame space
+            stream.mBytes += bytes.size() + 1;
+        }
+        stream.mEndSample = writer.Sample() + oversampling;
+        return stream;
+    }
+
+    class CountingListener: public MELIBUDecoderListener
+    {
+     public:
+        CountingListener() : mMarkers( 0 ), mBytes( 0 ), mPackets( 0 ), mErrors( 0 ) {}
+
+        virtual void OnMarker( U64 /*sample_number*/, U8 /*marker*/ ) {
+            this->mMarkers++;
+        }
+        virtual void OnByte( const MELIBUByteRecord& byte ) {
+            this->mBytes++;
+            if( byte.mFlags != 0 )
+                this->mErrors++;
+        }
+        virtual void OnMissingByte( S64 /*starting_sample*/, S64 /*ending_sample*/ ) {
+            this->mErrors++;
+        }
+        virtual void OnPacket( const MELIBUPacketRecord& /*packet*/ ) {
+            this->mPackets++;
+        }
+        virtual void OnProgress( S64 /*sample_number*/ ) {}
+
+        U64 mMarkers;
+        U64 mBytes;
+        U64 mPackets;
+        U64 mErrors;
+    };
+
+    void BenchDecode() {
+        const U32 bit_rates[] = { 19200, 1000000, 2000000, 6000000 };
+        const U32 oversamplings[] = { 3, 4, 8, 16 };
+        const double versions[] = { 1.0, 2.0 };
+        const char* decoder_names[] = { "sampling", "edges", "tracking" };
+
+        printf( "\n%-8s %-8s %-3s %-9s %-7s %10s %12s %10s %8s\n", "version", "bitrate", "os", "decoder", "markers", "ns/byte", "Mbyte/s",
+                "realtime", "errors" );
+        for( double version : versions ) {
+            for( U32 oversampling : oversamplings ) {
+                EdgeStream stream = MakeEdgeStream( version, oversampling, 2000 );
+                for( U32 bit_rate : bit_rates ) {
+                    for( U32 byte_decoder = 0; byte_decoder < 3; byte_decoder++ ) {
+                        for( U32 marker_level = 0; marker_level < 3; marker_level += 2 ) {
+                            MELIBUDecoderSettings settings;
+                            settings.mSampleRateHz = bit_rate * oversampling;
+                            settings.mBitRate = bit_rate;
+                            settings.mMELIBUVersion = version;
+                            settings.mByteDecoder = byte_decoder;
+                            settings.mMarkerLevel = marker_level;
+
+                            CountingListener listener;
+                            double bytes = 0;
+                            Clock::time_point start = Clock::now();
+                            do {
+                                MELIBUEdgeChannel channel( stream.mEdges, true, stream.mEndSample );
+                                MELIBUDecoder decoder( &channel, &listener );
+                                decoder.Setup( settings );
+                                decoder.Decode();
+                                bytes += stream.mBytes;
+                            } while( Seconds( start ) < gMinSeconds );
+                            double seconds = Seconds( start );
+
+                            double captured_seconds = bytes / stream.mBytes * stream.mEndSample / settings.mSampleRateHz;
+                            printf( "%-8.1f %-8u %-3u %-9s %-7s %10.2f %12.3f %9.1fx %8llu\n", version, bit_rate, oversampling,
+                                    decoder_names[ byte_decoder ], marker_level == 0 ? "all" : "errors", seconds * 1e9 / bytes,
+                                    bytes / seconds / 1e6, captured_seconds / seconds, ( unsigned long long )listener.mErrors );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void BenchFormat() {
+        std::mt19937 rng( 4 );
+        std::vector < U8 > values( 4096 );
+        for( auto& value : values )
+            value = rng();
+        volatile size_t sink = 0;
+
+        printf( "\n" );
+        Measure( "FrameV2 strings (type, data, index, crc)", "byte", [ & ]() {
+            size_t sum = 0;
+            for( size_t i = 0; i < values.size(); i++ ) {
+                sum += ( size_t )MELIBUFormat::FrameTypeName( values[ i ] % 11 );
+                sum += ( size_t )MELIBUFormat::ByteHex( values[ i ] );
+                sum += ( size_t )MELIBUFormat::ByteHex( i & 0x7F );
+                sum += ( size_t )MELIBUFormat::WordHex( values[ i ] * 257 );
+            }
+            sink = sum;
+            return ( double )values.size();
+        } );
+
+        std::string out;
+        Measure( "export byte row", "row", [ & ]() {
+            out.clear();
+            for( size_t i = 0; i < values.size(); i++ )
+                MELIBUFormat::AppendByteRow( out, values[ i ] % 11, i * 1000, 10000000, MELIBUFormat::ByteHex( values[ i ] ), values[ i ] & 0x1F );
+            sink = out.size();
+            return ( double )values.size();
+        } );
+
+        MELIBUPacketStore store;
+        MELIBUPacketRecord record = MELIBUPacketRecord();
+        record.mComplete = true;
+        for( U32 i = 0; i < 1024; i++ ) {
+            record.mID1 = rng();
+            record.mID2 = rng();
+            record.mDataLength = rng() % MELIBUPacketRecord::MaxDataBytes;
+            for( U32 j = 0; j < record.mDataLength; j++ )
+                record.mData[ j ] = rng();
+            store.Add( record, i );
+        }
+        std::vector < MELIBUPacketSummary > packets;
+        std::vector < U8 > payload;
+        store.Copy( 0, store.Count(), packets, payload );
+        Measure( "export message row", "row", [ & ]() {
+            out.clear();
+            for( const auto& packet : packets )
+                MELIBUFormat::AppendPacketRow( out, packet, payload.data() + packet.mPayloadOffset, 0, 10000000 );
+            sink = out.size();
+            return ( double )packets.size();
+        } );
+        Measure( "message summary (tabular text)", "row", [ & ]() {
+            for( const auto& packet : packets ) {
+                out.clear();
+                MELIBUFormat::AppendPacketSummary( out, packet, payload.data() + packet.mPayloadOffset );
+            }
+            sink = out.size();
+            return ( double )packets.size();
+        } );
+    }
+}
+
+int main( int argc, char** argv ) {
+    if( argc > 1 )
+        gMinSeconds = atof( argv[ 1 ] );
+
+    BenchCrc();
+    BenchLayout();
+    BenchDecode();
+    BenchFormat();
+    return CheckCrc() ? 0 : 1;
+}
@@ -0,0 +1,678 @@
+// local implementation of the Analyzer SDK classes used by MELIBUAnalyzer
+// replaces the SDK library (which needs the Logic application) so that unchanged analyzer code can run headless;
+// compiled against the SDK headers, implements only what this analyzer calls
+
+#include "ReplayCapture.h"
+
+#include <Analyzer.h>
+#include <AnalyzerChannelData.h>
+#include <AnalyzerHelpers.h>
+#include <AnalyzerResults.h>
+#include <AnalyzerSettings.h>
+#include <SimulationChannelDescriptor.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace Replay
+{
+    ReplayCapture gCapture;
+    ReplayRecorder gRecorder;
+
+    bool LoadEdges( const char* file_name, ReplayChannel& channel ) {
+        FILE* file = fopen( file_name, "r" );
+        if( file == nullptr )
+            return false;
+        int initial_high;
+        unsigned long long end_sample, num_edges;
+        bool ok = fscanf( file, "%d %llu %llu", &initial_high, &end_sample, &num_edges ) == 3;
+        channel.mInitialHigh = initial_high != 0;
+        channel.mEndSample = end_sample;
+        channel.mEdges.clear();
+        for( U64 i = 0; ok && i < num_edges; i++ ) {
+            unsigned long long edge;
+            ok = fscanf( file, "%llu", &edge ) == 1 && ( channel.mEdges.empty() || edge >= channel.mEdges.back() );
+            channel.mEdges.push_back( edge );
+        }
+        fclose( file );
+        return ok;
+    }
+
+    bool SaveEdges( const char* file_name, const ReplayChannel& channel ) {
+        FILE* file = fopen( file_name, "w" );
+        if( file == nullptr )
+            return false;
+        fprintf( file, "%d %llu %llu\n", channel.mInitialHigh ? 1 : 0, ( unsigned long long )channel.mEndSample,
+                 ( unsigned long long )channel.mEdges.size() );
+        for( U64 edge : channel.mEdges )
+            fprintf( file, "%llu\n", ( unsigned long long )edge );
+        return fclose( file ) == 0;
+    }
+}
+
+using Replay::gCapture;
+using Replay::gRecorder;
+
+// Channel
+
+Channel::Channel() : mDeviceId( 0 ), mChannelIndex( 0 ) {}
+Channel::Channel( const Channel& channel ) : mDeviceId( channel.mDeviceId ), mChannelIndex( channel.mChannelIndex ) {}
+Channel::Channel( U64 device_id, U32 channel_index ) : mDeviceId( device_id ), mChannelIndex( channel_index ) {}
+Channel::~Channel() {}
+
+Channel& Channel::operator=( const Channel& channel ) {
+    this->mDeviceId = channel.mDeviceId;
+    this->mChannelIndex = channel.mChannelIndex;
+    return *this;
+}
+
+bool Channel::operator==( const Channel& channel ) const {
+    return this->mDeviceId == channel.mDeviceId && this->mChannelIndex == channel.mChannelIndex;
+}
+
+bool Channel::operator!=( const Channel& channel ) const {
+    return !( *this == channel );
+}
+
+bool Channel::operator<( const Channel& channel ) const {
+    return this->mDeviceId < channel.mDeviceId || ( this->mDeviceId == channel.mDeviceId && this->mChannelIndex < channel.mChannelIndex );
+}
+
+bool Channel::operator>( const Channel& channel ) const {
+    return channel < *this;
+}
+
+// AnalyzerChannelData; ChannelData* is ReplayChannel*
+
+struct AnalyzerChannelDataData
+{
+    const ReplayChannel* mChannel;
+    U64 mSample;
+    size_t mNextEdge; // index of first edge after current sample
+};
+
+AnalyzerChannelData::AnalyzerChannelData( ChannelData* channel_data ) {
+    this->mData = new AnalyzerChannelDataData();
+    this->mData->mChannel = reinterpret_cast < const ReplayChannel* >( channel_data );
+    this->mData->mSample = 0;
+    this->mData->mNextEdge = 0;
+}
+
+AnalyzerChannelData::~AnalyzerChannelData() {
+    delete this->mData;
+}
+
+U64 AnalyzerChannelData::GetSampleNumber() {
+    return this->mData->mSample;
+}
+
+BitState AnalyzerChannelData::GetBitState() {
+    bool high = this->mData->mChannel->mInitialHigh != ( ( this->mData->mNextEdge & 1 ) != 0 );
+    return high ? BIT_HIGH : BIT_LOW;
+}
+
+U32 AnalyzerChannelData::Advance( U32 num_samples ) {
+    return AdvanceToAbsPosition( this->mData->mSample + num_samples );
+}
+
+U32 AnalyzerChannelData::AdvanceToAbsPosition( U64 sample_number ) {
+    const std::vector < U64 >& edges = this->mData->mChannel->mEdges;
+    if( sample_number >= this->mData->mChannel->mEndSample )
+        throw ReplayEndOfCapture();
+
+    U32 transitions = 0;
+    while( this->mData->mNextEdge < edges.size() && edges[ this->mData->mNextEdge ] <= sample_number ) {
+        this->mData->mNextEdge++;
+        transitions++;
+    }
+    if( sample_number > this->mData->mSample )
+        this->mData->mSample = sample_number;
+    return transitions;
+}
+
+void AnalyzerChannelData::AdvanceToNextEdge() {
+    AdvanceToAbsPosition( GetSampleOfNextEdge() );
+}
+
+U64 AnalyzerChannelData::GetSampleOfNextEdge() {
+    if( this->mData->mNextEdge >= this->mData->mChannel->mEdges.size() )
+        throw ReplayEndOfCapture();
+    return this->mData->mChannel->mEdges[ this->mData->mNextEdge ];
+}
+
+bool AnalyzerChannelData::WouldAdvancingCauseTransition( U32 num_samples ) {
+    return WouldAdvancingToAbsPositionCauseTransition( this->mData->mSample + num_samples );
+}
+
+bool AnalyzerChannelData::WouldAdvancingToAbsPositionCauseTransition( U64 sample_number ) {
+    const std::vector < U64 >& edges = this->mData->mChannel->mEdges;
+    return this->mData->mNextEdge < edges.size() && edges[ this->mData->mNextEdge ] <= sample_number;
+}
+
+void AnalyzerChannelData::TrackMinimumPulseWidth() {}
+
+U64 AnalyzerChannelData::GetMinimumPulseWidthSoFar() {
+    return 0;
+}
+
+bool AnalyzerChannelData::DoMoreTransitionsExistInCurrentData() {
+    return this->mData->mNextEdge < this->mData->mChannel->mEdges.size();
+}
+
+// Analyzer
+
+struct AnalyzerData
+{
+    std::map < Channel, AnalyzerChannelData* > mChannels;
+};
+
+Analyzer::Analyzer() {
+    this->mAnalyzerData = new AnalyzerData();
+}
+
+Analyzer::~Analyzer() {
+    for( auto& channel : this->mAnalyzerData->mChannels )
+        delete channel.second;
+    delete this->mAnalyzerData;
+}
+
+void Analyzer::SetAnalyzerSettings( AnalyzerSettings* /*settings*/ ) {}
+void Analyzer::KillThread() {}
+void Analyzer::SetThreadMustExit() {}
+void Analyzer::CheckIfThreadShouldExit() {}
+void Analyzer::UseFrameV2() {}
+void Analyzer::SetAnalyzerResults( AnalyzerResults* /*results*/ ) {}
+void Analyzer::SetupResults() {}
+
+AnalyzerChannelData* Analyzer::GetAnalyzerChannelData( Channel& channel ) {
+    AnalyzerChannelData*& data = this->mAnalyzerData->mChannels[ channel ];
+    if( data == nullptr )
+        data = new AnalyzerChannelData( reinterpret_cast < ChannelData* >( &gCapture.mChannels[ channel.mChannelIndex ] ) );
+    return data;
+}
+
+void Analyzer::ReportProgress( U64 /*sample_number*/ ) {
+    gRecorder.mProgressReports++;
+}
+
+U32 Analyzer::GetSimulationSampleRate() {
+    return gCapture.mSampleRateHz;
+}
+
+U32 Analyzer::GetSampleRate() {
+    return gCapture.mSampleRateHz;
+}
+
+U64 Analyzer::GetTriggerSample() {
+    return 0;
+}
+
+Analyzer2::Analyzer2() {}
+void Analyzer2::SetupResults() {}
+
+// Frame, FrameV2; FrameV2 keeps its fields as text only when results are logged
+
+Frame::Frame() : mStartingSampleInclusive( 0 ), mEndingSampleInclusive( 0 ), mData1( 0 ), mData2( 0 ), mType( 0 ), mFlags( 0 ) {}
+
+Frame::Frame( const Frame& frame )
+    :   mStartingSampleInclusive( frame.mStartingSampleInclusive ),
+    mEndingSampleInclusive( frame.mEndingSampleInclusive ),
+    mData1( frame.mData1 ),
+    mData2( frame.mData2 ),
+    mType( frame.mType ),
+    mFlags( frame.mFlags ) {}
+
+Frame::~Frame() {}
+
+bool Frame::HasFlag( U8 flag ) {
+    return ( this->mFlags & flag ) != 0;
+}
+
+struct FrameV2Data
+{
+    std::ostringstream mFields;
+};
+
+FrameV2::FrameV2() {
+    this->mInternals = new FrameV2Data();
+}
+
+FrameV2::~FrameV2() {
+    delete this->mInternals;
+}
+
+void FrameV2::AddString( const char* key, const char* value ) {
+    if( gRecorder.mLog != nullptr )
+        this->mInternals->mFields << " " << key << "=" << value;
+}
+
+void FrameV2::AddDouble( const char* key, double value ) {
+    if( gRecorder.mLog != nullptr )
+        this->mInternals->mFields << " " << key << "=" << value;
+}
+
+void FrameV2::AddInteger( const char* key, S64 value ) {
+    if( gRecorder.mLog != nullptr )
+        this->mInternals->mFields << " " << key << "=" << value;
+}
+
+void FrameV2::AddBoolean( const char* key, bool value ) {
+    if( gRecorder.mLog != nullptr )
+        this->mInternals->mFields << " " << key << "=" << ( value ? "true" : "false" );
+}
+
+void FrameV2::AddByte( const char* key, U8 value ) {
+    if( gRecorder.mLog != nullptr )
+        this->mInternals->mFields << " " << key << "=" << ( U32 )value;
+}
+
+void FrameV2::AddByteArray( const char* key, const U8* data, U64 length ) {
+    if( gRecorder.mLog == nullptr )
+        return;
+    this->mInternals->mFields << " " << key << "=[";
+    for( U64 i = 0; i < length; i++ )
+        this->mInternals->mFields << ( i == 0 ? "" : "," ) << ( U32 )data[ i ];
+    this->mInternals->mFields << "]";
+}
+
+// AnalyzerResults; all analyzer output goes to gRecorder
+
+AnalyzerResults::AnalyzerResults() : mData( nullptr ) {}
+AnalyzerResults::~AnalyzerResults() {}
+
+void AnalyzerResults::AddChannelBubblesWillAppearOn( const Channel& /*channel*/ ) {}
+
+U64 AnalyzerResults::AddFrame( const Frame& frame ) {
+    gRecorder.mFrames.push_back( frame );
+    gRecorder.mUncommitted++;
+    if( gRecorder.mLog != nullptr )
+        fprintf( gRecorder.mLog, "F %lld %lld %llu %llu %u %u\n", ( long long )frame.mStartingSampleInclusive,
+                 ( long long )frame.mEndingSampleInclusive, ( unsigned long long )frame.mData1, ( unsigned long long )frame.mData2,
+                 frame.mType, frame.mFlags );
+    return gRecorder.mFrames.size() - 1;
+}
+
+void AnalyzerResults::AddFrameV2( const FrameV2& frame, const char* type, U64 starting_sample, U64 ending_sample ) {
+    gRecorder.mFramesV2++;
+    gRecorder.mUncommitted++;
+    if( gRecorder.mLog != nullptr )
+        fprintf( gRecorder.mLog, "V %s %llu %llu%s\n", type, ( unsigned long long )starting_sample, ( unsigned long long )ending_sample,
+                 frame.mInternals->mFields.str().c_str() );
+}
+
+U64 AnalyzerResults::CommitPacketAndStartNewPacket() {
+    gRecorder.mPacketFirstFrames.push_back( gRecorder.mFrames.size() );
+    if( gRecorder.mLog != nullptr )
+        fprintf( gRecorder.mLog, "P %llu\n", ( unsigned long long )gRecorder.mFrames.size() );
+    return gRecorder.mPacketFirstFrames.size() - 1;
+}
+
+void AnalyzerResults::CancelPacketAndStartNewPacket() {}
+void AnalyzerResults::AddPacketToTransaction( U64 /*transaction_id*/, U64 /*packet_id*/ ) {}
+
+void AnalyzerResults::AddMarker( U64 sample_number, MarkerType marker_type, Channel& /*channel*/ ) {
+    gRecorder.mMarkers++;
+    gRecorder.mUncommitted++;
+    if( gRecorder.mLog != nullptr )
+        fprintf( gRecorder.mLog, "M %llu %d\n", ( unsigned long long )sample_number, ( int )marker_type );
+}
+
+void AnalyzerResults::CommitResults() {
+    gRecorder.mCommits++;
+    gRecorder.mUncommitted = 0;
+}
+
+U64 AnalyzerResults::GetNumFrames() {
+    return gRecorder.mFrames.size();
+}
+
+U64 AnalyzerResults::GetNumPackets() {
+    return gRecorder.mPacketFirstFrames.size();
+}
+
+Frame AnalyzerResults::GetFrame( U64 frame_id ) {
+    return gRecorder.mFrames.at( frame_id );
+}
+
+U64 AnalyzerResults::GetPacketContainingFrame( U64 frame_id ) {
+    return GetPacketContainingFrameSequential( frame_id );
+}
+
+U64 AnalyzerResults::GetPacketContainingFrameSequential( U64 frame_id ) {
+    const std::vector < U64 >& first = gRecorder.mPacketFirstFrames;
+    // packet is committed after its frames; packet n holds frames [first[n-1], first[n])
+    std::vector < U64 > ::const_iterator it = std::upper_bound( first.begin(), first.end(), frame_id );
+    return it == first.end() ? INVALID_RESULT_INDEX : ( U64 )( it - first.begin() );
+}
+
+void AnalyzerResults::GetFramesContainedInPacket( U64 packet_id, U64* first_frame_id, U64* last_frame_id ) {
+    *first_frame_id = packet_id == 0 ? 0 : gRecorder.mPacketFirstFrames.at( packet_id - 1 );
+    *last_frame_id = gRecorder.mPacketFirstFrames.at( packet_id ) - 1;
+}
+
+void AnalyzerResults::ClearResultStrings() {}
+void AnalyzerResults::AddResultString( const char*, const char*, const char*, const char*, const char*, const char* ) {}
+void AnalyzerResults::ClearTabularText() {}
+void AnalyzerResults::AddTabularText( const char*, const char*, const char*, const char*, const char*, const char* ) {}
+
+bool AnalyzerResults::UpdateExportProgressAndCheckForCancel( U64 /*completed_frames*/, U64 /*total_frames*/ ) {
+    return false;
+}
+
+// settings; interfaces keep their values so that Set/UpdateSettings round trips work
+
+struct AnalyzerSettingInterfaceData
+{
+    Channel mChannel;
+    double mNumber;
+    int mInteger;
+    std::string mText;
+    bool mValue;
+};
+
+AnalyzerSettingInterface::AnalyzerSettingInterface() {
+    this->mData = new AnalyzerSettingInterfaceData();
+}
+
+AnalyzerSettingInterface::~AnalyzerSettingInterface() {
+    delete this->mData;
+}
+
+void* AnalyzerSettingInterface::operator new( size_t size ) {
+    return ::operator new( size );
+}
+
+void AnalyzerSettingInterface::operator delete( void* p ) {
+    ::operator delete( p );
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterface::GetType() {
+    return INTERFACE_BASE;
+}
+
+void AnalyzerSettingInterface::SetTitleAndTooltip( const char* /*title*/, const char* /*tooltip*/ ) {}
+
+AnalyzerSettingInterfaceChannel::AnalyzerSettingInterfaceChannel() {}
+AnalyzerSettingInterfaceChannel::~AnalyzerSettingInterfaceChannel() {}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceChannel::GetType() {
+    return INTERFACE_CHANNEL;
+}
+
+Channel AnalyzerSettingInterfaceChannel::GetChannel() {
+    return this->mData->mChannel;
+}
+
+void AnalyzerSettingInterfaceChannel::SetChannel( const Channel& channel ) {
+    this->mData->mChannel = channel;
+}
+
+void AnalyzerSettingInterfaceChannel::SetSelectionOfNoneIsAllowed( bool /*is_allowed*/ ) {}
+
+AnalyzerSettingInterfaceNumberList::AnalyzerSettingInterfaceNumberList() {}
+AnalyzerSettingInterfaceNumberList::~AnalyzerSettingInterfaceNumberList() {}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceNumberList::GetType() {
+    return INTERFACE_NUMBER_LIST;
+}
+
+double AnalyzerSettingInterfaceNumberList::GetNumber() {
+    return this->mData->mNumber;
+}
+
+void AnalyzerSettingInterfaceNumberList::SetNumber( double number ) {
+    this->mData->mNumber = number;
+}
+
+void AnalyzerSettingInterfaceNumberList::AddNumber( double /*number*/, const char* /*str*/, const char* /*tooltip*/ ) {}
+void AnalyzerSettingInterfaceNumberList::ClearNumbers() {}
+
+AnalyzerSettingInterfaceInteger::AnalyzerSettingInterfaceInteger() {}
+AnalyzerSettingInterfaceInteger::~AnalyzerSettingInterfaceInteger() {}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceInteger::GetType() {
+    return INTERFACE_INTEGER;
+}
+
+int AnalyzerSettingInterfaceInteger::GetInteger() {
+    return this->mData->mInteger;
+}
+
+void AnalyzerSettingInterfaceInteger::SetInteger( int integer ) {
+    this->mData->mInteger = integer;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMax( int /*max*/ ) {}
+void AnalyzerSettingInterfaceInteger::SetMin( int /*min*/ ) {}
+
+AnalyzerSettingInterfaceText::AnalyzerSettingInterfaceText() {}
+AnalyzerSettingInterfaceText::~AnalyzerSettingInterfaceText() {}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceText::GetType() {
+    return INTERFACE_TEXT;
+}
+
+const char* AnalyzerSettingInterfaceText::GetText() {
+    return this->mData->mText.c_str();
+}
+
+void AnalyzerSettingInterfaceText::SetText( const char* text ) {
+    this->mData->mText = text;
+}
+
+void AnalyzerSettingInterfaceText::SetTextType( TextType /*text_type*/ ) {}
+
+AnalyzerSettingInterfaceBool::AnalyzerSettingInterfaceBool() {}
+AnalyzerSettingInterfaceBool::~AnalyzerSettingInterfaceBool() {}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceBool::GetType() {
+    return INTERFACE_BOOL;
+}
+
+bool AnalyzerSettingInterfaceBool::GetValue() {
+    return this->mData->mValue;
+}
+
+void AnalyzerSettingInterfaceBool::SetValue( bool value ) {
+    this->mData->mValue = value;
+}
+
+void AnalyzerSettingInterfaceBool::SetCheckBoxText( const char* /*text*/ ) {}
+
+struct AnalyzerSettingsData
+{
+    std::string mReturnString;
+};
+
+AnalyzerSettings::AnalyzerSettings() {
+    this->mData = new AnalyzerSettingsData();
+}
+
+AnalyzerSettings::~AnalyzerSettings() {
+    delete this->mData;
+}
+
+void AnalyzerSettings::ClearChannels() {}
+void AnalyzerSettings::AddChannel( Channel& /*channel*/, const char* /*channel_label*/, bool /*is_used*/ ) {}
+void AnalyzerSettings::SetErrorText( const char* /*error_text*/ ) {}
+void AnalyzerSettings::AddInterface( AnalyzerSettingInterface* /*analyzer_setting_interface*/ ) {}
+void AnalyzerSettings::AddExportOption( U32 /*user_id*/, const char* /*menu_text*/ ) {}
+void AnalyzerSettings::AddExportExtension( U32 /*user_id*/, const char* /*extension_description*/, const char* /*extension*/ ) {}
+
+const char* AnalyzerSettings::SetReturnString( const char* str ) {
+    this->mData->mReturnString = str;
+    return this->mData->mReturnString.c_str();
+}
+
+// SimulationChannelDescriptor; edges are collected in ReplayChannel
+
+struct SimulationChannelDescriptorData
+{
+    ReplayChannel mChannel;
+    U64 mSample;
+    bool mHigh;
+    U32 mSampleRateHz;
+};
+
+SimulationChannelDescriptor::SimulationChannelDescriptor() {
+    this->mData = new SimulationChannelDescriptorData();
+    this->mData->mSample = 0;
+    this->mData->mHigh = true;
+    this->mData->mSampleRateHz = 0;
+}
+
+SimulationChannelDescriptor::SimulationChannelDescriptor( const SimulationChannelDescriptor& other ) {
+    this->mData = new SimulationChannelDescriptorData( *other.mData );
+}
+
+SimulationChannelDescriptor::~SimulationChannelDescriptor() {
+    delete this->mData;
+}
+
+SimulationChannelDescriptor& SimulationChannelDescriptor::operator=( const SimulationChannelDescriptor& other ) {
+    *this->mData = *other.mData;
+    return *this;
+}
+
+void SimulationChannelDescriptor::Transition() {
+    this->mData->mHigh = !this->mData->mHigh;
+    this->mData->mChannel.mEdges.push_back( this->mData->mSample );
+}
+
+void SimulationChannelDescriptor::TransitionIfNeeded( BitState bit_state ) {
+    if( ( bit_state == BIT_HIGH ) != this->mData->mHigh )
+        Transition();
+}
+
+void SimulationChannelDescriptor::Advance( U32 num_samples_to_advance ) {
+    this->mData->mSample += num_samples_to_advance;
+}
+
+BitState SimulationChannelDescriptor::GetCurrentBitState() {
+    return this->mData->mHigh ? BIT_HIGH : BIT_LOW;
+}
+
+U64 SimulationChannelDescriptor::GetCurrentSampleNumber() {
+    return this->mData->mSample;
+}
+
+void SimulationChannelDescriptor::SetChannel( Channel& /*channel*/ ) {}
+
+void SimulationChannelDescriptor::SetSampleRate( U32 sample_rate_hz ) {
+    this->mData->mSampleRateHz = sample_rate_hz;
+}
+
+void SimulationChannelDescriptor::SetInitialBitState( BitState intial_bit_state ) {
+    this->mData->mHigh = intial_bit_state == BIT_HIGH;
+    this->mData->mChannel.mInitialHigh = this->mData->mHigh;
+}
+
+U32 SimulationChannelDescriptor::GetSampleRate() {
+    return this->mData->mSampleRateHz;
+}
+
+BitState SimulationChannelDescriptor::GetInitialBitState() {
+    return this->mData->mChannel.mInitialHigh ? BIT_HIGH : BIT_LOW;
+}
+
+void* SimulationChannelDescriptor::GetData() {
+    return &this->mData->mChannel;
+}
+
+ReplayChannel Replay::SimulatedChannel( SimulationChannelDescriptor* descriptor ) {
+    ReplayChannel channel = *static_cast < ReplayChannel* >( descriptor->GetData() );
+    channel.mEndSample = descriptor->GetCurrentSampleNumber();
+    return channel;
+}
+
+// AnalyzerHelpers
+
+void AnalyzerHelpers::GetNumberString( U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string,
+                                       U32 result_string_max_length ) {
+    switch( display_base ) {
+        case Decimal:
+            snprintf( result_string, result_string_max_length, "%llu", ( unsigned long long )number );
+            break;
+        case Binary: {
+            std::string bits = "0b";
+            for( U32 i = num_data_bits; i > 0; i-- )
+                bits += ( ( number >> ( i - 1 ) ) & 1 ) ? '1' : '0';
+            snprintf( result_string, result_string_max_length, "%s", bits.c_str() );
+            break;
+        }
+        default:
+            snprintf( result_string, result_string_max_length, "0x%0*llX", ( int )( ( num_data_bits + 3 ) / 4 ), ( unsigned long long )number );
+            break;
+    }
+}
+
+void AnalyzerHelpers::GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length ) {
+    snprintf( result_string, result_string_max_length, "%.9f", ( ( double )sample - ( double )trigger_sample ) / sample_rate_hz );
+}
+
+U64 AnalyzerHelpers::AdjustSimulationTargetSample( U64 target_sample, U32 sample_rate, U32 simulation_sample_rate ) {
+    if( sample_rate == simulation_sample_rate )
+        return target_sample;
+    return ( U64 )( ( double )target_sample * simulation_sample_rate / sample_rate );
+}
+
+// SimpleArchive; values separated by spaces
+
+struct SimpleArchiveData
+{
+    std::string mText;
+    std::istringstream mInput;
+};
+
+SimpleArchive::SimpleArchive() {
+    this->mData = new SimpleArchiveData();
+}
+
+SimpleArchive::~SimpleArchive() {
+    delete this->mData;
+}
+
+void SimpleArchive::SetString( const char* archive_string ) {
+    this->mData->mText = archive_string;
+    this->mData->mInput.str( archive_string );
+    this->mData->mInput.clear();
+}
+
+const char* SimpleArchive::GetString() {
+    return this->mData->mText.c_str();
+}
+
+namespace
+{
+    template < class T >
+    bool Write( SimpleArchiveData* data, const T& value ) {
+        std::ostringstream out;
+        out.precision( 17 );
+        out << value << " ";
+        data->mText += out.str();
+        return true;
+    }
+
+    template < class T >
+    bool Read( SimpleArchiveData* data, T& value ) {
+        return ( bool )( data->mInput >> value );
+    }
+}
+
+bool SimpleArchive::operator<<( U64 data ) { return Write( this->mData, data ); }
+bool SimpleArchive::operator<<( U32 data ) { return Write( this->mData, data ); }
+bool SimpleArchive::operator<<( S64 data ) { return Write( this->mData, data ); }
+bool SimpleArchive::operator<<( S32 data ) { return Write( this->mData, data ); }
+bool SimpleArchive::operator<<( double data ) { return Write( this->mData, data ); }
+bool SimpleArchive::operator<<( bool data ) { return Write( this->mData, data ); }
+bool SimpleArchive::operator<<( const char* data ) { return Write( this->mData, data ); }
+bool SimpleArchive::operator<<( Channel& data ) { return Write( this->mData, data.mChannelIndex ); }
+bool SimpleArchive::operator>>( U64& data ) { return Read( this->mData, data ); }
+bool SimpleArchive::operator>>( U32& data ) { return Read( this->mData, data ); }
+bool SimpleArchive::operator>>( S64& data ) { return Read( this->mData, data ); }
+bool SimpleArchive::operator>>( S32& data ) { return Read( this->mData, data ); }
+bool SimpleArchive::operator>>( double& data ) { return Read( this->mData, data ); }
+bool SimpleArchive::operator>>( bool& data ) { return Read( this->mData, data ); }
+bool SimpleArchive::operator>>( char const ** /*data*/ ) { return false; }
+bool SimpleArchive::operator>>( Channel& data ) { return Read( this->mData, data.mChannelIndex ); }
@@ -0,0 +1,295 @@
+// headless end-to-end run of MELIBUAnalyzer (unchanged WorkerThread) over a recorded edge list or the simulation output;
+// analyzer links against AnalyzerSdkStandIns.cpp instead of the SDK library
+// reports decode time per captured second and number of created results, e.g. to compare performance of two builds
+
+#include "MELIBUAnalyzer.h"
+#include "MELIBUAnalyzerSettings.h"
+#include "ReplayCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    class ReplayAnalyzer: public MELIBUAnalyzer
+    {
+     public:
+        MELIBUAnalyzerSettings* Settings() {
+            return this->mSettings.get();
+        }
+
+        MELIBUAnalyzerResults* Results() {
+            return this->mResults.get();
+        }
+
+        U32 DetectedBitRate() {
+            return this->mDetectedBitRate;
+        }
+    };
+
+    struct ReplayOptions
+    {
+        ReplayOptions()
+            :   mEdgeFile( nullptr ),
+            mSimulateSeconds( 0 ),
+            mSaveEdgeFile( nullptr ),
+            mLogFile( nullptr ),
+            mExportFile( nullptr ),
+            mRepeat( 1 ),
+            mSampleRateHz( 10000000 ),
+            mBitRate( 1000000 ),
+            mAutoBitRate( false ),
+            mVersion( 2.0 ),
+            mACK( false ),
+            mACKValue( 0x7E ),
+            mByteDecoder( 0 ),
+            mMarkerLevel( 0 ),
+            mCommitPolicy( 0 ),
+            mDecodeMode( 0 ),
+            mExportFormat( 0 ),
+            mStatisticsInterval( 0 ),
+            mSignalLayoutFile( "" ),
+            mTableRows( 0 ),
+            mSimulationSource( 0 ),
+            mBusLoad( 50 ),
+            mFaults( 0 ) {}
+
+        const char* mEdgeFile;
+        std::vector < const char* > mBusEdgeFiles; // buses 2 and up
+        double mSimulateSeconds;
+        const char* mSaveEdgeFile;
+        const char* mLogFile;
+        const char* mExportFile;
+        U32 mRepeat;
+        U32 mSampleRateHz;
+        U32 mBitRate;
+        bool mAutoBitRate;
+        double mVersion;
+        bool mACK;
+        int mACKValue;
+        U32 mByteDecoder;
+        U32 mMarkerLevel;
+        U32 mCommitPolicy;
+        U32 mDecodeMode;
+        U32 mExportFormat;
+        U32 mStatisticsInterval;
+        const char* mSignalLayoutFile;
+        U32 mTableRows;
+        U32 mSimulationSource;
+        int mBusLoad;
+        int mFaults;
+    };
+
+    void Usage() {
+        fprintf( stderr,
+                 "usage: MELIBUReplay (--edges <file> | --simulate <seconds>) [options]\n"
+                 "  --edges <file>        edge list: \"<initial level> <end sample> <count>\" followed by edge sample numbers\n"
+                 "  --simulate <seconds>  use analyzer simulation (reads simulated_data.csv from working directory)\n"
+                 "  --synthetic <load %%>  simulate random traffic (MELIBUTrafficGenerator) at bus load instead of csv messages\n"
+                 "  --faults <%%>          share of synthetic messages with crc, framing or missing byte fault\n"
+                 "  --bus-edges <file>    edge list of one more bus (channel 1, 2, ...); repeat for up to 7 buses\n"
+                 "  --save-edges <file>   write replayed channel as edge list\n"
+                 "  --sample-rate <Hz>    default 10000000\n"
+                 "  --bit-rate <bit/s>    default 1000000\n"
+                 "  --auto-bit-rate <0|1> detect bit rate from start of capture; --bit-rate is used for simulation and as fallback\n"
+                 "  --version <1.0|1.1|2.0>\n"
+                 "  --ack <value>         enable ack with value (MeLiBu 2)\n"
+                 "  --byte-decoder <n>    0 sampling, 1 edges, 2 edge tracking\n"
+                 "  --markers <n>         0 all bits, 1 start/stop, 2 errors only\n"
+                 "  --commit-policy <n>   0 live, 1 throughput\n"
+                 "  --decode-mode <n>     0 sequential, 1 parallel segments\n"
+                 "  --repeat <n>          decode n times, report best and mean time\n"
+                 "  --log <file>          write every frame, FrameV2 row, marker and packet as text\n"
+                 "  --export <file>       run export after decoding\n"
+                 "  --export-format <n>   0 bytes, 1 messages, 2 statistics\n"
+                 "  --statistics <ms>     add statistics row every <ms> of capture time (100, 1000 or 10000)\n"
+                 "  --signal-layout <file> add signal rows from layout written by mbdf_to_layout.py\n"
+                 "  --table-rows <n>      0 byte rows, 1 packet rows, 2 both\n" );
+    }
+
+    bool ParseOptions( int argc, char** argv, ReplayOptions& options ) {
+        for( int i = 1; i < argc; i++ ) {
+            const char* name = argv[ i ];
+            if( i + 1 >= argc )
+                return false;
+            const char* value = argv[ ++i ];
+            if( strcmp( name, "--edges" ) == 0 )
+                options.mEdgeFile = value;
+            else if( strcmp( name, "--simulate" ) == 0 )
+                options.mSimulateSeconds = atof( value );
+            else if( strcmp( name, "--synthetic" ) == 0 ) {
+                options.mSimulationSource = MELIBUSimulationDataGenerator::simulationSynthetic;
+                options.mBusLoad = atoi( value );
+            } else if( strcmp( name, "--faults" ) == 0 )
+                options.mFaults = atoi( value );
+            else if( strcmp( name, "--bus-edges" ) == 0 && options.mBusEdgeFiles.size() + 1 < MELIBUAnalyzerSettings::MaxBuses )
+                options.mBusEdgeFiles.push_back( value );
+            else if( strcmp( name, "--save-edges" ) == 0 )
+                options.mSaveEdgeFile = value;
+            else if( strcmp( name, "--sample-rate" ) == 0 )
+                options.mSampleRateHz = ( U32 )atol( value );
+            else if( strcmp( name, "--bit-rate" ) == 0 )
+                options.mBitRate = ( U32 )atol( value );
+            else if( strcmp( name, "--auto-bit-rate" ) == 0 )
+                options.mAutoBitRate = atoi( value ) != 0;
+            else if( strcmp( name, "--version" ) == 0 )
+                options.mVersion = atof( value );
+            else if( strcmp( name, "--ack" ) == 0 ) {
+                options.mACK = true;
+                options.mACKValue = ( int )strtol( value, nullptr, 0 );
+            } else if( strcmp( name, "--byte-decoder" ) == 0 )
+                options.mByteDecoder = ( U32 )atol( value );
+            else if( strcmp( name, "--markers" ) == 0 )
+                options.mMarkerLevel = ( U32 )atol( value );
+            else if( strcmp( name, "--commit-policy" ) == 0 )
+                options.mCommitPolicy = ( U32 )atol( value );
+            else if( strcmp( name, "--decode-mode" ) == 0 )
+                options.mDecodeMode = ( U32 )atol( value );
+            else if( strcmp( name, "--repeat" ) == 0 )
+                options.mRepeat = std::max( 1, atoi( value ) );
+            else if( strcmp( name, "--log" ) == 0 )
+                options.mLogFile = value;
+            else if( strcmp( name, "--export" ) == 0 )
+                options.mExportFile = value;
+            else if( strcmp( name, "--export-format" ) == 0 )
+                options.mExportFormat = ( U32 )atol( value );
+            else if( strcmp( name, "--statistics" ) == 0 )
+                options.mStatisticsInterval = ( U32 )atol( value );
+            else if( strcmp( name, "--signal-layout" ) == 0 )
+                options.mSignalLayoutFile = value;
+            else if( strcmp( name, "--table-rows" ) == 0 )
+                options.mTableRows = ( U32 )atol( value );
+            else
+                return false;
+        }
+        return ( options.mEdgeFile != nullptr ) != ( options.mSimulateSeconds > 0 );
+    }
+
+    bool ApplySettings( ReplayAnalyzer& analyzer, const ReplayOptions& options ) {
+        MELIBUAnalyzerSettings* settings = analyzer.Settings();
+        settings->mInputChannel = Channel( 0, 0 );
+        for( size_t i = 0; i < options.mBusEdgeFiles.size(); i++ )
+            settings->mBusChannels[ i ] = Channel( 0, ( U32 )i + 1 );
+        settings->mBitRate = options.mBitRate;
+        settings->mAutoBitRate = options.mAutoBitRate;
+        settings->mMELIBUVersion = options.mVersion;
+        settings->mACK = options.mACK;
+        settings->mACKValue = options.mACKValue;
+        settings->mByteDecoder = options.mByteDecoder;
+        settings->mMarkerLevel = options.mMarkerLevel;
+        settings->mCommitPolicy = options.mCommitPolicy;
+        settings->mDecodeMode = options.mDecodeMode;
+        settings->mExportFormat = options.mExportFormat;
+        settings->mStatisticsInterval = options.mStatisticsInterval;
+        settings->mSimulationSource = options.mSimulationSource;
+        settings->mSimulationBusLoad = options.mBusLoad;
+        settings->mSimulationFaults = options.mFaults;
+        settings->mSignalLayoutFile = options.mSignalLayoutFile;
+        settings->mTableRows = options.mTableRows;
+        std::string error;
+        if( !settings->LoadSignalLayout( error ) ) {
+            fprintf( stderr, "%s\n", error.c_str() );
+            return false;
+        }
+        return true;
+    }
+}
+
+int main( int argc, char** argv ) {
+    ReplayOptions options;
+    if( !ParseOptions( argc, argv, options ) ) {
+        Usage();
+        return 2;
+    }
+
+    Replay::gCapture.mSampleRateHz = options.mSampleRateHz;
+    ReplayChannel& channel = Replay::gCapture.mChannels[ 0 ];
+    if( options.mEdgeFile != nullptr ) {
+        if( !Replay::LoadEdges( options.mEdgeFile, channel ) ) {
+            fprintf( stderr, "can't read edge list %s\n", options.mEdgeFile );
+            return 1;
+        }
+    } else {
+        ReplayAnalyzer simulation;
+        if( !ApplySettings( simulation, options ) )
+            return 1;
+        SimulationChannelDescriptor* descriptor = nullptr;
+        U64 end_sample = ( U64 )( options.mSimulateSeconds * options.mSampleRateHz );
+        simulation.GenerateSimulationData( end_sample, options.mSampleRateHz, &descriptor );
+        channel = Replay::SimulatedChannel( descriptor );
+        if( channel.mEdges.empty() ) {
+            fprintf( stderr, "simulation produced no data (simulated_data.csv not found?)\n" );
+            return 1;
+        }
+    }
+    for( size_t i = 0; i < options.mBusEdgeFiles.size(); i++ ) {
+        if( !Replay::LoadEdges( options.mBusEdgeFiles[ i ], Replay::gCapture.mChannels[ ( U32 )i + 1 ] ) ) {
+            fprintf( stderr, "can't read edge list %s\n", options.mBusEdgeFiles[ i ] );
+            return 1;
+        }
+    }
+    if( options.mSaveEdgeFile != nullptr && !Replay::SaveEdges( options.mSaveEdgeFile, channel ) ) {
+        fprintf( stderr, "can't write edge list %s\n", options.mSaveEdgeFile );
+        return 1;
+    }
+
+    double best = 0, total = 0;
+    U32 detected_bit_rate = 0;
+    for( U32 run = 0; run < options.mRepeat; run++ ) {
+        // log only first run; same results are produced every time
+        FILE* log = nullptr;
+        if( run == 0 && options.mLogFile != nullptr )
+            log = fopen( options.mLogFile, "w" );
+
+        ReplayAnalyzer analyzer;
+        if( !ApplySettings( analyzer, options ) )
+            return 1;
+        Replay::gRecorder = ReplayRecorder();
+        Replay::gRecorder.mLog = log;
+        analyzer.SetupResults();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        try {
+            analyzer.WorkerThread();
+        } catch( ReplayEndOfCapture& ) {}
+        double seconds = std::chrono::duration < double >( std::chrono::steady_clock::now() - start ).count();
+
+        detected_bit_rate = analyzer.DetectedBitRate();
+        best = run == 0 ? seconds : std::min( best, seconds );
+        total += seconds;
+        if( log != nullptr )
+            fclose( log );
+        Replay::gRecorder.mLog = nullptr;
+
+        if( run + 1 == options.mRepeat && options.mExportFile != nullptr ) {
+            start = std::chrono::steady_clock::now();
+            analyzer.Results()->GenerateExportFile( options.mExportFile, Hexadecimal, 0 );
+            printf( "export:             %.3f ms\n", std::chrono::duration < double >( std::chrono::steady_clock::now() - start ).count() * 1e3 );
+        }
+    }
+
+    const ReplayRecorder& recorder = Replay::gRecorder;
+    double captured_seconds = ( double )channel.mEndSample / options.mSampleRateHz;
+    U64 edges = 0;
+    for( const auto& bus : Replay::gCapture.mChannels )
+        edges += bus.second.mEdges.size();
+    printf( "captured:           %.6f s, %llu edges\n", captured_seconds, ( unsigned long long )edges );
+    if( Replay::gCapture.mChannels.size() > 1 )
+        printf( "buses:              %u\n", ( U32 )Replay::gCapture.mChannels.size() );
+    if( options.mAutoBitRate )
+        printf( "bit rate:           %u bit/s %s\n", detected_bit_rate != 0 ? detected_bit_rate : options.mBitRate,
+                detected_bit_rate != 0 ? "(detected)" : "(not detected, using --bit-rate)" );
+    printf( "decode (best):      %.3f ms, %.3f ms per captured second\n", best * 1e3, best * 1e3 / captured_seconds );
+    printf( "decode (mean):      %.3f ms over %u runs\n", total * 1e3 / options.mRepeat, options.mRepeat );
+    printf( "frames:             %llu\n", ( unsigned long long )recorder.mFrames.size() );
+    printf( "FrameV2 rows:       %llu\n", ( unsigned long long )recorder.mFramesV2 );
+    printf( "markers:            %llu\n", ( unsigned long long )recorder.mMarkers );
+    printf( "packets:            %llu\n", ( unsigned long long )recorder.mPacketFirstFrames.size() );
+    printf( "commits:            %llu\n", ( unsigned long long )recorder.mCommits );
+    printf( "uncommitted:        %llu\n", ( unsigned long long )recorder.mUncommitted );
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef MELIBU_REPLAY_CAPTURE_H
+#define MELIBU_REPLAY_CAPTURE_H
+
+#include <AnalyzerResults.h>
+#include <SimulationChannelDescriptor.h>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// state behind the Analyzer SDK stand-ins (AnalyzerSdkStandIns.cpp)
+// analyzer sees one captured channel per channel index; everything it adds to results is counted in ReplayRecorder
+
+// thrown by AnalyzerChannelData when analyzer reads past end of captured data; in Logic the worker thread would be stopped here
+struct ReplayEndOfCapture
+{
+};
+
+// digital channel as sorted edge positions
+struct ReplayChannel
+{
+    ReplayChannel() : mInitialHigh( true ), mEndSample( 0 ) {}
+
+    bool mInitialHigh;
+    std::vector < U64 > mEdges;
+    U64 mEndSample; // first sample after captured data
+};
+
+struct ReplayCapture
+{
+    ReplayCapture() : mSampleRateHz( 0 ) {}
+
+    U32 mSampleRateHz;
+    std::map < U32, ReplayChannel > mChannels; // channel index -> data
+};
+
+struct ReplayRecorder
+{
+    ReplayRecorder() : mFramesV2( 0 ), mMarkers( 0 ), mCommits( 0 ), mUncommitted( 0 ), mProgressReports( 0 ), mLog( nullptr ) {}
+
+    std::vector < Frame > mFrames;
+    std::vector < U64 > mPacketFirstFrames;
+    U64 mFramesV2;
+    U64 mMarkers;
+    U64 mCommits;
+    U64 mUncommitted; // frames, rows and markers added after last commit; Logic would never show them
+    U64 mProgressReports;
+    FILE* mLog; // if set, every result is written as one text line (for diffing outputs of two builds)
+};
+
+namespace Replay
+{
+    extern ReplayCapture gCapture;
+    extern ReplayRecorder gRecorder;
+
+    // edge file: "<initial level 0/1> <end sample> <number of edges>" followed by edge sample numbers
+    bool LoadEdges( const char* file_name, ReplayChannel& channel );
+    bool SaveEdges( const char* file_name, const ReplayChannel& channel );
+
+    // channel produced by analyzer simulation; descriptor must come from GenerateSimulationData
+    ReplayChannel SimulatedChannel( SimulationChannelDescriptor* descriptor );
+}
+
+#endif //MELIBU_REPLAY_CAPTURE_H
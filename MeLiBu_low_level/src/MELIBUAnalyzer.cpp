@@ -1,19 +1,94 @@
 #include "MELIBUAnalyzer.h"
 #include "MELIBUAnalyzerSettings.h"
+#include "MELIBUBufferedChannel.h"
+#include "MELIBUMultiBusDecoder.h"
+#include "MELIBUSegmentDecoder.h"
+#include "MELIBUWorkerPool.h"
+#include "MELIBUInstrumentation.h"
 #include <AnalyzerChannelData.h>
-#include <math.h>
-#include <bitset>
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 #include <string>
-#include <iomanip>
+#include <thread>
+
+MELIBUAnalyzerChannel::MELIBUAnalyzerChannel( AnalyzerChannelData* channel_data, MELIBUDecoderListener* idle_listener )
+    :   mChannelData( channel_data ),
+    mIdleListener( idle_listener ),
+    mCapturedUntil( 0 ) {}
+
+MELIBUAnalyzerChannel::~MELIBUAnalyzerChannel() {}
+
+U64 MELIBUAnalyzerChannel::GetSampleNumber() {
+    return this->mChannelData->GetSampleNumber();
+}
+
+bool MELIBUAnalyzerChannel::IsHigh() {
+    return this->mChannelData->GetBitState() == BIT_HIGH;
+}
+
+// Logic blocks reads past captured data until more data arrives, at end of a finished capture forever
+// listener finishes its output before; reads up to a known edge are skipped without asking channel data
+void MELIBUAnalyzerChannel::BeforeRead( U64 sample_number ) {
+    if( this->mIdleListener == nullptr || sample_number < this->mCapturedUntil )
+        return;
+    if( this->mChannelData->DoMoreTransitionsExistInCurrentData() )
+        this->mCapturedUntil = this->mChannelData->GetSampleOfNextEdge();
+    else
+        this->mIdleListener->OnIdle( this->mChannelData->GetSampleNumber() );
+}
+
+U32 MELIBUAnalyzerChannel::Advance( U32 num_samples ) {
+    BeforeRead( this->mChannelData->GetSampleNumber() + num_samples );
+    U32 transitions = this->mChannelData->Advance( num_samples );
+    MELIBU_COUNT( counterChannelCalls, 1 );
+    MELIBU_COUNT( counterEdges, transitions );
+    return transitions;
+}
+
+U32 MELIBUAnalyzerChannel::AdvanceToAbsPosition( U64 sample_number ) {
+    BeforeRead( sample_number );
+    U32 transitions = this->mChannelData->AdvanceToAbsPosition( sample_number );
+    MELIBU_COUNT( counterChannelCalls, 1 );
+    MELIBU_COUNT( counterEdges, transitions );
+    return transitions;
+}
+
+void MELIBUAnalyzerChannel::AdvanceToNextEdge() {
+    BeforeRead( this->mChannelData->GetSampleNumber() + 1 );
+    this->mChannelData->AdvanceToNextEdge();
+    MELIBU_COUNT( counterChannelCalls, 1 );
+    MELIBU_COUNT( counterEdges, 1 );
+}
+
+U64 MELIBUAnalyzerChannel::GetSampleOfNextEdge() {
+    BeforeRead( this->mChannelData->GetSampleNumber() + 1 );
+    return this->mChannelData->GetSampleOfNextEdge();
+}
+
+bool MELIBUAnalyzerChannel::WouldAdvancingCauseTransition( U32 num_samples ) {
+    BeforeRead( this->mChannelData->GetSampleNumber() + num_samples );
+    return this->mChannelData->WouldAdvancingCauseTransition( num_samples );
+}
+
+// channel data of running capture never ends; worker thread is stopped by Logic application
+bool MELIBUAnalyzerChannel::AtEnd() {
+    return false;
+}
+
+bool MELIBUAnalyzerChannel::MoreEdgesAvailable() {
+    return this->mChannelData->DoMoreTransitionsExistInCurrentData();
+}
 
 // add only initialization of new variables
 MELIBUAnalyzer::MELIBUAnalyzer()
     :   Analyzer2(),
     mSettings( new MELIBUAnalyzerSettings() ),
     mSimulationInitilized( false ),
-    mFrameState( MELIBUAnalyzerResults::NoFrame ) {
+    mDetectedBitRate( 0 ),
+    mBus( 0 ),
+    mStatistics( nullptr ),
+    mStatisticsRowSamples( 0 ),
+    mLastSample( 0 ) {
     // don't change
     SetAnalyzerSettings( mSettings.get() );
     UseFrameV2();
@@ -26,158 +101,96 @@ MELIBUAnalyzer::~MELIBUAnalyzer() {
 void MELIBUAnalyzer::SetupResults() {
     this->mResults.reset( new MELIBUAnalyzerResults( this, this->mSettings.get() ) );
     SetAnalyzerResults( this->mResults.get() );
-    this->mResults->AddChannelBubblesWillAppearOn( this->mSettings->mInputChannel );
+    for( const auto& channel : this->mSettings->BusChannels() )
+        this->mResults->AddChannelBubblesWillAppearOn( channel );
 }
 
 void MELIBUAnalyzer::WorkerThread() {
-    this->mFrameState = MELIBUAnalyzerResults::NoFrame; // initialize frame state
-
-    U8 nDataBytes { 0 };                           // number of data in message
-    bool byteFramingError { false };
-    Frame byteFrame; // byte frame from start to stop bit
-    Frame ibsFrame;  // inter byte space frame
-    bool is_data_really_break { false }; // for break field found with ByteFrame function
-    bool ready_to_save { false };
-    bool is_start_of_packet { false };
-
-    U8 id[] { 0, 0 }; // header id values
-    U16 crc { 0 };               // crc value read from crc byte fields
-    U8 ack_value = this->mSettings->mMELIBUVersion == 2.0 ? this->mSettings->mACKValue : 0x7E;
-
-    ibsFrame.mData1 = 0;
-    ibsFrame.mData2 = 0;
-    ibsFrame.mFlags = 0;
-    ibsFrame.mType = 0;
+#ifdef MELIBU_INSTRUMENTATION
+    MELIBUInstrumentation::Reset();
+#endif
+    MELIBUDecoderSettings settings;
+    settings.mSampleRateHz = GetSampleRate();
+    settings.mBitRate = this->mSettings->mBitRate;
+    settings.mMELIBUVersion = this->mSettings->mMELIBUVersion;
+    settings.mACK = this->mSettings->mACK;
+    settings.mACKValue = this->mSettings->mACKValue;
+    settings.mByteDecoder = this->mSettings->mByteDecoder;
+    settings.mMarkerLevel = this->mSettings->mMarkerLevel;
+
+    this->mBusChannels = this->mSettings->BusChannels();
+    this->mBus = 0;
     this->mSerial = GetAnalyzerChannelData( this->mSettings->mInputChannel );
+    // multi-bus decoder reads all buses itself and reports idle when none has more captured edges
+    MELIBUAnalyzerChannel analyzer_channel( this->mSerial, this->mBusChannels.size() == 1 ? this : nullptr );
+    MELIBUChannel* channel = &analyzer_channel;
+
+    // bit rate detection reads start of capture; it is decoded again from recorded edges
+    // with several buses, bit rate of first bus is used for all of them
+    MELIBUBitRateDetector detector;
+    std::unique_ptr < MELIBUBufferedChannel > buffered_channel;
+    this->mDetectedBitRate = 0;
+    if( this->mSettings->mAutoBitRate ) {
+        detector.Record( &analyzer_channel );
+        this->mDetectedBitRate = detector.Detect( settings.mSampleRateHz );
+        if( this->mDetectedBitRate != 0 )
+            settings.mBitRate = this->mDetectedBitRate;
+        buffered_channel.reset( new MELIBUBufferedChannel( &analyzer_channel, detector.Edges(), detector.InitialHigh(), detector.StartSample() ) );
+        channel = buffered_channel.get();
+    }
 
-    if( this->mSerial->GetBitState() == BIT_LOW )
-        this->mSerial->AdvanceToNextEdge();
+    this->mCommitScheduler.Setup( this->mSettings->mCommitPolicy, settings.mSampleRateHz );
+
+    // statistics are always counted for export; summary rows are optional
+    U32 interval_ms = this->mSettings->mStatisticsInterval != 0 ? this->mSettings->mStatisticsInterval : ( U32 )DefaultStatisticsIntervalMs;
+    U64 interval_samples = std::max < U64 >( 1, ( U64 )settings.mSampleRateHz * interval_ms / 1000 );
+    this->mStatistics = &this->mResults->Statistics();
+    this->mStatistics->Setup( settings.mSampleRateHz, settings.mBitRate, interval_samples, ( U32 )this->mBusChannels.size() );
+    this->mStatisticsRowSamples = this->mSettings->mStatisticsInterval != 0 ? interval_samples : 0;
+    this->mLastSample = 0;
+    this->mSignalLayout = this->mSettings->mSignalLayout;
+    this->mSampleRateHz = settings.mSampleRateHz;
+    this->mBitRate = settings.mBitRate;
+#ifdef MELIBU_INSTRUMENTATION
+    MELIBUInstrumentation::ExitReport exit_report( &this->mLastSample, settings.mSampleRateHz );
+#endif
 
     this->mResults->CancelPacketAndStartNewPacket();
+    if( this->mSettings->mAutoBitRate && !detector.Edges().empty() ) {
+        // table row with bit rate used for decoding
+        FrameV2 frame_v2;
+        frame_v2.AddInteger( "bit_rate", settings.mBitRate );
+        frame_v2.AddBoolean( "detected", this->mDetectedBitRate != 0 );
+        this->mResults->AddFrameV2( frame_v2, "bit_rate", detector.Edges().front(), detector.Edges().front() );
+        MELIBU_COUNT( counterFramesV2, 1 );
+    }
 
-    for( ; ; ) {
-        ReadFrame( byteFrame, ibsFrame, is_data_really_break, byteFramingError ); // read byte frame or header break
-        AddToCrc( byteFrame );
-
-        if( is_data_really_break ) // break field found insted of byte frame; this is not regular situation
-            AddMissingByteFrame( ibsFrame );
-
-        is_start_of_packet = false;
-        ready_to_save = false;
-
-        // in each case set mFrameState for next iteration
-        switch( this->mFrameState ) {
-            case MELIBUAnalyzerResults::NoFrame:
-            case MELIBUAnalyzerResults::headerBreak:
-
-                if( byteFrame.mData1 == 0x00 ) {
-                    this->mFrameState = MELIBUAnalyzerResults::headerID1;
-                    byteFrame.mType = MELIBUAnalyzerResults::headerBreak;
-                    is_start_of_packet = true;
-                    this->mCRC.clear(); // reset crc
-                } else { // reset
-                    byteFrame.mFlags |= MELIBUAnalyzerResults::headerBreakExpected;
-                    this->mFrameState = MELIBUAnalyzerResults::NoFrame;
-                }
-                break;
-
-            case MELIBUAnalyzerResults::headerID1:
-
-                this->mFrameState = MELIBUAnalyzerResults::headerID2;
-                id[0] = byteFrame.mData1; // save byte value to id1
-                break;
-
-            case MELIBUAnalyzerResults::headerID2:
-
-                id[1] = byteFrame.mData1; // save byte value to id2
-                nDataBytes = NumberOfDataBytes( id[ 0 ], id[1] );
-
-                if( nDataBytes == 0 )
-                    this->mFrameState = MELIBUAnalyzerResults::responseCRC1;
-                else
-                    this->mFrameState = MELIBUAnalyzerResults::responseDataZero;
-                // if instruction bit is set read two bytes for instruction; only possible for MELIBU 2
-                if( this->mSettings->mMELIBUVersion == 2.0 && ( id[1] & 0x04 ) != 0 )
-                    this->mFrameState = MELIBUAnalyzerResults::instruction1;
-                break;
-
-            case MELIBUAnalyzerResults::instruction1:
-
-                this->mFrameState = MELIBUAnalyzerResults::instruction2;
-                break;
-
-            case MELIBUAnalyzerResults::instruction2:
-
-                if(nDataBytes == 0)
-                    this->mFrameState = MELIBUAnalyzerResults::responseCRC1;
-                else
-                    this->mFrameState = MELIBUAnalyzerResults::responseDataZero;
-                break;
-
-            case MELIBUAnalyzerResults::responseDataZero:
-
-                this->mFrameState = MELIBUAnalyzerResults::responseData;
-                nDataBytes--;
-                break;
-
-            case MELIBUAnalyzerResults::responseData:
-
-                // if all data bytes are read, read response crc 1 field next
-                if(nDataBytes == 1)
-                    this->mFrameState = MELIBUAnalyzerResults::responseCRC1;
-                nDataBytes--;
-                break;
-
-            case MELIBUAnalyzerResults::responseCRC1:
-
-                this->mFrameState = MELIBUAnalyzerResults::responseCRC2;
-                CrcFrameValue( crc, byteFrame.mData1, 0 );
-                break;
-
-            case MELIBUAnalyzerResults::responseCRC2:
-            {
-                bool ack = SendAckByte( id[ 0 ], id[ 1 ] );
-                this->mFrameState = ack ? MELIBUAnalyzerResults::responseACK : MELIBUAnalyzerResults::NoFrame;
-                ready_to_save = !ack; // if we need to read ack byte data is not ready for saving
-                CrcFrameValue( crc, byteFrame.mData1, 1 );
-
-                if( this->mCRC.result() != crc ) { // add flag if calculated crc is not the same as read crc
-                    byteFrame.mFlags |= MELIBUAnalyzerResults::crcMismatch;
-                    this->mResults->AddMarker( mSerial->GetSampleNumber(),
-                                               AnalyzerResults::ErrorSquare,
-                                               this->mSettings->mInputChannel );
-                }
-                break;
-            }
-            case MELIBUAnalyzerResults::responseACK:
-
-                this->mFrameState = MELIBUAnalyzerResults::NoFrame;
-                if( byteFrame.mData1 != ack_value ) { // add marker is ack value is not 0x7E (0x7E means that reception of the frame was OK)
-                    this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                               AnalyzerResults::ErrorSquare,
-                                               this->mSettings->mInputChannel );
-                    byteFrame.mFlags |= MELIBUAnalyzerResults::receptionFailed;
-                }
-                nDataBytes = 0;
-                ready_to_save = true;
-                break;
-
-        }
-
-        byteFrame.mData2 = NumberOfDataBytes( id[0], id[1] ) - nDataBytes; // number of data in message
-
-        if( is_start_of_packet )
-            this->mResults->CommitPacketAndStartNewPacket(); // commit previous packet
-
-        this->mResults->AddFrame( byteFrame ); // add frame to graph view
-        AddFrameToTable( byteFrame );      // add frame to tabular view
-
-        if( ready_to_save )
-            this->mResults->CommitPacketAndStartNewPacket();
-
-        this->mResults->CommitResults();
-        ReportProgress( byteFrame.mEndingSampleInclusive );
+    if( this->mBusChannels.size() == 1 && this->mSettings->mDecodeMode == MELIBUSegmentDecoder::decodeSegments ) {
+        // data captured so far is decoded in parallel segments; data that arrives later is decoded as it comes
+        MELIBUWorkerPool pool;
+        MELIBUSegmentDecoder decoder( this, &pool );
+        decoder.Setup( settings );
+        decoder.Decode( channel );
+    } else if( this->mBusChannels.size() == 1 ) {
+        // protocol state machine is in MELIBUDecoder; its output is received in On... functions
+        MELIBUDecoder decoder( channel, this );
+        decoder.Setup( settings );
+        decoder.Decode();
+    } else {
+        // one decoder per bus, decoded in parallel; output of all buses is received in this thread in sample order
+        std::vector < MELIBUAnalyzerChannel > bus_data;
+        for( size_t i = 1; i < this->mBusChannels.size(); i++ )
+            bus_data.push_back( MELIBUAnalyzerChannel( GetAnalyzerChannelData( this->mBusChannels[ i ] ) ) );
+        std::vector < MELIBUChannel* > channels( 1, channel );
+        for( auto& data : bus_data )
+            channels.push_back( &data );
+
+        MELIBUWorkerPool pool( std::min( ( U32 )channels.size(), std::max( 1U, std::thread::hardware_concurrency() ) ) );
+        MELIBUMultiBusDecoder decoder( this, &pool );
+        decoder.Setup( settings, channels, std::max( 1U, settings.mSampleRateHz / BusWindowsPerSecond ) );
+        decoder.Decode();
     }
+    this->mResults->CommitResults(); // commit rest of results if decoder stopped at end of data
 }
 
 // not in use
@@ -185,364 +198,238 @@ bool MELIBUAnalyzer::NeedsRerun() {
     return false;
 }
 
-inline double MELIBUAnalyzer::SamplesPerBit() {
-    return ( double )GetSampleRate() / ( double )this->mSettings->mBitRate;
+void MELIBUAnalyzer::OnBus( U8 bus ) {
+    this->mBus = bus;
 }
 
-double MELIBUAnalyzer::HalfSamplesPerBit() {
-    return SamplesPerBit() * 0.5;
+void MELIBUAnalyzer::OnMarker( U64 sample_number, U8 marker ) {
+    MELIBU_TIME( timerResults );
+    MELIBU_COUNT( counterMarkers, 1 );
+    static const AnalyzerResults::MarkerType marker_types[] = {
+        AnalyzerResults::Start,    // markerStart
+        AnalyzerResults::Stop,     // markerStop
+        AnalyzerResults::One,      // markerOne
+        AnalyzerResults::Zero,     // markerZero
+        AnalyzerResults::ErrorDot, // markerErrorDot
+        AnalyzerResults::ErrorSquare, // markerErrorSquare
+        AnalyzerResults::ErrorX    // markerErrorX
+    };
+    this->mResults->AddMarker( sample_number, marker_types[ marker ], this->mBusChannels[ this->mBus ] );
+    this->mCommitScheduler.AddMarker();
 }
 
-void MELIBUAnalyzer::AdvanceHalfBit() {
-    double numOfSamples = HalfSamplesPerBit();
-    this->mSerial->Advance( numOfSamples );
+void MELIBUAnalyzer::OnByte( const MELIBUByteRecord& byte ) {
+    MELIBU_TIME( timerResults );
+    if( this->mStatisticsRowSamples != 0 )
+        AddStatisticsRows( byte.mStartingSampleInclusive );
+    this->mStatistics->AddByte( byte );
+
+    Frame byteFrame;
+    byteFrame.mStartingSampleInclusive = byte.mStartingSampleInclusive;
+    byteFrame.mEndingSampleInclusive = byte.mEndingSampleInclusive;
+    byteFrame.mData1 = byte.mData;
+    byteFrame.mData2 = byte.mIndex | ( ( U64 )byte.mBus << 8 ); // number of data in message and bus
+    byteFrame.mType = byte.mType;
+    byteFrame.mFlags = byte.mFlags;
+
+    this->mResults->AddFrame( byteFrame ); // add frame to graph view
+    MELIBU_COUNT( counterFrames, 1 );
+    this->mCommitScheduler.AddFrame();
+    if( this->mSettings->mTableRows != tablePackets )
+        AddFrameToTable( byteFrame, byte.mCrc ); // add frame to tabular view
 }
 
-void MELIBUAnalyzer::Advance( U16 nBits ) {
-    this->mSerial->Advance( nBits * SamplesPerBit() );
-}
-
-U8 MELIBUAnalyzer::NumberOfDataBytes( U8 idField1, U8 idField2 ) {
-    // in this function function select bit needs to be extracted first
-    // number of data bytes in message are calculated based on function select bit and MELIBU version
+void MELIBUAnalyzer::OnMissingByte( S64 starting_sample, S64 ending_sample ) {
+    MELIBU_TIME( timerResults );
+    if( this->mStatisticsRowSamples != 0 )
+        AddStatisticsRows( starting_sample );
+    this->mStatistics->AddMissingByte( this->mBus, starting_sample, ending_sample );
 
-    if( this->mSettings->mMELIBUVersion >= 2 ) {
-        U8 functionSelect = idField2 & 0x02; // 0x02 = 0000 0010; extract value in second bit
-        U8 length = idField2 & 0x38;         // 0x38 = 0011 1000; extraxt bits on 3, 4 and 5 places
-        length = length >> 3;             // right shift to get 3bit value
-        if( functionSelect == 0 ) {
-            switch( length ) {
-                case 6:
-                    return 18;
-                case 7:
-                    return 24;
-                default: // 0,1,2,3,4,5 cases
-                    return length * 2;
-            }
-        } else {
-            switch( length ) {
-                case 0:
-                    return 6;
-                case 6:
-                    return 84;
-                case 7:
-                    return 128;
-                default: // 1,2,3,4,5 cases
-                    return length * 12;
-            }
-        }
-    } else {
-        U8 functionSelect = idField1 & 0x01; // 0x01 = 0000 0001
-        U8 length { 0 };
-        if( functionSelect == 0 ) {
-            length = idField2 & 0x1c;     // 0x1c = 0001 1100
-            std::bitset < 8 > n( length );   // number of set bits in number
-            return n.count() * 6;
-        } else {
-            length = idField2 & 0xfc;     // 0xfc = 1111 1100
-            if( this->mSettings->mMELIBUVersion == 1.0 ) {
-                std::bitset < 8 > n( length ); // number of set bits in number
-                return n.count() * 6;
-            } else {   // MeLiBu 1.1 (extended mode)
-                length = length >> 2;
-                return ( length + 1 ) * 2;
-            }
-        }
-    }
+    // add row to table to mark missig byte
+    FrameV2 frame_v2;
+    frame_v2.AddBoolean( "missing byte", true );
+    if( this->mBusChannels.size() > 1 )
+        frame_v2.AddInteger( "bus", this->mBus + 1 );
+    // starting sample is not starting sample of header frame but starting sample of inter byte space
+    // ending sample is starting sample of header break which is the same as ending sample of inter byte space
+    this->mResults->AddFrameV2( frame_v2, "missing_byte", starting_sample, ending_sample ); // only adds row to table
+    MELIBU_COUNT( counterFramesV2, 1 );
+    this->mCommitScheduler.AddFrame();
 }
 
-void MELIBUAnalyzer::FormatValue( std::ostringstream& ss, U64 value, U8 precision ) {
-    ss.str( "" ); // empty ss
-    ss.clear();   // clear from errors
-    ss << "0x" << std::setfill( '0' ) << std::setw( precision ) << std::uppercase << std::hex << value;
-}
-
-U8 MELIBUAnalyzer::GetBreakField( S64& startingSample, S64& endingSample, bool& framingError, bool& toggling ) {
-    U32 min_break_field_low_bits { 13 }; // for MeLiBu 1
-    if( this->mSettings->mMELIBUVersion >= 2.0 )
-        min_break_field_low_bits = 11; // for MeLiBu 2
-
-    U32 num_break_bits { 0 };
-    bool valid_frame { false };
-    StartingSampleInBreakField( min_break_field_low_bits, startingSample, num_break_bits, valid_frame, toggling );
-
-    // sample (add marker) each byte of break field at the middle of bit
-    /*for( U32 i = 0; i < num_break_bits; i++ )
-     * {
-     *  if( i == 0 )
-     *      AdvanceHalfBit();
-     *  else
-     *      Advance( 1 );
-     *  this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-     *                             this->mSerial->GetBitState() == BIT_HIGH ? AnalyzerResults::One : AnalyzerResults::Zero,
-     *                             this->mSettings->mInputChannel );
-     * }*/
-
-    // sample each low bit in break field
-    AdvanceHalfBit();
-    while( this->mSerial->GetBitState() == BIT_LOW ) {
-        this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                   AnalyzerResults::Zero,
-                                   this->mSettings->mInputChannel );
-        Advance( 1 );
-    }
-
-    // validate stop bit
-    //Advance( 1 );
-    if( this->mSerial->GetBitState() == BIT_HIGH ) {
-        this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                   AnalyzerResults::Stop,
-                                   this->mSettings->mInputChannel );
-        framingError = false;
-    } else {
-        this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                   AnalyzerResults::ErrorSquare,
-                                   this->mSettings->mInputChannel );
-        framingError = true;
-    }
-
-    // after all advancing we are now in the middle of stop bit
-    SetEndingSampleInStopBit( endingSample );
-    this->mSerial->AdvanceToAbsPosition( this->mSerial->GetSampleOfNextEdge() - 1 );
-
-    return ( valid_frame ) ? 0 : 1;
+void MELIBUAnalyzer::OnPacket( const MELIBUPacketRecord& packet ) {
+    MELIBU_TIME( timerResults );
+    MELIBU_COUNT( counterPackets, 1 );
+    // an SDK packet takes all frames added since the last one; frames of other buses overlap in time, so with
+    // several buses messages are only kept as packet records with their bus
+    U64 packet_id = INVALID_RESULT_INDEX;
+    if( this->mBusChannels.size() == 1 )
+        packet_id = this->mResults->CommitPacketAndStartNewPacket();
+    this->mResults->AddPacketRecord( packet, packet_id );
+    this->mStatistics->AddPacket( packet );
+    if( this->mSettings->mTableRows != tableBytes )
+        AddPacketToTable( packet );
+    if( this->mSignalLayout )
+        AddSignalRows( packet );
+    this->mCommitScheduler.AddPacket();
 }
 
-U8 MELIBUAnalyzer::ByteFrame( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field ) {
-    U8 data = 0;
-    U8 mask = 0x01; // MELIBU 2: LSB first
-    if( this->mSettings->mMELIBUVersion < 2 ) // MELIBU 1: MSB first
-        mask = 0x80; // 1000 0000
-
-    framingError = false;
-    is_break_field = false;
-
-    // locate start bit
-    this->mSerial->AdvanceToNextEdge();
-    if( this->mSerial->GetBitState() == BIT_HIGH ) {
-        // start bit needs to be low; add error marker and advance to next edge (low)
-        AdvanceHalfBit();
-        this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                   AnalyzerResults::ErrorDot,
-                                   this->mSettings->mInputChannel );
-        this->mSerial->AdvanceToNextEdge();
-    }
-    startingSample = this->mSerial->GetSampleNumber();
-    AdvanceHalfBit(); // advance to the middle of start bit
-    this->mResults->AddMarker( this->mSerial->GetSampleNumber(), AnalyzerResults::Start,
-                               this->mSettings->mInputChannel );
-
-    bool all_break_clear = true;
-    // data bits; add marker at the middle of each bit
-    for( U32 i = 0; i < 8; i++ ) {
-        Advance( 1 );
-        if( this->mSerial->GetBitState() == BIT_HIGH ) {
-            data |= mask; // add bit to data
-            all_break_clear = false; // if at least one bit is high and if there is error frame can't be recognized as break field
-        }
-        this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                   this->mSerial->GetBitState() == BIT_HIGH ? AnalyzerResults::One : AnalyzerResults::Zero,
-                                   this->mSettings->mInputChannel );
-
-        if( this->mSettings->mMELIBUVersion == 2 )
-            mask = mask << 1;
-        else
-            mask = mask >> 1;
-    }
-
-    // validate stop bit
-    Advance( 1 );
-    if( this->mSerial->GetBitState() == BIT_HIGH ) {
-        this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                   AnalyzerResults::Stop,
-                                   this->mSettings->mInputChannel );
-    } else {
-        //check if we are really in a break frame
-        //10 bits are read: start + 8 data btis + stop; check rest of the bits to see if it is break field
-        int additional_bits = this->mSettings->mMELIBUVersion < 2.0 ? 3 : 1;
-        all_break_clear &= !( this->mSerial->WouldAdvancingCauseTransition( SamplesPerBit() * additional_bits ) ); // true if all_break_clear was true and no transition to high bit
-
-        // add marker for wrong stop bit
-        if( !all_break_clear ) {
-            this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                       AnalyzerResults::ErrorSquare,
-                                       this->mSettings->mInputChannel );
-            framingError = true;
-        } else {
-            this->mSerial->AdvanceToNextEdge();
-            bool high_bit_resent = !this->mSerial->WouldAdvancingCauseTransition( HalfSamplesPerBit() );
-            if( high_bit_resent ) {
-                endingSample = this->mSerial->GetSampleNumber();
-                is_break_field = true;
-                return 0x00;
-            }
-        }
-
-    }
-
-    SetEndingSampleInStopBit( endingSample );
-    this->mSerial->AdvanceToAbsPosition( this->mSerial->GetSampleOfNextEdge() - 1 );
-
-    return data;
-}
-
-void MELIBUAnalyzer::StartingSampleInBreakField( U32& minBreakFieldBits,
-                                                 S64& startingSample,
-                                                 U32& num_break_bits,
-                                                 bool& valid_frame,
-                                                 bool& toggling ) {
-    toggling = false;
-    for( ;; ) {
-        this->mSerial->AdvanceToNextEdge();
-        if( this->mSerial->GetBitState() == BIT_HIGH ) {
-            // add marker at every rising edge when searching for brak field
-            this->mResults->AddMarker( this->mSerial->GetSampleNumber(),
-                                       AnalyzerResults::ErrorX,
-                                       this->mSettings->mInputChannel );
-            toggling = true;
-            this->mSerial->AdvanceToNextEdge();
-        }
-        // do not advance, but only get the sample of next edge and calculate number of low bits
-        num_break_bits =
-            round(
-                ( double )( ( this->mSerial->GetSampleOfNextEdge() - this->mSerial->GetSampleNumber() ) /
-                            SamplesPerBit() ) );
-        if( num_break_bits >= minBreakFieldBits ) { // if number of low bits are greater than minimum frame is valid
-            startingSample = this->mSerial->GetSampleNumber();
-            valid_frame = true;
-            break;
-        }
-    }
+void MELIBUAnalyzer::OnProgress( S64 sample_number ) {
+    this->mLastSample = std::max( this->mLastSample, sample_number );
+    if( this->mCommitScheduler.CommitNeeded( sample_number ) )
+        Commit( sample_number );
 }
 
-void MELIBUAnalyzer::SetEndingSampleInStopBit( S64& endingSample ) {
-    if( this->mSerial->GetSampleOfNextEdge() - this->mSerial->GetSampleNumber() > HalfSamplesPerBit() )
-        endingSample = this->mSerial->GetSampleNumber() + HalfSamplesPerBit();
-    else
-        endingSample = this->mSerial->GetSampleOfNextEdge();
+// decoder may wait for data now; at end of a finished capture it never returns, so everything is committed here
+void MELIBUAnalyzer::OnIdle( S64 sample_number ) {
+    this->mLastSample = std::max( this->mLastSample, sample_number );
+    if( this->mStatisticsRowSamples != 0 )
+        AddStatisticsRows( this->mLastSample, true );
+    if( this->mCommitScheduler.Pending() )
+        Commit( this->mLastSample );
 }
 
-bool MELIBUAnalyzer::SendAckByte( U8& idField1, U8& idField2 ) {
-    bool ack { this->mSettings->mACK };
-
-    // ack is sent only when sent message is master to slave
-    if( this->mSettings->mMELIBUVersion == 2.0 ) {
-        ack &= ( ( idField2 & 0x01 ) == 0 );
-        ack &= ( idField1 >= 3 );
-    } else {
-        ack &= ( ( idField1 & 0x02 ) == 0 );
-        ack &= ( ( ( idField1 & 0xFC ) >> 2 ) >= 3 );
-    }
-    return ack;
-}
-
-void MELIBUAnalyzer::AddToCrc( Frame& byte ) {
-    switch(this->mFrameState) {
-        case MELIBUAnalyzerResults::headerID1:
-        case MELIBUAnalyzerResults::headerID2:
-        case MELIBUAnalyzerResults::instruction1:
-        case MELIBUAnalyzerResults::instruction2:
-        case MELIBUAnalyzerResults::responseDataZero:
-        case MELIBUAnalyzerResults::responseData:
-            this->mCRC.add( byte.mData1 );
-    }
+void MELIBUAnalyzer::Commit( S64 sample_number ) {
+    MELIBU_TIME( timerCommit );
+    MELIBU_COUNT( counterCommits, 1 );
+    this->mResults->CommitResults();
+    ReportProgress( sample_number );
+    this->mCommitScheduler.Committed( sample_number );
 }
 
-void MELIBUAnalyzer::AddFrameToTable( Frame& f ) {
+void MELIBUAnalyzer::AddFrameToTable( Frame& f, U16 crc ) {
     FrameV2 frame_v2; // frameV2 is used for tabular view of data bytes in UI
-    std::ostringstream ss;
-
-    switch( static_cast < MELIBUAnalyzerResults::tMELIBUFrameState > ( f.mType ) ) {
-        case MELIBUAnalyzerResults::headerID1:
-        case MELIBUAnalyzerResults::headerID2:
-        case MELIBUAnalyzerResults::instruction1:
-        case MELIBUAnalyzerResults::instruction2:
-        case MELIBUAnalyzerResults::responseCRC1:
-        case MELIBUAnalyzerResults::responseCRC2:
-        case MELIBUAnalyzerResults::responseACK:
-            FormatValue( ss, f.mData1, 2 );
-            frame_v2.AddString( "data", ss.str().c_str() );
+
+    switch( static_cast < MELIBUDecoder::tMELIBUFrameState > ( f.mType ) ) {
+        case MELIBUDecoder::headerID1:
+        case MELIBUDecoder::headerID2:
+        case MELIBUDecoder::instruction1:
+        case MELIBUDecoder::instruction2:
+        case MELIBUDecoder::responseCRC1:
+        case MELIBUDecoder::responseCRC2:
+        case MELIBUDecoder::responseACK:
+            frame_v2.AddString( "data", MELIBUFormat::ByteHex( f.mData1 ) );
             break;
         // for response data add byte value and index of data in message
-        case MELIBUAnalyzerResults::responseDataZero:
-        case MELIBUAnalyzerResults::responseData:
-            FormatValue( ss, f.mData1, 2 );
-            frame_v2.AddString( "data", ss.str().c_str() );
-            FormatValue( ss, f.mData2 - 1, 2 );
-            frame_v2.AddString( "index", ss.str().c_str() );
+        case MELIBUDecoder::responseDataZero:
+        case MELIBUDecoder::responseData:
+            frame_v2.AddString( "data", MELIBUFormat::ByteHex( f.mData1 ) );
+            frame_v2.AddString( "index", MELIBUFormat::ByteHex( ( f.mData2 & 0xFF ) - 1 ) );
             break;
         default:
             break;
     }
 
-    // add flag strings to table
-    auto flag_strings = FrameFlagsToString( f.mFlags );
-    for( const auto& flag_string : flag_strings ) {
-        if( flag_string == "crc_mismatch" ) {
-            FormatValue( ss, mCRC.result(), 4 );
-            frame_v2.AddString( flag_string.c_str(), ss.str().c_str() ); // add column named crc_mismatch with calculated crc field value
-        } else
-            frame_v2.AddBoolean( flag_string.c_str(), true );            // add column named as flag with field value true
-    }
-    this->mResults->AddFrameV2( frame_v2,
-                                FrameTypeToString(
-                                    static_cast < MELIBUAnalyzerResults::tMELIBUFrameState > ( f.mType ) ).c_str(),
-                                f.mStartingSampleInclusive,
-                                f.mEndingSampleInclusive );
-}
-
-void MELIBUAnalyzer::ReadFrame( Frame& byteFrame, Frame& ibsFrame, bool& is_data_really_break,
-                                bool& byteFramingError ) {
-    is_data_really_break = false;
-    ibsFrame.mStartingSampleInclusive = this->mSerial->GetSampleNumber(); // inter byte space is from current sample to starting sample of break or byte field
-    // read break or byte field; byteFramingError and is_data_really_break are set in functions
-    byteFrame.mFlags = 0;
-    if( ( this->mFrameState == MELIBUAnalyzerResults::NoFrame ) ||
-        ( this->mFrameState == MELIBUAnalyzerResults::headerBreak ) ) {
-        bool toggling = false;
-        byteFrame.mData1 = GetBreakField( byteFrame.mStartingSampleInclusive,
-                                          byteFrame.mEndingSampleInclusive,
-                                          byteFramingError,
-                                          toggling );
-        byteFrame.mFlags |= ( toggling ? MELIBUAnalyzerResults::headerToggling : 0 );
-    } else {
-        byteFrame.mData1 = ByteFrame( byteFrame.mStartingSampleInclusive,
-                                      byteFrame.mEndingSampleInclusive,
-                                      byteFramingError,
-                                      is_data_really_break );
+    if( this->mBusChannels.size() > 1 )
+        frame_v2.AddInteger( "bus", ( f.mData2 >> 8 ) + 1 );
+
+    // add flag columns to table
+    for( U8 bit = 0; bit < MELIBUFormat::FlagCount; bit++ ) {
+        if( ( f.mFlags & ( 1 << bit ) ) == 0 )
+            continue;
+        if( ( 1 << bit ) == MELIBUDecoder::crcMismatch )
+            frame_v2.AddString( MELIBUFormat::FlagName( bit ), MELIBUFormat::WordHex( crc ) ); // add column named crc_mismatch with calculated crc field value
+        else
+            frame_v2.AddBoolean( MELIBUFormat::FlagName( bit ), true );                          // add column named as flag with field value true
     }
-    ibsFrame.mEndingSampleInclusive = byteFrame.mStartingSampleInclusive;
-    byteFrame.mData2 = 0;
-    byteFrame.mFlags |= ( byteFramingError ? MELIBUAnalyzerResults::byteFramingError : 0 );
-    byteFrame.mType = mFrameState;
+    this->mResults->AddFrameV2( frame_v2, MELIBUFormat::FrameTypeName( f.mType ), f.mStartingSampleInclusive, f.mEndingSampleInclusive );
+    MELIBU_COUNT( counterFramesV2, 1 );
 }
 
-void MELIBUAnalyzer::CrcFrameValue( U16& crc, U64 data, U8 frameOrder ) {
-    if( frameOrder == 0 ) {
-        crc = data; // add first byte to crc: just set crc value
-    } else {
-        // add second byte to crc (connect with current value); for MELIBU 2 second byte is msb byte, for MELIBU 1 second byte is lsb
-        if( this->mSettings->mMELIBUVersion == 2.0 )
-            crc |= ( data << 8 );
-        else {
-            crc = crc << 8;
-            crc |= data;
+// rows are placed at end of message; signals of interrupted messages are not decoded
+void MELIBUAnalyzer::AddSignalRows( const MELIBUPacketRecord& packet ) {
+    const MELIBUSignalLayout& layout = *this->mSignalLayout;
+    const U32* frames = nullptr;
+    U32 num_frames = packet.mComplete ? layout.Lookup( packet.mID1, packet.mID2, packet.mHasInstruction ? packet.mInstruction : 0, frames ) : 0;
+    for( U32 f = 0; f < num_frames; f++ ) {
+        const MELIBUSignalLayoutFrame& frame = layout.Frame( frames[ f ] );
+        for( U32 s = 0; s < frame.mNumSignals; s++ ) {
+            const MELIBUSignalLayoutSignal& signal = layout.Signal( frame.mFirstSignal + s );
+            U64 raw;
+            if( !layout.SignalValue( signal, packet.mData, packet.mDataLength, raw ) )
+                continue;
+
+            FrameV2 frame_v2;
+            if( this->mBusChannels.size() > 1 )
+                frame_v2.AddInteger( "bus", packet.mBus + 1 );
+            frame_v2.AddString( "frame", layout.Name( frame.mName ) );
+            frame_v2.AddString( "signal", layout.Name( signal.mName ) );
+            frame_v2.AddInteger( "raw", ( S64 )raw );
+            const MELIBUSignalLayoutEncoding* encoding = layout.FindEncoding( signal, raw );
+            if( encoding != nullptr && encoding->mType == MELIBUSignalLayoutEncoding::encodingPhysical ) {
+                frame_v2.AddDouble( "physical", encoding->mScale * double( raw ) + encoding->mOffset );
+                frame_v2.AddString( "unit", layout.Name( encoding->mText ) );
+            } else if( encoding != nullptr )
+                frame_v2.AddString( "text", layout.Name( encoding->mText ) );
+            if( !layout.IsSlave( layout.SlaveAddress( packet.mID1 ) ) )
+                frame_v2.AddBoolean( "unknown_slave", true );
+            if( packet.mFlags & MELIBUDecoder::crcMismatch )
+                frame_v2.AddBoolean( "crc_mismatch", true );
+            this->mResults->AddFrameV2( frame_v2, "signal", packet.mEndingSampleInclusive, packet.mEndingSampleInclusive );
+            MELIBU_COUNT( counterFramesV2, 1 );
+            this->mCommitScheduler.AddFrame();
         }
     }
 }
 
-void MELIBUAnalyzer::AddMissingByteFrame( Frame& ibsFrame ) {
-    this->mFrameState = MELIBUAnalyzerResults::NoFrame;
+// whole message in one row, so high level analyzers get one frame per message instead of one per byte
+// data_offset and bit_time (seconds) let them place signals within the message
+void MELIBUAnalyzer::AddPacketToTable( const MELIBUPacketRecord& packet ) {
+    FrameV2 frame_v2;
+    if( this->mBusChannels.size() > 1 )
+        frame_v2.AddInteger( "bus", packet.mBus + 1 );
+    frame_v2.AddInteger( "id1", packet.mID1 );
+    frame_v2.AddInteger( "id2", packet.mID2 );
+    if( packet.mHasInstruction )
+        frame_v2.AddInteger( "instruction", packet.mInstruction );
+    frame_v2.AddByteArray( "payload", packet.mData, packet.mDataLength );
+    if( packet.mComplete )
+        frame_v2.AddInteger( "crc", packet.mReceivedCrc );
+    if( packet.mHasAck )
+        frame_v2.AddInteger( "ack", packet.mAck );
+    if( !packet.mComplete )
+        frame_v2.AddBoolean( "incomplete", true );
+    for( U8 bit = 0; bit < MELIBUFormat::FlagCount; bit++ ) {
+        if( ( packet.mFlags & ( 1 << bit ) ) == 0 )
+            continue;
+        if( ( 1 << bit ) == MELIBUDecoder::crcMismatch )
+            frame_v2.AddString( MELIBUFormat::FlagName( bit ), MELIBUFormat::WordHex( packet.mCalculatedCrc ) );
+        else
+            frame_v2.AddBoolean( MELIBUFormat::FlagName( bit ), true );
+    }
+    if( packet.mDataLength != 0 )
+        frame_v2.AddDouble( "data_offset", double( packet.mDataStartingSample - packet.mStartingSampleInclusive ) / this->mSampleRateHz );
+    frame_v2.AddDouble( "bit_time", 1.0 / this->mBitRate );
+    this->mResults->AddFrameV2( frame_v2, "packet", packet.mStartingSampleInclusive, packet.mEndingSampleInclusive );
+    MELIBU_COUNT( counterFramesV2, 1 );
+    this->mCommitScheduler.AddFrame();
+}
 
-    // add row to table to mark missig byte
+// one row per bus and interval, placed at end of interval
+// at end of data rows cover started interval up to sample_number; rest of interval gets another row if decoding continues
+void MELIBUAnalyzer::AddStatisticsRows( S64 sample_number, bool end_of_data ) {
+    MELIBUStatisticsInterval interval;
+    for( U8 bus = 0; bus < this->mBusChannels.size(); bus++ ) {
+        while( this->mStatistics->NextInterval( bus, sample_number, interval ) )
+            AddStatisticsRow( bus, interval );
+        if( end_of_data && this->mStatistics->PartialInterval( bus, sample_number, interval ) )
+            AddStatisticsRow( bus, interval );
+    }
+}
+
+void MELIBUAnalyzer::AddStatisticsRow( U8 bus, const MELIBUStatisticsInterval& interval ) {
+    S64 ending_sample = interval.mEndingSampleInclusive;
     FrameV2 frame_v2;
-    frame_v2.AddBoolean( "missing byte", true );
-    // starting sample is not starting sample of header frame but starting sample of inter byte space
-    // ending sample is starting sample of header break which is the same as ending sample of inter byte space
-    this->mResults->AddFrameV2( frame_v2,
-                                "missing_byte",
-                                ibsFrame.mStartingSampleInclusive,
-                                ibsFrame.mEndingSampleInclusive );                                                              // only adds row to table
+    if( this->mBusChannels.size() > 1 )
+        frame_v2.AddInteger( "bus", bus + 1 );
+    frame_v2.AddDouble( "load", 100.0 * double( interval.mBusySamples ) / double( ending_sample - interval.mStartingSampleInclusive + 1 ) );
+    frame_v2.AddInteger( "bytes", interval.mBytes );
+    frame_v2.AddInteger( "messages", interval.mPackets );
+    frame_v2.AddInteger( "errors", interval.mErrorPackets );
+    frame_v2.AddInteger( "missing_bytes", interval.mMissingBytes );
+    this->mResults->AddFrameV2( frame_v2, "statistics", ending_sample, ending_sample );
+    MELIBU_COUNT( counterFramesV2, 1 );
+    this->mCommitScheduler.AddFrame();
 }
 
 U32 MELIBUAnalyzer::GenerateSimulationData( U64 minimum_sample_index,
@@ -559,6 +446,9 @@ U32 MELIBUAnalyzer::GenerateSimulationData( U64 minimum_sample_index,
 }
 
 U32 MELIBUAnalyzer::GetMinimumSampleRateHz() {
+    // edge tracking decoder resynchronizes on every edge and can work with fewer samples per bit
+    if( this->mSettings->mByteDecoder == MELIBUDecoderSettings::byteDecoderTracking )
+        return this->mSettings->mBitRate * 3;
     return this->mSettings->mBitRate * 4;
 }
 
@@ -4,48 +4,48 @@
 #include <Analyzer.h>
 #include "MELIBUAnalyzerResults.h"
 #include "MELIBUSimulationDataGenerator.h"
-#include "MELIBUCrc.h"
-#include <map>
-
-namespace
+#include "MELIBUDecoder.h"
+#include "MELIBUChannel.h"
+#include "MELIBUBitRateDetector.h"
+#include "MELIBUCommitScheduler.h"
+#include "MELIBUFormat.h"
+#include "MELIBUBusStatistics.h"
+#include "MELIBUSignalLayout.h"
+#include <memory>
+#include <vector>
+
+// MELIBUChannel over channel data provided by Logic application
+class MELIBUAnalyzerChannel: public MELIBUChannel
 {
-    std::map < MELIBUAnalyzerResults::tMELIBUFrameState, std::string > FrameTypeStringLookup = {
-        { MELIBUAnalyzerResults::NoFrame, "no_frame" },
-        { MELIBUAnalyzerResults::headerBreak, "breakfield" },
-        { MELIBUAnalyzerResults::headerID1, "header_ID1" },
-        { MELIBUAnalyzerResults::headerID2, "header_ID2" },
-        { MELIBUAnalyzerResults::instruction1, "instruction_byte1" },
-        { MELIBUAnalyzerResults::instruction2, "instruction_byte2" },
-        { MELIBUAnalyzerResults::responseDataZero, "data" },
-        { MELIBUAnalyzerResults::responseData, "data" },
-        { MELIBUAnalyzerResults::responseCRC1, "crc1" },
-        { MELIBUAnalyzerResults::responseCRC2, "crc2" },
-        { MELIBUAnalyzerResults::responseACK, "ack" },
-    };
-
-    std::string FrameTypeToString( MELIBUAnalyzerResults::tMELIBUFrameState state ) {
-        return FrameTypeStringLookup.at( state );
-    }
-
-    std::vector < std::string > FrameFlagsToString( U8 flags ) {
-        std::vector < std::string > strings;
-        if( flags & MELIBUAnalyzerResults::byteFramingError )
-            strings.push_back( "byte_framing_error" );
-        if( flags & MELIBUAnalyzerResults::headerBreakExpected )
-            strings.push_back( "header_break_expected" );
-        if( flags & MELIBUAnalyzerResults::crcMismatch )
-            strings.push_back( "crc_mismatch" );
-        if( flags & MELIBUAnalyzerResults::receptionFailed )
-            strings.push_back( "reception_failed" );
-        if( flags & MELIBUAnalyzerResults::headerToggling )
-            strings.push_back( "unexpected_data" );
-
-        return strings;
-    }
-}
+ public:
+    // idle_listener gets OnIdle before a read that may wait for data; only for channels read by analyzer thread
+    MELIBUAnalyzerChannel( AnalyzerChannelData* channel_data, MELIBUDecoderListener* idle_listener = nullptr );
+    virtual ~MELIBUAnalyzerChannel();
+
+    virtual U64 GetSampleNumber();
+    virtual bool IsHigh();
+
+    virtual U32 Advance( U32 num_samples );
+    virtual U32 AdvanceToAbsPosition( U64 sample_number );
+    virtual void AdvanceToNextEdge();
+
+    virtual U64 GetSampleOfNextEdge();
+    virtual bool WouldAdvancingCauseTransition( U32 num_samples );
+
+    virtual bool AtEnd();
+    virtual bool MoreEdgesAvailable();
+
+ protected:
+    void BeforeRead( U64 sample_number ); // reading up to sample_number may wait for data
+
+ protected: //vars
+    AnalyzerChannelData* mChannelData;
+    MELIBUDecoderListener* mIdleListener;
+    U64 mCapturedUntil; // sample of an edge known to be captured; reading up to it never waits
+};
 
 class MELIBUAnalyzerSettings;
-class ANALYZER_EXPORT MELIBUAnalyzer: public Analyzer2
+class ANALYZER_EXPORT MELIBUAnalyzer: public Analyzer2, public MELIBUDecoderListener
 {
  public:
     MELIBUAnalyzer();
@@ -62,29 +62,35 @@ class ANALYZER_EXPORT MELIBUAnalyzer: public Analyzer2
     virtual const char* GetAnalyzerName() const;
     virtual bool NeedsRerun(); // not in use
 
+    // FrameV2 rows passed to table and high level analyzers
+    typedef enum {
+        tableBytes = 0,          // one row per break, header, data, crc and ack field
+        tablePackets = 1,        // one packet row per message
+        tableBytesAndPackets = 2
+    } tMELIBUTableRows;
+
  protected:
-    inline double SamplesPerBit();
-    double HalfSamplesPerBit();
-    void AdvanceHalfBit();
-    void Advance( U16 nBits );
-
-    U8 NumberOfDataBytes( U8 idField1, U8 idField2 ); // calucalte number of expected data bytes after header
-    void FormatValue( std::ostringstream& ss, U64 value, U8 precision ); // format value with hex notation with given precision
-
-    U8 GetBreakField( S64& startingSample, S64& endingSample, bool& framingError, bool& toggling );
-    U8 ByteFrame( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field );
-    void StartingSampleInBreakField( U32& minBreakFieldBits,
-                                     S64& startingSample,
-                                     U32& num_break_bits,
-                                     bool& valid_frame,
-                                     bool& toggling );
-    void SetEndingSampleInStopBit( S64& endingSample ); // call this function when stop bit is sampled in the middle
-    bool SendAckByte( U8& idField1, U8& idField2 );
-    void AddToCrc( Frame& byte );
-    void AddFrameToTable( Frame& f);
-    void ReadFrame( Frame& byteFrame, Frame& ibsFrame, bool& is_data_really_break, bool& byteFramingError );
-    void CrcFrameValue( U16& crc, U64 data, U8 frameOrder );
-    void AddMissingByteFrame( Frame& ibsFrame );
+    // decoder output; forwarded to results
+    virtual void OnBus( U8 bus );
+    virtual void OnMarker( U64 sample_number, U8 marker );
+    virtual void OnByte( const MELIBUByteRecord& byte );
+    virtual void OnMissingByte( S64 starting_sample, S64 ending_sample );
+    virtual void OnPacket( const MELIBUPacketRecord& packet );
+    virtual void OnProgress( S64 sample_number );
+    virtual void OnIdle( S64 sample_number );
+    void Commit( S64 sample_number ); // commit results and report progress
+
+    void AddFrameToTable( Frame& f, U16 crc );
+    // IDs, instruction, payload, crc and ack of message in one row
+    void AddPacketToTable( const MELIBUPacketRecord& packet );
+    // summary rows of statistics intervals that ended before sample_number; when all captured data is decoded also of started interval, once per interval
+    void AddStatisticsRows( S64 sample_number, bool end_of_data = false );
+    void AddStatisticsRow( U8 bus, const MELIBUStatisticsInterval& interval );
+    // one row per signal of frames in signal layout that match message header
+    void AddSignalRows( const MELIBUPacketRecord& packet );
+
+    enum { BusWindowsPerSecond = 100 }; // output of several buses is merged in windows of 10 ms capture time
+    enum { DefaultStatisticsIntervalMs = 1000 }; // bus load intervals of statistics export if summary rows are off
 
  protected: //vars
     std::auto_ptr < MELIBUAnalyzerSettings > mSettings;
@@ -93,8 +99,15 @@ class ANALYZER_EXPORT MELIBUAnalyzer: public Analyzer2
 
     MELIBUSimulationDataGenerator mSimulationDataGenerator;
     bool mSimulationInitilized;
-    MELIBUAnalyzerResults::tMELIBUFrameState mFrameState;
-    MELIBUCrc mCRC;
+    MELIBUCommitScheduler mCommitScheduler;
+    U32 mDetectedBitRate; // 0 if detection is off or failed
+    std::vector < Channel > mBusChannels; // input channel first; more than one if several buses are decoded
+    U8 mBus;                              // bus of decoder output being received
+    MELIBUBusStatistics* mStatistics;     // kept by results for statistics export
+    U64 mStatisticsRowSamples;            // interval of statistics rows; 0 if rows are off
+    S64 mLastSample;                      // last sample reported by decoder
+    std::shared_ptr < const MELIBUSignalLayout > mSignalLayout; // null if signal rows are off
+    U32 mBitRate;                         // bit rate used for decoding; detected or from settings
 
 
     //Serial analysis vars:
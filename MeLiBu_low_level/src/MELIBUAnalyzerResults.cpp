@@ -2,65 +2,94 @@
 #include <AnalyzerHelpers.h>
 #include "MELIBUAnalyzer.h"
 #include "MELIBUAnalyzerSettings.h"
+#include "MELIBUInstrumentation.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <utility>
+#include <vector>
+#include <thread>
+#include <algorithm>
 
 MELIBUAnalyzerResults::MELIBUAnalyzerResults( MELIBUAnalyzer* analyzer, MELIBUAnalyzerSettings* settings )
     :   AnalyzerResults(),
     mSettings( settings ),
-    mAnalyzer( analyzer ) {}
+    mAnalyzer( analyzer ),
+    mBusChannels( settings->BusChannels() ) {}
 
 MELIBUAnalyzerResults::~MELIBUAnalyzerResults() {}
 
 // bubble text is shown on the bar above bits
+// UI asks for bubble text of the same frames again and again while scrolling and zooming, so built strings are cached
+// with several buses, bubbles are requested for every bus channel; frame is shown only on channel of its bus
 void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base ) {
     ClearResultStrings();
     Frame frame = GetFrame( frame_index );
+    U64 bus = frame.mData2 >> 8;
+    if( this->mBusChannels.size() > 1 && bus < this->mBusChannels.size() && this->mBusChannels[ bus ] != channel )
+        return;
+
+    // data index is part of text only for data bytes
+    U64 index = ( frame.mType == MELIBUDecoder::responseDataZero || frame.mType == MELIBUDecoder::responseData ) ? frame.mData2 & 0xFF : 0;
+    U64 key = ( U64 )frame.mType | ( ( frame.mData1 & 0xFF ) << 8 ) | ( index << 16 ) | ( ( U64 )frame.mFlags << 24 ) |
+              ( ( U64 )display_base << 32 );
+
+    std::lock_guard < std::mutex > lock( this->mBubbleCacheMutex );
+    auto it = this->mBubbleCache.find( key );
+    if( it == this->mBubbleCache.end() ) {
+        if( this->mBubbleCache.size() >= MaxBubbleCacheSize )
+            this->mBubbleCache.clear();
+        it = this->mBubbleCache.insert( std::make_pair( key, BubbleText() ) ).first;
+        BuildBubbleText( frame, display_base, it->second );
+    }
+    for( U32 i = 0; i < it->second.mCount; i++ )
+        AddResultString( it->second.mStrings[ i ].c_str() );
+}
 
+void MELIBUAnalyzerResults::BuildBubbleText( const Frame& frame, DisplayBase display_base, BubbleText& bubble ) {
     char number_str[128];
     std::string fault_str;
     std::string str[ 3 ];
 
-    if( frame.mFlags & byteFramingError )
+    if( frame.mFlags & MELIBUDecoder::byteFramingError )
         fault_str += "!FRAME";
-    if( frame.mFlags & headerBreakExpected )
+    if( frame.mFlags & MELIBUDecoder::headerBreakExpected )
         fault_str += "!BREAK";
-    if( frame.mFlags & crcMismatch )
+    if( frame.mFlags & MELIBUDecoder::crcMismatch )
         fault_str += "!CRC";
-    if( frame.mFlags & receptionFailed )
+    if( frame.mFlags & MELIBUDecoder::receptionFailed )
         fault_str += "!ACK";
     if( fault_str.length() ) {
         fault_str += "!";
-        AddResultString( fault_str.c_str() );
+        bubble.Add( fault_str.c_str() );
 
         // display the error checksum if and only if the frame was a checksum and the only error was a checksum mismatch.
-        if( ( frame.mType == ( U8 )responseCRC2 ) && ( frame.mFlags == crcMismatch ) ) {
+        if( ( frame.mType == ( U8 )MELIBUDecoder::responseCRC2 ) && ( frame.mFlags == MELIBUDecoder::crcMismatch ) ) {
             AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 128 );
             str[ 0 ] = "!CRC ERR: ";
             str[ 0 ] += number_str;
             str[ 1 ] = "!CRC mismatch: ";
             str[ 1 ] += number_str;
-            AddResultString( str[ 0 ].c_str() );
-            AddResultString( str[ 1 ].c_str() );
+            bubble.Add( str[ 0 ].c_str() );
+            bubble.Add( str[ 1 ].c_str() );
         }
     } else {
         // depending on size of bar different strings are shown
         AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 128 );
-        switch( ( MELIBUAnalyzerResults::tMELIBUFrameState )frame.mType ) {
+        switch( ( MELIBUDecoder::tMELIBUFrameState )frame.mType ) {
             default:
-            case NoFrame:
+            case MELIBUDecoder::NoFrame:
                 str[ 0 ] += "IBS";
                 str[ 1 ] += "IB Space";
                 str[ 2 ] += "Inter-Byte Space";
                 break;
-            case headerBreak:
+            case MELIBUDecoder::headerBreak:
                 str[ 0 ] += "BRK";
                 str[ 1 ] += "Break";
                 str[ 2 ] += "Breakfield";
                 break;
-            case headerID1:
+            case MELIBUDecoder::headerID1:
                 AnalyzerHelpers::GetNumberString( frame.mData1 & 0xFF, display_base, 8, number_str, 128 );
                 str[ 0 ] += number_str;
 
@@ -70,7 +99,7 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += "Header ID 1: ";
                 str[ 2 ] += number_str;
                 break;
-            case headerID2:
+            case MELIBUDecoder::headerID2:
                 AnalyzerHelpers::GetNumberString( frame.mData1 & 0xFF, display_base, 8, number_str, 128 );
                 str[ 0 ] += number_str;
 
@@ -80,7 +109,7 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += "Header ID 2: ";
                 str[ 2 ] += number_str;
                 break;
-            case instruction1:
+            case MELIBUDecoder::instruction1:
                 AnalyzerHelpers::GetNumberString( frame.mData1 & 0xFF, display_base, 8, number_str, 128 );
                 str[ 0 ] += number_str;
 
@@ -90,7 +119,7 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += "Instruction 1: ";
                 str[ 2 ] += number_str;
                 break;
-            case instruction2:
+            case MELIBUDecoder::instruction2:
                 AnalyzerHelpers::GetNumberString( frame.mData1 & 0xFF, display_base, 8, number_str, 128 );
                 str[ 0 ] += number_str;
 
@@ -100,10 +129,10 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += "Instruction 2: ";
                 str[ 2 ] += number_str;
                 break;
-            case responseDataZero:
-            case responseData:
+            case MELIBUDecoder::responseDataZero:
+            case MELIBUDecoder::responseData:
                 char seq_str[ 128 ];
-                AnalyzerHelpers::GetNumberString( frame.mData2 - 1, Decimal, 8, seq_str, 128 );
+                AnalyzerHelpers::GetNumberString( ( frame.mData2 & 0xFF ) - 1, Decimal, 8, seq_str, 128 );
                 str[ 0 ] += number_str;
                 str[ 1 ] += "D";
                 str[ 1 ] += seq_str;
@@ -114,7 +143,7 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += ": ";
                 str[ 2 ] += number_str;
                 break;
-            case responseCRC1:
+            case MELIBUDecoder::responseCRC1:
                 str[ 0 ] += number_str;
 
                 str[ 1 ] += "CRC1: ";
@@ -123,7 +152,7 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += "CRC 1: ";
                 str[ 2 ] += number_str;
                 break;
-            case responseCRC2:
+            case MELIBUDecoder::responseCRC2:
                 str[ 0 ] += number_str;
 
                 str[ 1 ] += "CRC2: ";
@@ -132,7 +161,7 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += "CRC 2: ";
                 str[ 2 ] += number_str;
                 break;
-            case responseACK:
+            case MELIBUDecoder::responseACK:
                 str[ 0 ] += number_str;
 
                 str[ 1 ] += "ACK: ";
@@ -142,44 +171,145 @@ void MELIBUAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channe
                 str[ 2 ] += number_str;
                 break;
         }
-        AddResultString( str[ 0 ].c_str() );
-        AddResultString( str[ 1 ].c_str() );
-        AddResultString( str[ 2 ].c_str() );
+        bubble.Add( str[ 0 ].c_str() );
+        bubble.Add( str[ 1 ].c_str() );
+        bubble.Add( str[ 2 ].c_str() );
+    }
+}
+
+namespace
+{
+    // format export rows of frames [begin, end) and append them to out
+    void FormatExportRows( const std::vector < Frame >& frames,
+                           size_t begin,
+                           size_t end,
+                           U64 trigger_sample,
+                           U32 sample_rate,
+                           bool multi_bus,
+                           const std::vector < std::string >& value_strings,
+                           std::string& out ) {
+        out.clear();
+        out.reserve( ( end - begin ) * 48 );
+        for( size_t i = begin; i < end; i++ ) {
+            const Frame& frame = frames[ i ];
+            if( frame.mType == MELIBUDecoder::NoFrame )
+                continue;
+
+            if( multi_bus )
+                MELIBUFormat::AppendBusColumn( out, ( U8 )( frame.mData2 >> 8 ) );
+            MELIBUFormat::AppendByteRow( out,
+                                         frame.mType,
+                                         ( S64 )( frame.mStartingSampleInclusive - trigger_sample ),
+                                         sample_rate,
+                                         value_strings[ frame.mData1 & 0xFF ].c_str(),
+                                         frame.mFlags );
+        }
     }
 }
 
 // txt and csv extension are supported
+// frames are read in chunks; rows of each chunk are formatted in parallel and written to file in order
 void MELIBUAnalyzerResults::GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id ) {
+#ifdef MELIBU_INSTRUMENTATION
+    // counters of decoding so far are written next to exported file
+    {
+        U64 num_frames = GetNumFrames();
+        S64 last_sample = num_frames != 0 ? GetFrame( num_frames - 1 ).mEndingSampleInclusive : 0;
+        std::string report;
+        MELIBUInstrumentation::Report( report, last_sample, this->mAnalyzer->GetSampleRate() );
+        std::ofstream report_stream( std::string( file ) + ".instrumentation.txt", std::ios::out );
+        report_stream << report;
+    }
+#endif
+    // custom export options are not supported in Logic 2; format is selected in settings
+    if( this->mSettings->mExportFormat == exportMessages ) {
+        GeneratePacketExportFile( file );
+        return;
+    }
+    if( this->mSettings->mExportFormat == exportStatistics ) {
+        GenerateStatisticsExportFile( file );
+        return;
+    }
+
+    // text mode: rows end with '\n', written as CRLF on Windows like before
     std::ofstream file_stream( file, std::ios::out );
 
     U64 trigger_sample = this->mAnalyzer->GetTriggerSample();
     U32 sample_rate = this->mAnalyzer->GetSampleRate();
 
-    file_stream << "Type,Time [s],Value,Error" << std::endl;
+    // value column depends only on byte value and display base
+    std::vector < std::string > value_strings( 256 );
+    for( U32 value = 0; value < 256; value++ ) {
+        char number_str[ 128 ];
+        AnalyzerHelpers::GetNumberString( value, display_base, 8, number_str, 128 );
+        value_strings[ value ] = number_str;
+    }
+
+    U32 num_threads = std::thread::hardware_concurrency();
+    num_threads = std::max( 1U, std::min( num_threads, ( U32 )MaxExportThreads ) );
+
+    bool multi_bus = this->mBusChannels.size() > 1;
+    if( multi_bus )
+        file_stream << MELIBUFormat::BusColumnHeader();
+    file_stream << MELIBUFormat::ByteRowHeader();
 
     U64 num_frames = GetNumFrames();
-    for( U32 i = 0; i < num_frames; i++ ) {
-        Frame frame = GetFrame( i );
-        if( frame.mType != MELIBUAnalyzerResults::NoFrame ) {
-            std::string frame_type =
-                FrameTypeToString( static_cast < MELIBUAnalyzerResults::tMELIBUFrameState > ( frame.mType ) ).c_str();
+    std::vector < Frame > frames;
+    std::vector < std::string > rows( num_threads );
+    for( U64 first = 0; first < num_frames; first += ExportChunkFrames ) {
+        size_t count = ( size_t )std::min < U64 >( ExportChunkFrames, num_frames - first );
+        frames.clear(); // Frame of the SDK has no assignment operator of its own
+        for( size_t i = 0; i < count; i++ )
+            frames.push_back( GetFrame( first + i ) );
+
+        size_t part = ( count + num_threads - 1 ) / num_threads;
+        std::vector < std::thread > workers;
+        for( U32 t = 1; t < num_threads && t * part < count; t++ ) {
+            workers.push_back( std::thread( FormatExportRows, std::cref( frames ), t * part, std::min( count, ( t + 1 ) * part ),
+                                            trigger_sample, sample_rate, multi_bus, std::cref( value_strings ), std::ref( rows[ t ] ) ) );
+        }
+        FormatExportRows( frames, 0, std::min( count, part ), trigger_sample, sample_rate, multi_bus, value_strings, rows[ 0 ] );
+        for( auto& worker : workers )
+            worker.join();
 
-            char time_str[ 128 ];
-            AnalyzerHelpers::GetTimeString( frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str,
-                                            128 );
+        for( U32 t = 0; t < workers.size() + 1; t++ )
+            file_stream.write( rows[ t ].data(), rows[ t ].size() );
 
-            char number_str[ 128 ];
-            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 128 );
+        if( UpdateExportProgressAndCheckForCancel( first + count, num_frames ) == true ) {
+            file_stream.close();
+            return;
+        }
+    }
+
+    file_stream.close();
+}
+
+void MELIBUAnalyzerResults::GeneratePacketExportFile( const char* file ) {
+    std::ofstream file_stream( file, std::ios::out );
 
-            file_stream << frame_type << "," << time_str << "," << number_str << ",";
+    U64 trigger_sample = this->mAnalyzer->GetTriggerSample();
+    U32 sample_rate = this->mAnalyzer->GetSampleRate();
 
-            auto flag_strings = FrameFlagsToString( frame.mFlags );
-            for( const auto& flag_string : flag_strings ) {
-                file_stream << flag_string << " ";
-            }
-            file_stream << std::endl;
+    bool multi_bus = this->mBusChannels.size() > 1;
+    if( multi_bus )
+        file_stream << MELIBUFormat::BusColumnHeader();
+    file_stream << MELIBUFormat::PacketRowHeader();
+
+    U64 num_packets = this->mPackets.Count();
+    std::vector < MELIBUPacketSummary > packets;
+    std::vector < U8 > payload;
+    std::string rows;
+    for( U64 first = 0; first < num_packets; first += ExportChunkPackets ) {
+        this->mPackets.Copy( first, ExportChunkPackets, packets, payload );
+        rows.clear();
+        for( const auto& packet : packets ) {
+            if( multi_bus )
+                MELIBUFormat::AppendBusColumn( rows, packet.mBus );
+            MELIBUFormat::AppendPacketRow( rows, packet, payload.data() + packet.mPayloadOffset, trigger_sample, sample_rate );
         }
-        if( UpdateExportProgressAndCheckForCancel( i, num_frames ) == true ) {
+        file_stream.write( rows.data(), rows.size() );
+
+        if( UpdateExportProgressAndCheckForCancel( first + packets.size(), num_packets ) == true ) {
             file_stream.close();
             return;
         }
@@ -188,21 +318,58 @@ void MELIBUAnalyzerResults::GenerateExportFile( const char* file, DisplayBase di
     file_stream.close();
 }
 
+// statistics are small; whole file is formatted from one copy of counters
+void MELIBUAnalyzerResults::GenerateStatisticsExportFile( const char* file ) {
+    std::ofstream file_stream( file, std::ios::out );
+
+    std::vector < MELIBUBusCounters > buses;
+    this->mStatistics.Copy( buses );
+    std::string text;
+    MELIBUFormat::AppendStatistics( text, buses, this->mAnalyzer->GetTriggerSample(), this->mAnalyzer->GetSampleRate() );
+    file_stream.write( text.data(), text.size() );
+    UpdateExportProgressAndCheckForCancel( 1, 1 );
+
+    file_stream.close();
+}
+
+void MELIBUAnalyzerResults::AddPacketRecord( const MELIBUPacketRecord& packet, U64 packet_id ) {
+    this->mPackets.Add( packet, packet_id );
+}
+
+MELIBUBusStatistics& MELIBUAnalyzerResults::Statistics() {
+    return this->mStatistics;
+}
+
 void MELIBUAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base ) {
 #ifdef SUPPORTS_PROTOCOL_SEARCH
-    /*Frame frame = GetFrame( frame_index );
-     * ClearTabularText();
-     *
-     * char number_str[128];
-     * AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 128 );
-     * AddTabularText( number_str );*/
     ClearTabularText();
+    Frame frame = GetFrame( frame_index );
+
+    // same text as longest bubble text
+    BubbleText bubble;
+    BuildBubbleText( frame, display_base, bubble );
+    if( bubble.mCount != 0 )
+        AddTabularText( bubble.mStrings[ bubble.mCount - 1 ].c_str() );
 #endif
 }
 
+// one row per message, built from message record kept during decoding; byte frames are not read
 void MELIBUAnalyzerResults::GeneratePacketTabularText( U64 packet_id, DisplayBase display_base ) {
-    //not supported
+    ClearTabularText();
 
+    MELIBUPacketSummary packet;
+    U8 data[ MELIBUPacketRecord::MaxDataBytes ];
+    if( !this->mPackets.Find( packet_id, packet, data ) )
+        return;
+
+    std::string text;
+    if( this->mBusChannels.size() > 1 ) {
+        text += "Bus ";
+        text += std::to_string( ( U32 )packet.mBus + 1 );
+        text += " | ";
+    }
+    MELIBUFormat::AppendPacketSummary( text, packet, data );
+    AddTabularText( text.c_str() );
 }
 
 void MELIBUAnalyzerResults::GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base ) {
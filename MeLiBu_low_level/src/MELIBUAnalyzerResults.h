@@ -2,6 +2,13 @@
 #define MELIBU_ANALYZER_RESULTS
 
 #include <AnalyzerResults.h>
+#include "MELIBUDecoder.h"
+#include "MELIBUPacketStore.h"
+#include "MELIBUBusStatistics.h"
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <vector>
 
 class MELIBUAnalyzer;
 class MELIBUAnalyzerSettings;
@@ -10,33 +17,11 @@ class MELIBUAnalyzerResults: public AnalyzerResults
 {
  public:
     typedef enum {
-        NoFrame = 0,
-        // Header
-        headerBreak,
-        headerID1,
-        headerID2,
-        // Instruction
-        instruction1,
-        instruction2,
-        // Response
-        responseDataZero,
-        responseData,
-        responseCRC1,
-        responseCRC2,
-        responseACK
-
-    } tMELIBUFrameState;
+        exportBytes = 0,   // one row per byte field
+        exportMessages = 1,  // one row per message
+        exportStatistics = 2 // bus statistics counted while decoding
+    } tMELIBUExportFormat;
 
-    typedef enum {
-        Okay = 0x00,
-        byteFramingError = 0x01,
-        headerBreakExpected = 0x02,
-        crcMismatch = 0x04,
-        receptionFailed = 0x08,
-        headerToggling = 0x10
-    } tMELIBUFrameFlags;
-
- public:
     MELIBUAnalyzerResults( MELIBUAnalyzer * analyzer, MELIBUAnalyzerSettings * settings );
     virtual ~MELIBUAnalyzerResults();
 
@@ -47,11 +32,39 @@ class MELIBUAnalyzerResults: public AnalyzerResults
     virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base );
     virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base );
 
+    void AddPacketRecord( const MELIBUPacketRecord& packet, U64 packet_id ); // keep message for export and tabular view
+    MELIBUBusStatistics& Statistics(); // updated by analyzer thread
+
  protected: //functions
+    // up to three bubble strings, from shortest to longest
+    struct BubbleText
+    {
+        BubbleText() : mCount( 0 ) {}
+        void Add( const char* str ) {
+            this->mStrings[ this->mCount++ ] = str;
+        }
+
+        std::string mStrings[ 3 ];
+        U32 mCount;
+    };
+    enum { MaxBubbleCacheSize = 65536 };
+    enum { ExportChunkFrames = 65536, ExportChunkPackets = 8192, MaxExportThreads = 8 };
+
+    void BuildBubbleText( const Frame& frame, DisplayBase display_base, BubbleText& bubble );
+    void GeneratePacketExportFile( const char* file );
+    void GenerateStatisticsExportFile( const char* file );
 
  protected: //vars
     MELIBUAnalyzerSettings* mSettings;
     MELIBUAnalyzer* mAnalyzer;
+    std::vector < Channel > mBusChannels; // index is bus number of frames (bits 8-15 of mData2)
+
+    // key: frame type, value, data index, flags and display base
+    std::unordered_map < U64, BubbleText > mBubbleCache;
+    std::mutex mBubbleCacheMutex;
+
+    MELIBUPacketStore mPackets;
+    MELIBUBusStatistics mStatistics;
 };
 
 #endif //MELIBU_ANALYZER_RESULTS
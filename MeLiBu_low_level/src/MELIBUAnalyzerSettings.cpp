@@ -1,4 +1,12 @@
 #include "MELIBUAnalyzerSettings.h"
+#include "MELIBUFrameLayout.h"
+#include "MELIBUDecoder.h"
+#include "MELIBUCommitScheduler.h"
+#include "MELIBUSegmentDecoder.h"
+#include "MELIBUAnalyzerResults.h"
+#include "MELIBUSimulationDataGenerator.h"
+#include "MELIBUSignalLayout.h"
+#include "MELIBUAnalyzer.h"
 #include <AnalyzerHelpers.h>
 #include <Analyzer.h>
 
@@ -17,20 +25,47 @@
 MELIBUAnalyzerSettings::MELIBUAnalyzerSettings()
     : mInputChannel( UNDEFINED_CHANNEL ),
     mBitRate{ 1000000 },
+    mAutoBitRate( false ),
     mMELIBUVersion( 1.0 ),
     mACK( false ),
-    mACKValue( 0x7e ) {
+    mACKValue( 0x7e ),
+    mByteDecoder( MELIBUDecoderSettings::byteDecoderSampling ),
+    mMarkerLevel( MELIBUDecoderSettings::markersAllBits ),
+    mCommitPolicy( MELIBUCommitScheduler::policyLive ),
+    mDecodeMode( MELIBUSegmentDecoder::decodeSequential ),
+    mExportFormat( MELIBUAnalyzerResults::exportBytes ),
+    mStatisticsInterval( 0 ),
+    mTableRows( MELIBUAnalyzer::tableBytes ),
+    mSimulationSource( MELIBUSimulationDataGenerator::simulationCsv ),
+    mSimulationBusLoad( 50 ),
+    mSimulationFaults( 0 ) {
 
     mInputChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
     mInputChannelInterface->SetTitleAndTooltip( "Serial", "Standard MeLiBu analyzer" );
     mInputChannelInterface->SetChannel( mInputChannel );
 
+    for( U32 i = 0; i < MaxBuses - 1; i++ ) {
+        std::string title = "Bus " + std::to_string( i + 2 );
+        mBusChannels[ i ] = UNDEFINED_CHANNEL;
+        mBusChannelInterfaces[ i ].reset( new AnalyzerSettingInterfaceChannel() );
+        mBusChannelInterfaces[ i ]->SetTitleAndTooltip( title.c_str(), "Optional channel of another MeLiBu bus decoded with the same settings" );
+        mBusChannelInterfaces[ i ]->SetChannel( mBusChannels[ i ] );
+        mBusChannelInterfaces[ i ]->SetSelectionOfNoneIsAllowed( true );
+    }
+
     mBitRateInterface.reset( new AnalyzerSettingInterfaceInteger() );
     mBitRateInterface->SetTitleAndTooltip( "Bit Rate (Bits/S)",  "Specify the bit rate in bits per second." );
     mBitRateInterface->SetMax( 6000000 );
     mBitRateInterface->SetMin( 1 );
     mBitRateInterface->SetInteger( mBitRate );
 
+    mAutoBitRateInterface.reset( new AnalyzerSettingInterfaceBool() );
+    mAutoBitRateInterface->SetTitleAndTooltip( "Bit rate detection",
+                                               "Measure bit rate from break fields and bit lengths at start of capture; "
+                                               "bit rate above is used if there is not enough traffic." );
+    mAutoBitRateInterface->SetCheckBoxText( "Detect bit rate" );
+    mAutoBitRateInterface->SetValue( mAutoBitRate );
+
     mMELIBUVersionInterface.reset( new AnalyzerSettingInterfaceNumberList() );
     mMELIBUVersionInterface->SetTitleAndTooltip( "MeLiBu Version", "Specify the MeLiBu protocol version 1 or 2." );
     mMELIBUVersionInterface->AddNumber( 1.0, "MeLiBu 1", "MeLiBu Protocol Specification Version 1, normal mode" );
@@ -54,11 +89,132 @@ MELIBUAnalyzerSettings::MELIBUAnalyzerSettings()
     mAckValueInterface->SetTextType( AnalyzerSettingInterfaceText::NormalText );
     mAckValueInterface->SetText( s.str().c_str() );
 
+    mByteDecoderInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mByteDecoderInterface->SetTitleAndTooltip( "Byte decoder", "Select how data bits are read from the channel." );
+    mByteDecoderInterface->AddNumber( MELIBUDecoderSettings::byteDecoderSampling,
+                                      "Bit sampling",
+                                      "Advance to the middle of each bit and sample it" );
+    mByteDecoderInterface->AddNumber( MELIBUDecoderSettings::byteDecoderEdges,
+                                      "Edge run length",
+                                      "Reconstruct bytes from edge positions; faster on long captures at high bit rates" );
+    mByteDecoderInterface->AddNumber( MELIBUDecoderSettings::byteDecoderTracking,
+                                      "Edge tracking (3x oversampling)",
+                                      "Reconstruct bytes from edge positions and resynchronize bit clock on every edge; "
+                                      "needs only 3 samples per bit, so captures at high bit rates can be longer" );
+    mByteDecoderInterface->SetNumber( mByteDecoder );
+
+    mMarkerLevelInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mMarkerLevelInterface->SetTitleAndTooltip( "Markers", "Select which bits are marked on the channel." );
+    mMarkerLevelInterface->AddNumber( MELIBUDecoderSettings::markersAllBits, "All bits", "Mark every sampled bit and errors" );
+    mMarkerLevelInterface->AddNumber( MELIBUDecoderSettings::markersStartStop,
+                                      "Errors and start/stop bits",
+                                      "Mark start and stop bits and errors" );
+    mMarkerLevelInterface->AddNumber( MELIBUDecoderSettings::markersErrors,
+                                      "Errors only",
+                                      "Mark errors only; recommended for long captures" );
+    mMarkerLevelInterface->SetNumber( mMarkerLevel );
+
+    mCommitPolicyInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mCommitPolicyInterface->SetTitleAndTooltip( "Result updates", "Select how often decoded results are shown while decoding." );
+    mCommitPolicyInterface->AddNumber( MELIBUCommitScheduler::policyLive,
+                                       "Live",
+                                       "Show results after every message; for running captures" );
+    mCommitPolicyInterface->AddNumber( MELIBUCommitScheduler::policyThroughput,
+                                       "Throughput",
+                                       "Show results in large batches; fastest decode of recorded captures" );
+    mCommitPolicyInterface->SetNumber( mCommitPolicy );
+
+    mDecodeModeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mDecodeModeInterface->SetTitleAndTooltip( "Decoding", "Select how the capture is decoded." );
+    mDecodeModeInterface->AddNumber( MELIBUSegmentDecoder::decodeSequential,
+                                     "Sequential",
+                                     "Decode while capturing; one thread" );
+    mDecodeModeInterface->AddNumber( MELIBUSegmentDecoder::decodeSegments,
+                                     "Parallel segments",
+                                     "Cut recorded capture at break fields and decode parts on all cores; "
+                                     "for long recorded captures with one bus" );
+    mDecodeModeInterface->SetNumber( mDecodeMode );
+
+    mExportFormatInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mExportFormatInterface->SetTitleAndTooltip( "Export format", "Select content of exported txt/csv file." );
+    mExportFormatInterface->AddNumber( MELIBUAnalyzerResults::exportBytes, "Byte rows", "One row per break, header, data, crc and ack field" );
+    mExportFormatInterface->AddNumber( MELIBUAnalyzerResults::exportMessages,
+                                       "Message rows",
+                                       "One row per message with IDs, instruction, payload, crc, ack and errors" );
+    mExportFormatInterface->AddNumber( MELIBUAnalyzerResults::exportStatistics,
+                                       "Statistics",
+                                       "Bus load, messages per ID, errors, gap and length histograms" );
+    mExportFormatInterface->SetNumber( mExportFormat );
+
+    mStatisticsIntervalInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mStatisticsIntervalInterface->SetTitleAndTooltip( "Statistics rows",
+                                                      "Add table row with bus load, messages and errors of each interval; "
+                                                      "interval is also used for bus load in statistics export" );
+    mStatisticsIntervalInterface->AddNumber( 0, "Off", "No statistics rows; statistics export uses 1 s intervals" );
+    mStatisticsIntervalInterface->AddNumber( 100, "Every 100 ms", "One row per bus every 100 ms of capture time" );
+    mStatisticsIntervalInterface->AddNumber( 1000, "Every second", "One row per bus every second of capture time" );
+    mStatisticsIntervalInterface->AddNumber( 10000, "Every 10 seconds", "One row per bus every 10 s of capture time" );
+    mStatisticsIntervalInterface->SetNumber( mStatisticsInterval );
+
+    mSignalLayoutInterface.reset( new AnalyzerSettingInterfaceText() );
+    mSignalLayoutInterface->SetTitleAndTooltip( "Signal layout",
+                                                "Optional layout file written by mbdf_to_layout.py; "
+                                                "adds table rows with raw and physical value of each signal" );
+    mSignalLayoutInterface->SetTextType( AnalyzerSettingInterfaceText::FilePath );
+    mSignalLayoutInterface->SetText( mSignalLayoutFile.c_str() );
+
+    mTableRowsInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mTableRowsInterface->SetTitleAndTooltip( "Table rows", "Select rows passed to data table and high level analyzers." );
+    mTableRowsInterface->AddNumber( MELIBUAnalyzer::tableBytes, "Byte rows", "One row per break, header, data, crc and ack field" );
+    mTableRowsInterface->AddNumber( MELIBUAnalyzer::tablePackets,
+                                    "Message rows",
+                                    "One packet row per message with IDs, instruction, payload, crc and ack; "
+                                    "fastest with high level analyzers" );
+    mTableRowsInterface->AddNumber( MELIBUAnalyzer::tableBytesAndPackets, "Byte and message rows", "Byte rows and packet rows" );
+    mTableRowsInterface->SetNumber( mTableRows );
+
+    mSimulationSourceInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mSimulationSourceInterface->SetTitleAndTooltip( "Simulation data", "Select source of messages in simulation mode." );
+    mSimulationSourceInterface->AddNumber( MELIBUSimulationDataGenerator::simulationCsv,
+                                           "simulated_data.csv",
+                                           "Repeat messages listed in simulated_data.csv" );
+    mSimulationSourceInterface->AddNumber( MELIBUSimulationDataGenerator::simulationSynthetic,
+                                           "Synthetic traffic",
+                                           "Random messages with valid crc at selected bus load" );
+    mSimulationSourceInterface->SetNumber( mSimulationSource );
+
+    mSimulationBusLoadInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mSimulationBusLoadInterface->SetTitleAndTooltip( "Simulated bus load (%)", "Share of bus time used by synthetic messages." );
+    mSimulationBusLoadInterface->SetMax( 100 );
+    mSimulationBusLoadInterface->SetMin( 1 );
+    mSimulationBusLoadInterface->SetInteger( mSimulationBusLoad );
+
+    mSimulationFaultsInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mSimulationFaultsInterface->SetTitleAndTooltip( "Simulated faults (%)",
+                                                    "Share of synthetic messages with crc, framing or missing byte fault." );
+    mSimulationFaultsInterface->SetMax( 100 );
+    mSimulationFaultsInterface->SetMin( 0 );
+    mSimulationFaultsInterface->SetInteger( mSimulationFaults );
+
     AddInterface( mInputChannelInterface.get() );
+    for( U32 i = 0; i < MaxBuses - 1; i++ )
+        AddInterface( mBusChannelInterfaces[ i ].get() );
     AddInterface( mBitRateInterface.get() );
+    AddInterface( mAutoBitRateInterface.get() );
     AddInterface( mMELIBUVersionInterface.get() );
     AddInterface( mMELIBUAckEnabledInterface.get() );
     AddInterface( mAckValueInterface.get() );
+    AddInterface( mByteDecoderInterface.get() );
+    AddInterface( mMarkerLevelInterface.get() );
+    AddInterface( mCommitPolicyInterface.get() );
+    AddInterface( mDecodeModeInterface.get() );
+    AddInterface( mExportFormatInterface.get() );
+    AddInterface( mStatisticsIntervalInterface.get() );
+    AddInterface( mSignalLayoutInterface.get() );
+    AddInterface( mTableRowsInterface.get() );
+    AddInterface( mSimulationSourceInterface.get() );
+    AddInterface( mSimulationBusLoadInterface.get() );
+    AddInterface( mSimulationFaultsInterface.get() );
 
     // no effect when calling these 4 functions
     // custom export options are not supported in V2
@@ -75,10 +231,38 @@ MELIBUAnalyzerSettings::~MELIBUAnalyzerSettings() {}
 
 bool MELIBUAnalyzerSettings::SetSettingsFromInterfaces() {
     // set vars from UI
-    this->mInputChannel = this->mInputChannelInterface->GetChannel();
+    Channel input_channel = this->mInputChannelInterface->GetChannel();
+    Channel bus_channels[ MaxBuses - 1 ];
+    for( U32 i = 0; i < MaxBuses - 1; i++ ) {
+        bus_channels[ i ] = this->mBusChannelInterfaces[ i ]->GetChannel();
+        if( bus_channels[ i ] == UNDEFINED_CHANNEL )
+            continue;
+        bool used = bus_channels[ i ] == input_channel;
+        for( U32 j = 0; j < i; j++ )
+            used = used || bus_channels[ i ] == bus_channels[ j ];
+        if( used ) {
+            SetErrorText( "Each bus needs its own channel." );
+            return false;
+        }
+    }
+    this->mInputChannel = input_channel;
+    for( U32 i = 0; i < MaxBuses - 1; i++ )
+        this->mBusChannels[ i ] = bus_channels[ i ];
     this->mACK = this->mMELIBUAckEnabledInterface->GetValue();
     this->mBitRate = this->mBitRateInterface->GetInteger();
+    this->mAutoBitRate = this->mAutoBitRateInterface->GetValue();
     this->mMELIBUVersion = this->mMELIBUVersionInterface->GetNumber();
+    this->mByteDecoder = this->mByteDecoderInterface->GetNumber();
+    this->mMarkerLevel = this->mMarkerLevelInterface->GetNumber();
+    this->mCommitPolicy = this->mCommitPolicyInterface->GetNumber();
+    this->mDecodeMode = this->mDecodeModeInterface->GetNumber();
+    this->mExportFormat = this->mExportFormatInterface->GetNumber();
+    this->mStatisticsInterval = this->mStatisticsIntervalInterface->GetNumber();
+    this->mSignalLayoutFile = this->mSignalLayoutInterface->GetText();
+    this->mTableRows = this->mTableRowsInterface->GetNumber();
+    this->mSimulationSource = this->mSimulationSourceInterface->GetNumber();
+    this->mSimulationBusLoad = this->mSimulationBusLoadInterface->GetInteger();
+    this->mSimulationFaults = this->mSimulationFaultsInterface->GetInteger();
     try
     {
         // hex format
@@ -101,17 +285,39 @@ bool MELIBUAnalyzerSettings::SetSettingsFromInterfaces() {
     //outfile << python_script_path << "\n-------------\n";
     // outfile.close();
 
-    ClearChannels();
-    AddChannel( this->mInputChannel, "MeLiBu analyzer", true );
+    // build frame layout table for selected version now, not when decoding starts
+    MELIBUFrameLayoutTable::Get( MELIBUProtocol::FromVersion( this->mMELIBUVersion ) );
+
+    std::string error;
+    if( !LoadSignalLayout( error ) ) {
+        SetErrorText( error.c_str() );
+        return false;
+    }
+
+    UpdateChannels();
 
     return true;
 }
 
 void MELIBUAnalyzerSettings::UpdateInterfacesFromSettings() {
     this->mInputChannelInterface->SetChannel( this->mInputChannel );
+    for( U32 i = 0; i < MaxBuses - 1; i++ )
+        this->mBusChannelInterfaces[ i ]->SetChannel( this->mBusChannels[ i ] );
     this->mBitRateInterface->SetInteger( this->mBitRate );
+    this->mAutoBitRateInterface->SetValue( this->mAutoBitRate );
     this->mMELIBUVersionInterface->SetNumber( this->mMELIBUVersion );
     this->mMELIBUAckEnabledInterface->SetValue( this->mACK );
+    this->mByteDecoderInterface->SetNumber( this->mByteDecoder );
+    this->mMarkerLevelInterface->SetNumber( this->mMarkerLevel );
+    this->mCommitPolicyInterface->SetNumber( this->mCommitPolicy );
+    this->mDecodeModeInterface->SetNumber( this->mDecodeMode );
+    this->mExportFormatInterface->SetNumber( this->mExportFormat );
+    this->mStatisticsIntervalInterface->SetNumber( this->mStatisticsInterval );
+    this->mSignalLayoutInterface->SetText( this->mSignalLayoutFile.c_str() );
+    this->mTableRowsInterface->SetNumber( this->mTableRows );
+    this->mSimulationSourceInterface->SetNumber( this->mSimulationSource );
+    this->mSimulationBusLoadInterface->SetInteger( this->mSimulationBusLoad );
+    this->mSimulationFaultsInterface->SetInteger( this->mSimulationFaults );
     std::stringstream s;
     s << std::hex << std::uppercase << std::showbase << mACKValue;
     this->mAckValueInterface->SetText( s.str().c_str() );
@@ -125,9 +331,38 @@ void MELIBUAnalyzerSettings::LoadSettings( const char* settings ) {
     text_archive >> this->mBitRate;
     text_archive >> this->mMELIBUVersion;
     text_archive >> this->mACK;
+    if( !( text_archive >> this->mByteDecoder ) ) // not stored by older versions
+        this->mByteDecoder = MELIBUDecoderSettings::byteDecoderSampling;
+    if( !( text_archive >> this->mMarkerLevel ) )
+        this->mMarkerLevel = MELIBUDecoderSettings::markersAllBits;
+    if( !( text_archive >> this->mCommitPolicy ) )
+        this->mCommitPolicy = MELIBUCommitScheduler::policyLive;
+    if( !( text_archive >> this->mExportFormat ) )
+        this->mExportFormat = MELIBUAnalyzerResults::exportBytes;
+    if( !( text_archive >> this->mSimulationSource ) )
+        this->mSimulationSource = MELIBUSimulationDataGenerator::simulationCsv;
+    S32 bus_load, faults;
+    this->mSimulationBusLoad = ( text_archive >> bus_load ) ? bus_load : 50;
+    this->mSimulationFaults = ( text_archive >> faults ) ? faults : 0;
+    if( !( text_archive >> this->mAutoBitRate ) )
+        this->mAutoBitRate = false;
+    for( U32 i = 0; i < MaxBuses - 1; i++ )
+        if( !( text_archive >> this->mBusChannels[ i ] ) )
+            this->mBusChannels[ i ] = UNDEFINED_CHANNEL;
+    if( !( text_archive >> this->mDecodeMode ) )
+        this->mDecodeMode = MELIBUSegmentDecoder::decodeSequential;
+    if( !( text_archive >> this->mStatisticsInterval ) )
+        this->mStatisticsInterval = 0;
+    const char* signal_layout_file;
+    this->mSignalLayoutFile = ( text_archive >> &signal_layout_file ) ? signal_layout_file : "";
+    if( !( text_archive >> this->mTableRows ) )
+        this->mTableRows = MELIBUAnalyzer::tableBytes;
+    // layout file may have been moved since settings were saved; decode without signals then
+    std::string error;
+    if( !LoadSignalLayout( error ) )
+        this->mSignalLayout.reset();
 
-    ClearChannels();
-    AddChannel( this->mInputChannel, "MeLiBu analyzer", true );
+    UpdateChannels();
 }
 
 const char* MELIBUAnalyzerSettings::SaveSettings() {
@@ -137,6 +372,55 @@ const char* MELIBUAnalyzerSettings::SaveSettings() {
     text_archive << this->mBitRate;
     text_archive << this->mMELIBUVersion;
     text_archive << this->mACK;
+    text_archive << this->mByteDecoder;
+    text_archive << this->mMarkerLevel;
+    text_archive << this->mCommitPolicy;
+    text_archive << this->mExportFormat;
+    text_archive << this->mSimulationSource;
+    text_archive << ( S32 )this->mSimulationBusLoad;
+    text_archive << ( S32 )this->mSimulationFaults;
+    text_archive << this->mAutoBitRate;
+    for( U32 i = 0; i < MaxBuses - 1; i++ )
+        text_archive << this->mBusChannels[ i ];
+    text_archive << this->mDecodeMode;
+    text_archive << this->mStatisticsInterval;
+    text_archive << this->mSignalLayoutFile.c_str();
+    text_archive << this->mTableRows;
 
     return SetReturnString( text_archive.GetString() );
 }
+
+std::vector < Channel > MELIBUAnalyzerSettings::BusChannels() const {
+    std::vector < Channel > channels( 1, this->mInputChannel );
+    for( U32 i = 0; i < MaxBuses - 1; i++ )
+        if( this->mBusChannels[ i ] != UNDEFINED_CHANNEL )
+            channels.push_back( this->mBusChannels[ i ] );
+    return channels;
+}
+
+bool MELIBUAnalyzerSettings::LoadSignalLayout( std::string& error ) {
+    this->mSignalLayout.reset();
+    if( this->mSignalLayoutFile.empty() )
+        return true;
+
+    std::shared_ptr < MELIBUSignalLayout > layout( new MELIBUSignalLayout() );
+    if( !layout->Load( this->mSignalLayoutFile.c_str(), error ) )
+        return false;
+    // MeLiBu 1 normal and extended mode share the same frames
+    if( ( layout->Version() < 2.0 ) != ( this->mMELIBUVersion < 2.0 ) ) {
+        error = "Signal layout is for another MeLiBu version.";
+        return false;
+    }
+    this->mSignalLayout = layout;
+    return true;
+}
+
+void MELIBUAnalyzerSettings::UpdateChannels() {
+    ClearChannels();
+    AddChannel( this->mInputChannel, "MeLiBu analyzer", true );
+    for( U32 i = 0; i < MaxBuses - 1; i++ ) {
+        std::string name = "MeLiBu bus " + std::to_string( i + 2 );
+        if( this->mBusChannels[ i ] != UNDEFINED_CHANNEL )
+            AddChannel( this->mBusChannels[ i ], name.c_str(), true );
+    }
+}
@@ -8,6 +8,11 @@
 #include <map>
 #include <iterator>
 #include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+
+class MELIBUSignalLayout;
 
 class MELIBUAnalyzerSettings: public AnalyzerSettings
 {
@@ -22,19 +27,54 @@ class MELIBUAnalyzerSettings: public AnalyzerSettings
     virtual const char* SaveSettings();
     void UpdateInterfacesFromSettings();
 
+    // input channel is bus 1; further buses are optional channels decoded with the same settings
+    static const U32 MaxBuses = 8;
+    std::vector < Channel > BusChannels() const; // input channel first, then selected bus channels
+
+    bool LoadSignalLayout( std::string& error ); // loads mSignalLayoutFile into mSignalLayout
+
     // variables to store UI inputs
     Channel mInputChannel;
+    Channel mBusChannels[ MaxBuses - 1 ]; // buses 2 to MaxBuses; UNDEFINED_CHANNEL if not used
     U32 mBitRate;
+    bool mAutoBitRate; // detect bit rate from start of capture; mBitRate is used if detection fails
     double mMELIBUVersion;
     bool mACK;
     int mACKValue;
+    U32 mByteDecoder; // MELIBUDecoderSettings::tMELIBUByteDecoder
+    U32 mMarkerLevel; // MELIBUDecoderSettings::tMELIBUMarkerLevel
+    U32 mCommitPolicy; // MELIBUCommitScheduler::tMELIBUCommitPolicy
+    U32 mDecodeMode;   // MELIBUSegmentDecoder::tMELIBUDecodeMode
+    U32 mExportFormat; // MELIBUAnalyzerResults::tMELIBUExportFormat
+    U32 mStatisticsInterval; // ms between statistics summary rows; 0 if off
+    std::string mSignalLayoutFile; // signal layout compiled from MBDF; empty if off
+    std::shared_ptr < const MELIBUSignalLayout > mSignalLayout; // loaded from mSignalLayoutFile; null if off
+    U32 mTableRows;    // MELIBUAnalyzer::tMELIBUTableRows
+    U32 mSimulationSource; // MELIBUSimulationDataGenerator::tMELIBUSimulationSource
+    int mSimulationBusLoad; // percent; synthetic simulation only
+    int mSimulationFaults;  // percent of messages with crc, framing or missing byte fault; synthetic simulation only
 
  protected:
+    void UpdateChannels();
+
     std::auto_ptr < AnalyzerSettingInterfaceChannel > mInputChannelInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceChannel > mBusChannelInterfaces[ MaxBuses - 1 ];
     std::auto_ptr < AnalyzerSettingInterfaceNumberList > mMELIBUVersionInterface;
     std::auto_ptr < AnalyzerSettingInterfaceInteger > mBitRateInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceBool > mAutoBitRateInterface;
     std::auto_ptr < AnalyzerSettingInterfaceBool > mMELIBUAckEnabledInterface;
     std::auto_ptr < AnalyzerSettingInterfaceText > mAckValueInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mByteDecoderInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mMarkerLevelInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mCommitPolicyInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mDecodeModeInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mExportFormatInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mStatisticsIntervalInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceText > mSignalLayoutInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mTableRowsInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceNumberList > mSimulationSourceInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceInteger > mSimulationBusLoadInterface;
+    std::auto_ptr < AnalyzerSettingInterfaceInteger > mSimulationFaultsInterface;
 };
 
 #endif //MELIBU_ANALYZER_SETTINGS
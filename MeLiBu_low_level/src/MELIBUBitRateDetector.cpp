@@ -0,0 +1,107 @@
+#include "MELIBUBitRateDetector.h"
+#include "MELIBUChannel.h"
+#include <algorithm>
+#include <math.h>
+
+MELIBUBitRateDetector::MELIBUBitRateDetector() : mInitialHigh( true ), mStartSample( 0 ) {}
+
+MELIBUBitRateDetector::~MELIBUBitRateDetector() {}
+
+void MELIBUBitRateDetector::Record( MELIBUChannel* channel ) {
+    this->mEdges.clear();
+    this->mStartSample = channel->GetSampleNumber();
+    this->mInitialHigh = channel->IsHigh();
+    while( this->mEdges.size() < MaxEdges && channel->MoreEdgesAvailable() ) {
+        channel->AdvanceToNextEdge();
+        this->mEdges.push_back( channel->GetSampleNumber() );
+    }
+}
+
+U32 MELIBUBitRateDetector::Detect( U32 sample_rate_hz ) {
+    // runs between recorded edges; run after edge i is low if initial state was high and i is even
+    this->mHistogram.clear();
+    std::vector < U64 > delimiters; // high runs after break fields
+    U32 runs = 0;
+    for( size_t i = 0; i + 1 < this->mEdges.size(); i++ ) {
+        U64 length = this->mEdges[ i + 1 ] - this->mEdges[ i ];
+        this->mHistogram[ length ]++;
+        runs++;
+
+        bool low = this->mInitialHigh == ( ( i & 1 ) == 0 );
+        if( low && i + 2 < this->mEdges.size() ) {
+            U64 high_length = this->mEdges[ i + 2 ] - this->mEdges[ i + 1 ];
+            if( high_length > 0 && length >= 8 * high_length ) // break field: at least 11 low bits, then one high bit
+                delimiters.push_back( high_length );
+        }
+    }
+    if( runs < MinRuns )
+        return 0;
+
+    // first guess of one bit: most frequent run length (single bits are most frequent in data and 0x55 patterns)
+    U64 mode = 0;
+    U32 mode_count = 0;
+    for( auto& bin : this->mHistogram ) {
+        if( bin.second > mode_count ) {
+            mode = bin.first;
+            mode_count = bin.second;
+        }
+    }
+    double bit_length = ( double )mode;
+    // break delimiter is one bit for sure; prefer it if most frequent run is something else (e.g. long runs of 0x00)
+    if( !delimiters.empty() ) {
+        std::nth_element( delimiters.begin(), delimiters.begin() + delimiters.size() / 2, delimiters.end() );
+        double delimiter = ( double )delimiters[ delimiters.size() / 2 ];
+        if( bit_length < delimiter * 0.5 || bit_length > delimiter * 1.5 )
+            bit_length = delimiter;
+    }
+
+    // refine; allow longer runs step by step so that rounding to whole bits stays correct
+    const U32 max_bits[] = { 1, 2, 4, 9 };
+    for( U32 bits : max_bits ) {
+        bit_length = RefineBitLength( bit_length, bits );
+        if( bit_length == 0 )
+            return 0;
+    }
+    if( bit_length < 2.5 )
+        return 0; // too few samples per bit to measure
+
+    return RoundBitRate( sample_rate_hz / bit_length );
+}
+
+double MELIBUBitRateDetector::RefineBitLength( double bit_length, U32 max_bits ) {
+    U64 samples = 0;
+    U64 bits = 0;
+    for( auto& bin : this->mHistogram ) {
+        U64 run_bits = ( U64 )floor( bin.first / bit_length + 0.5 );
+        if( run_bits == 0 )
+            continue; // glitch
+        if( run_bits > max_bits )
+            break; // histogram is sorted by length
+        samples += bin.first * bin.second;
+        bits += run_bits * bin.second;
+    }
+    return ( bits == 0 ) ? 0 : ( double )samples / ( double )bits;
+}
+
+U32 MELIBUBitRateDetector::RoundBitRate( double bit_rate ) {
+    // snap to common bit rate if close; sender clocks are within a few percent
+    static const U32 common_rates[] = { 9600,   19200,   38400,   57600,   100000,  115200,  125000,  200000,  250000, 500000,
+                                        1000000, 1500000, 2000000, 2500000, 3000000, 4000000, 5000000, 6000000 };
+    for( U32 rate : common_rates ) {
+        if( fabs( bit_rate - rate ) <= rate * 0.02 )
+            return rate;
+    }
+    return ( U32 )( floor( bit_rate / 100 + 0.5 ) * 100 );
+}
+
+const std::vector < U64 >& MELIBUBitRateDetector::Edges() const {
+    return this->mEdges;
+}
+
+bool MELIBUBitRateDetector::InitialHigh() const {
+    return this->mInitialHigh;
+}
+
+U64 MELIBUBitRateDetector::StartSample() const {
+    return this->mStartSample;
+}
@@ -0,0 +1,44 @@
+#ifndef MELIBU_BIT_RATE_DETECTOR_H
+#define MELIBU_BIT_RATE_DETECTOR_H
+
+#include "MELIBUTypes.h"
+#include <map>
+#include <vector>
+
+class MELIBUChannel;
+
+// finds bit rate from low/high run lengths at start of capture
+// one bit is taken from break delimiters (high bit after 11/13 bit low break field) or from most frequent run length,
+// then refined over all runs that are whole multiples of it; recorded edges are kept so that decoding can start from the beginning
+class MELIBUBitRateDetector
+{
+ public:
+    enum {
+        MaxEdges = 4096, // edges read from start of capture; tens of messages
+        MinRuns = 16     // fewer runs can't give a reliable bit rate
+    };
+
+    MELIBUBitRateDetector();
+    ~MELIBUBitRateDetector();
+
+    // read edges from current sample on; stops at MaxEdges or when no more edges are captured (yet)
+    // channel is left at last recorded edge; use MELIBUBufferedChannel to decode recorded part again
+    void Record( MELIBUChannel* channel );
+    U32 Detect( U32 sample_rate_hz ); // detected bit rate; 0 if there is not enough traffic
+
+    const std::vector < U64 >& Edges() const;
+    bool InitialHigh() const;
+    U64 StartSample() const;
+
+ protected:
+    double RefineBitLength( double bit_length, U32 max_bits ); // average bit length over runs up to max_bits long
+    static U32 RoundBitRate( double bit_rate );
+
+ protected: //vars
+    std::vector < U64 > mEdges;
+    bool mInitialHigh;
+    U64 mStartSample;
+    std::map < U64, U32 > mHistogram; // run length in samples -> number of runs
+};
+
+#endif //MELIBU_BIT_RATE_DETECTOR_H
@@ -0,0 +1,77 @@
+#include "MELIBUBufferedChannel.h"
+#include "MELIBUInstrumentation.h"
+
+MELIBUBufferedChannel::MELIBUBufferedChannel( MELIBUChannel* channel,
+                                              const std::vector < U64 >& edges,
+                                              bool initial_high,
+                                              U64 start_sample )
+    :   mChannel( channel ),
+    mEdges( edges ),
+    mNextEdge( 0 ),
+    mInitialHigh( initial_high ),
+    mSample( start_sample ) {}
+
+MELIBUBufferedChannel::~MELIBUBufferedChannel() {}
+
+bool MELIBUBufferedChannel::Buffered() {
+    return this->mNextEdge < this->mEdges.size();
+}
+
+U64 MELIBUBufferedChannel::GetSampleNumber() {
+    return Buffered() ? this->mSample : this->mChannel->GetSampleNumber();
+}
+
+bool MELIBUBufferedChannel::IsHigh() {
+    if( !Buffered() )
+        return this->mChannel->IsHigh();
+    return ( this->mNextEdge & 1 ) ? !this->mInitialHigh : this->mInitialHigh;
+}
+
+U32 MELIBUBufferedChannel::Advance( U32 num_samples ) {
+    return AdvanceToAbsPosition( GetSampleNumber() + num_samples );
+}
+
+U32 MELIBUBufferedChannel::AdvanceToAbsPosition( U64 sample_number ) {
+    if( !Buffered() )
+        return this->mChannel->AdvanceToAbsPosition( sample_number );
+
+    U32 transitions { 0 };
+    while( Buffered() && this->mEdges[ this->mNextEdge ] <= sample_number ) {
+        this->mNextEdge++;
+        transitions++;
+    }
+    MELIBU_COUNT( counterChannelCalls, 1 );
+    MELIBU_COUNT( counterEdges, transitions ); // edges after buffer are counted by channel
+    if( !Buffered() )
+        return transitions + this->mChannel->AdvanceToAbsPosition( sample_number ); // channel is at last buffered edge
+    if( sample_number > this->mSample )
+        this->mSample = sample_number;
+    return transitions;
+}
+
+void MELIBUBufferedChannel::AdvanceToNextEdge() {
+    if( Buffered() ) {
+        MELIBU_COUNT( counterChannelCalls, 1 );
+        MELIBU_COUNT( counterEdges, 1 );
+        this->mSample = this->mEdges[ this->mNextEdge++ ];
+    } else
+        this->mChannel->AdvanceToNextEdge();
+}
+
+U64 MELIBUBufferedChannel::GetSampleOfNextEdge() {
+    return Buffered() ? this->mEdges[ this->mNextEdge ] : this->mChannel->GetSampleOfNextEdge();
+}
+
+bool MELIBUBufferedChannel::WouldAdvancingCauseTransition( U32 num_samples ) {
+    if( !Buffered() )
+        return this->mChannel->WouldAdvancingCauseTransition( num_samples );
+    return this->mEdges[ this->mNextEdge ] <= this->mSample + num_samples;
+}
+
+bool MELIBUBufferedChannel::AtEnd() {
+    return Buffered() ? false : this->mChannel->AtEnd();
+}
+
+bool MELIBUBufferedChannel::MoreEdgesAvailable() {
+    return Buffered() ? true : this->mChannel->MoreEdgesAvailable();
+}
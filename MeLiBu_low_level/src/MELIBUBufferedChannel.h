@@ -0,0 +1,40 @@
+#ifndef MELIBU_BUFFERED_CHANNEL_H
+#define MELIBU_BUFFERED_CHANNEL_H
+
+#include "MELIBUChannel.h"
+#include <vector>
+
+// plays back edges that were already read from a channel (e.g. by MELIBUBitRateDetector), then continues on the channel
+// channel data of Logic can't be rewound, so this is how the start of capture is decoded after it was inspected
+class MELIBUBufferedChannel: public MELIBUChannel
+{
+ public:
+    // edges were read from channel starting at start_sample with bit state initial_high; channel is at last of them
+    MELIBUBufferedChannel( MELIBUChannel* channel, const std::vector < U64 >& edges, bool initial_high, U64 start_sample );
+    virtual ~MELIBUBufferedChannel();
+
+    virtual U64 GetSampleNumber();
+    virtual bool IsHigh();
+
+    virtual U32 Advance( U32 num_samples );
+    virtual U32 AdvanceToAbsPosition( U64 sample_number );
+    virtual void AdvanceToNextEdge();
+
+    virtual U64 GetSampleOfNextEdge();
+    virtual bool WouldAdvancingCauseTransition( U32 num_samples );
+
+    virtual bool AtEnd();
+    virtual bool MoreEdgesAvailable();
+
+ protected:
+    bool Buffered(); // false after last buffered edge was passed; all calls go to channel then
+
+ protected: //vars
+    MELIBUChannel* mChannel;
+    const std::vector < U64 >& mEdges;
+    U64 mNextEdge; // index of first buffered edge after current sample
+    bool mInitialHigh;
+    U64 mSample;
+};
+
+#endif //MELIBU_BUFFERED_CHANNEL_H
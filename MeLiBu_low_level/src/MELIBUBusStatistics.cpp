@@ -0,0 +1,169 @@
+#include "MELIBUBusStatistics.h"
+#include <algorithm>
+#include <cstring>
+
+MELIBUBusCounters::MELIBUBusCounters()
+    :   mBytes( 0 ),
+    mPackets( 0 ),
+    mIncompletePackets( 0 ),
+    mMissingBytes( 0 ),
+    mBusySamples( 0 ),
+    mFirstSample( -1 ),
+    mLastSample( -1 ),
+    mGapCount( 0 ),
+    mGapSamplesSum( 0 ),
+    mGapSamplesMin( 0 ),
+    mGapSamplesMax( 0 ),
+    mLastPacketEnd( -1 ) {
+    memset( this->mFlagBytes, 0, sizeof( this->mFlagBytes ) );
+    memset( this->mFlagPackets, 0, sizeof( this->mFlagPackets ) );
+    memset( this->mGaps, 0, sizeof( this->mGaps ) );
+    memset( this->mLengths, 0, sizeof( this->mLengths ) );
+}
+
+MELIBUBusStatistics::MELIBUBusStatistics()
+    :   mIntervalSamples( 1 ),
+    mSamplesPerBit( 1.0 ) {}
+
+MELIBUBusStatistics::~MELIBUBusStatistics() {}
+
+void MELIBUBusStatistics::Setup( U32 sample_rate_hz, U32 bit_rate, U64 interval_samples, U32 num_buses ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    this->mBuses.assign( num_buses, MELIBUBusCounters() );
+    this->mNextInterval.assign( num_buses, 0 );
+    this->mIntervalSamples = std::max < U64 >( 1, interval_samples );
+    this->mPartialRow.assign( num_buses, false );
+    this->mSamplesPerBit = bit_rate != 0 ? double( sample_rate_hz ) / double( bit_rate ) : 1.0;
+}
+
+void MELIBUBusStatistics::AddByte( const MELIBUByteRecord& byte ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    MELIBUBusCounters& counters = this->mBuses[ byte.mBus ];
+    counters.mBytes++;
+    for( U8 bit = 0; bit < MELIBUFormat::FlagCount; bit++ )
+        if( byte.mFlags & ( 1 << bit ) )
+            counters.mFlagBytes[ bit ]++;
+    if( counters.mFirstSample < 0 )
+        counters.mFirstSample = byte.mStartingSampleInclusive;
+    counters.mLastSample = byte.mEndingSampleInclusive;
+
+    Interval( counters, byte.mStartingSampleInclusive ).mBytes++;
+    AddBusySamples( counters, byte.mStartingSampleInclusive, byte.mEndingSampleInclusive );
+}
+
+void MELIBUBusStatistics::AddMissingByte( U8 bus, S64 starting_sample, S64 /*ending_sample*/ ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    MELIBUBusCounters& counters = this->mBuses[ bus ];
+    counters.mMissingBytes++;
+    Interval( counters, starting_sample ).mMissingBytes++;
+}
+
+void MELIBUBusStatistics::AddPacket( const MELIBUPacketRecord& packet ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    MELIBUBusCounters& counters = this->mBuses[ packet.mBus ];
+    counters.mPackets++;
+    if( !packet.mComplete )
+        counters.mIncompletePackets++;
+    counters.mLengths[ std::min < U32 >( packet.mDataLength, MELIBUPacketRecord::MaxDataBytes ) ]++;
+
+    MELIBUIdCounters& id = counters.mIds[ ( U16 )( ( packet.mID1 << 8 ) | packet.mID2 ) ]; // value initialized to zero
+    id.mPackets++;
+    id.mDataBytes += packet.mDataLength;
+    if( !packet.mComplete )
+        id.mIncompletePackets++;
+    for( U8 bit = 0; bit < MELIBUFormat::FlagCount; bit++ ) {
+        if( packet.mFlags & ( 1 << bit ) ) {
+            counters.mFlagPackets[ bit ]++;
+            id.mFlagPackets[ bit ]++;
+        }
+    }
+
+    MELIBUStatisticsInterval& interval = Interval( counters, packet.mEndingSampleInclusive );
+    interval.mPackets++;
+    if( packet.mFlags != 0 || !packet.mComplete )
+        interval.mErrorPackets++;
+
+    if( counters.mLastPacketEnd >= 0 && packet.mStartingSampleInclusive > counters.mLastPacketEnd ) {
+        U64 gap = packet.mStartingSampleInclusive - counters.mLastPacketEnd;
+        U64 bits = ( U64 )( gap / this->mSamplesPerBit );
+        U32 bucket = 0;
+        while( bits != 0 && bucket < MELIBUBusCounters::GapBuckets - 1 ) {
+            bucket++;
+            bits >>= 1;
+        }
+        counters.mGaps[ bucket ]++;
+        counters.mGapSamplesMin = counters.mGapCount == 0 ? gap : std::min( counters.mGapSamplesMin, gap );
+        counters.mGapSamplesMax = std::max( counters.mGapSamplesMax, gap );
+        counters.mGapSamplesSum += gap;
+        counters.mGapCount++;
+    }
+    counters.mLastPacketEnd = packet.mEndingSampleInclusive;
+}
+
+bool MELIBUBusStatistics::NextInterval( U8 bus, S64 sample_number, MELIBUStatisticsInterval& interval ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    U64 index = this->mNextInterval[ bus ];
+    S64 ending_sample = ( S64 )( ( index + 1 ) * this->mIntervalSamples ) - 1;
+    if( ending_sample >= sample_number )
+        return false;
+
+    NextIntervalUntil( bus, ending_sample, interval );
+    this->mNextInterval[ bus ]++;
+    this->mPartialRow[ bus ] = false;
+    return true;
+}
+
+bool MELIBUBusStatistics::PartialInterval( U8 bus, S64 sample_number, MELIBUStatisticsInterval& interval ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    S64 ending_sample = ( S64 )( ( this->mNextInterval[ bus ] + 1 ) * this->mIntervalSamples ) - 1;
+    ending_sample = std::min( ending_sample, sample_number );
+    if( this->mPartialRow[ bus ] || ending_sample < ( S64 )( this->mNextInterval[ bus ] * this->mIntervalSamples ) )
+        return false;
+
+    NextIntervalUntil( bus, ending_sample, interval );
+    if( interval.mBusySamples == 0 && interval.mBytes == 0 && interval.mPackets == 0 && interval.mMissingBytes == 0 )
+        return false;
+    this->mPartialRow[ bus ] = true;
+    return true;
+}
+
+void MELIBUBusStatistics::NextIntervalUntil( U8 bus, S64 ending_sample, MELIBUStatisticsInterval& interval ) {
+    U64 index = this->mNextInterval[ bus ];
+    const MELIBUBusCounters& counters = this->mBuses[ bus ];
+    if( index < counters.mIntervals.size() )
+        interval = counters.mIntervals[ index ];
+    else
+        memset( &interval, 0, sizeof( interval ) ); // no output of bus in this interval
+    interval.mStartingSampleInclusive = ( S64 )( index * this->mIntervalSamples );
+    interval.mEndingSampleInclusive = ending_sample;
+}
+
+void MELIBUBusStatistics::Copy( std::vector < MELIBUBusCounters >& buses ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    buses = this->mBuses;
+}
+
+MELIBUStatisticsInterval& MELIBUBusStatistics::Interval( MELIBUBusCounters& counters, S64 sample_number ) {
+    U64 index = ( U64 )std::max < S64 >( 0, sample_number ) / this->mIntervalSamples;
+    while( counters.mIntervals.size() <= index ) {
+        MELIBUStatisticsInterval interval;
+        memset( &interval, 0, sizeof( interval ) );
+        interval.mStartingSampleInclusive = ( S64 )( counters.mIntervals.size() * this->mIntervalSamples );
+        interval.mEndingSampleInclusive = interval.mStartingSampleInclusive + ( S64 )this->mIntervalSamples - 1;
+        counters.mIntervals.push_back( interval );
+    }
+    return counters.mIntervals[ index ];
+}
+
+void MELIBUBusStatistics::AddBusySamples( MELIBUBusCounters& counters, S64 starting_sample, S64 ending_sample ) {
+    starting_sample = std::max < S64 >( 0, starting_sample );
+    if( ending_sample < starting_sample )
+        return;
+    counters.mBusySamples += ending_sample - starting_sample + 1;
+    while( starting_sample <= ending_sample ) {
+        MELIBUStatisticsInterval& interval = Interval( counters, starting_sample );
+        S64 end = std::min( ending_sample, interval.mEndingSampleInclusive );
+        interval.mBusySamples += end - starting_sample + 1;
+        starting_sample = end + 1;
+    }
+}
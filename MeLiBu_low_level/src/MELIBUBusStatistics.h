@@ -0,0 +1,102 @@
+#ifndef MELIBU_BUS_STATISTICS_H
+#define MELIBU_BUS_STATISTICS_H
+
+#include "MELIBUTypes.h"
+#include "MELIBUDecoder.h"
+#include "MELIBUFormat.h"
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+// bus utilization and message counts of one interval of capture time
+struct MELIBUStatisticsInterval
+{
+    S64 mStartingSampleInclusive;
+    S64 mEndingSampleInclusive;
+    U64 mBusySamples;  // samples covered by break and byte fields
+    U32 mBytes;
+    U32 mPackets;      // messages ending in interval
+    U32 mErrorPackets; // messages with error flag or incomplete
+    U32 mMissingBytes;
+};
+
+// message counts of one header id
+struct MELIBUIdCounters
+{
+    U64 mPackets;
+    U64 mIncompletePackets;
+    U64 mDataBytes;
+    U64 mFlagPackets[ MELIBUFormat::FlagCount ]; // messages with flag ( 1 << bit )
+};
+
+// health counters of one bus; all values are totals since start of decoding
+struct MELIBUBusCounters
+{
+    enum { GapBuckets = 32 }; // gap histogram bucket 0: gap < 1 bit, bucket n: 2^(n-1) <= gap < 2^n bits
+
+    MELIBUBusCounters();
+
+    U64 mBytes;
+    U64 mPackets;
+    U64 mIncompletePackets;
+    U64 mMissingBytes;
+    U64 mFlagBytes[ MELIBUFormat::FlagCount ];   // byte fields with flag ( 1 << bit )
+    U64 mFlagPackets[ MELIBUFormat::FlagCount ]; // messages with flag ( 1 << bit )
+    U64 mBusySamples;
+    S64 mFirstSample; // start of first byte field; -1 before first byte
+    S64 mLastSample;  // end of last byte field
+
+    std::unordered_map < U16, MELIBUIdCounters > mIds; // key: ID1 << 8 | ID2
+
+    // from end of one message to break field of next message
+    U64 mGaps[ GapBuckets ];
+    U64 mGapCount;
+    U64 mGapSamplesSum;
+    U64 mGapSamplesMin;
+    U64 mGapSamplesMax;
+    S64 mLastPacketEnd; // -1 before first message
+
+    U64 mLengths[ MELIBUPacketRecord::MaxDataBytes + 1 ]; // messages by number of data bytes
+
+    std::vector < MELIBUStatisticsInterval > mIntervals; // bus utilization; interval n starts at sample n * interval length
+};
+
+// bus statistics updated from decoder output while decoding; one pass over the capture, nothing is re-read
+// updated by analyzer thread and read by export at the same time
+class MELIBUBusStatistics
+{
+ public:
+    MELIBUBusStatistics();
+    ~MELIBUBusStatistics();
+
+    // clears all counters; interval_samples is length of utilization intervals
+    void Setup( U32 sample_rate_hz, U32 bit_rate, U64 interval_samples, U32 num_buses );
+
+    void AddByte( const MELIBUByteRecord& byte );
+    void AddMissingByte( U8 bus, S64 starting_sample, S64 ending_sample );
+    void AddPacket( const MELIBUPacketRecord& packet );
+
+    // next interval of bus that ends before sample_number; for summary rows while decoding
+    // output of all buses must be added up to sample_number before
+    bool NextInterval( U8 bus, S64 sample_number, MELIBUStatisticsInterval& interval );
+    // start of next interval up to sample_number if bus had output there; for a row when all captured data is
+    // decoded, once per interval: in a live capture the complete interval is returned later by NextInterval
+    bool PartialInterval( U8 bus, S64 sample_number, MELIBUStatisticsInterval& interval );
+
+    void Copy( std::vector < MELIBUBusCounters >& buses ); // copy counters of all buses
+
+ protected:
+    MELIBUStatisticsInterval& Interval( MELIBUBusCounters& counters, S64 sample_number ); // adds intervals up to sample
+    void AddBusySamples( MELIBUBusCounters& counters, S64 starting_sample, S64 ending_sample ); // split at interval ends
+    void NextIntervalUntil( U8 bus, S64 ending_sample, MELIBUStatisticsInterval& interval );
+
+ protected: //vars
+    std::mutex mMutex;
+    std::vector < MELIBUBusCounters > mBuses;
+    std::vector < U64 > mNextInterval; // next summary row interval of each bus
+    std::vector < bool > mPartialRow; // next interval was returned by PartialInterval
+    U64 mIntervalSamples;
+    double mSamplesPerBit;
+};
+
+#endif //MELIBU_BUS_STATISTICS_H
@@ -0,0 +1,29 @@
+#ifndef MELIBU_CHANNEL_H
+#define MELIBU_CHANNEL_H
+
+#include "MELIBUTypes.h"
+
+// sample cursor over one digital channel; same semantics as AnalyzerChannelData from the Analyzer SDK
+// the plugin wraps AnalyzerChannelData, offline tools use MELIBUEdgeChannel (list of edge timestamps)
+class MELIBUChannel
+{
+ public:
+    virtual ~MELIBUChannel() {}
+
+    virtual U64 GetSampleNumber() = 0;
+    virtual bool IsHigh() = 0; // bit state at current sample
+
+    virtual U32 Advance( U32 num_samples ) = 0; // returns number of transitions passed
+    virtual U32 AdvanceToAbsPosition( U64 sample_number ) = 0;
+    virtual void AdvanceToNextEdge() = 0;
+
+    virtual U64 GetSampleOfNextEdge() = 0;
+    virtual bool WouldAdvancingCauseTransition( U32 num_samples ) = 0;
+
+    // true when there is no more data to decode; channels fed by a running capture never end
+    virtual bool AtEnd() = 0;
+    // false if next edge is not captured yet or there is none; reading ahead (bit rate detection) stops here
+    virtual bool MoreEdgesAvailable() = 0;
+};
+
+#endif //MELIBU_CHANNEL_H
@@ -0,0 +1,58 @@
+#include "MELIBUCommitScheduler.h"
+
+MELIBUCommitScheduler::MELIBUCommitScheduler()
+    :   mMaxPackets( 1 ),
+    mMaxFrames( 1 ),
+    mMaxSamples( 0 ),
+    mPackets( 0 ),
+    mFrames( 0 ),
+    mMarkers( 0 ),
+    mLastCommitSample( 0 ) {}
+
+MELIBUCommitScheduler::~MELIBUCommitScheduler() {}
+
+void MELIBUCommitScheduler::Setup( U32 policy, U32 sample_rate_hz ) {
+    if( policy == policyThroughput ) {
+        this->mMaxPackets = 512;
+        this->mMaxFrames = 8192;
+        this->mMaxSamples = sample_rate_hz; // 1 s of capture
+    } else {
+        this->mMaxPackets = 1;
+        this->mMaxFrames = 16;
+        this->mMaxSamples = sample_rate_hz / 100; // 10 ms of capture
+    }
+    this->mPackets = 0;
+    this->mFrames = 0;
+    this->mMarkers = 0;
+    this->mLastCommitSample = 0;
+}
+
+void MELIBUCommitScheduler::AddFrame() {
+    this->mFrames++;
+}
+
+void MELIBUCommitScheduler::AddPacket() {
+    this->mPackets++;
+}
+
+void MELIBUCommitScheduler::AddMarker() {
+    this->mMarkers++;
+}
+
+bool MELIBUCommitScheduler::CommitNeeded( S64 sample_number ) {
+    if( this->mFrames == 0 )
+        return false;
+    return this->mPackets >= this->mMaxPackets || this->mFrames >= this->mMaxFrames ||
+           ( U64 )( sample_number - this->mLastCommitSample ) >= this->mMaxSamples;
+}
+
+bool MELIBUCommitScheduler::Pending() const {
+    return this->mFrames != 0 || this->mMarkers != 0;
+}
+
+void MELIBUCommitScheduler::Committed( S64 sample_number ) {
+    this->mPackets = 0;
+    this->mFrames = 0;
+    this->mMarkers = 0;
+    this->mLastCommitSample = sample_number;
+}
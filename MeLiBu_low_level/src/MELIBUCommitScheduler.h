@@ -0,0 +1,40 @@
+#ifndef MELIBU_COMMIT_SCHEDULER_H
+#define MELIBU_COMMIT_SCHEDULER_H
+
+#include "MELIBUTypes.h"
+
+// decides when decoded results are committed and progress is reported
+// committing after every byte locks results and notifies UI for each byte; this batches commits instead
+class MELIBUCommitScheduler
+{
+ public:
+    typedef enum {
+        policyLive = 0,      // commit at end of every message; short delay when capture is running
+        policyThroughput = 1 // commit rarely; fastest decode of recorded captures
+    } tMELIBUCommitPolicy;
+
+    MELIBUCommitScheduler();
+    ~MELIBUCommitScheduler();
+
+    void Setup( U32 policy, U32 sample_rate_hz );
+
+    void AddFrame();  // frame or table row added to results
+    void AddPacket(); // message ended
+    void AddMarker(); // only makes results pending; markers alone don't cause commits
+    bool CommitNeeded( S64 sample_number ); // call after every byte; true if results should be committed now
+    bool Pending() const;                   // results added since last commit
+    void Committed( S64 sample_number );    // call after results were committed
+
+ protected: //vars
+    // limits of selected policy
+    U32 mMaxPackets;
+    U32 mMaxFrames;
+    U64 mMaxSamples;
+
+    U32 mPackets; // since last commit
+    U32 mFrames;
+    U32 mMarkers;
+    S64 mLastCommitSample;
+};
+
+#endif //MELIBU_COMMIT_SCHEDULER_H
@@ -1,5 +1,73 @@
 #include "MELIBUCrc.h"
 
+namespace
+{
+    // bitwise crc update; reference implementation used to generate tables
+    constexpr U16 CrcShift( U16 crc, int bits ) {
+        return bits == 0 ? crc : CrcShift( ( crc & 0x8000 ) ? ( U16 )( ( crc << 1 ) ^ 0x1021 ) : ( U16 )( crc << 1 ), bits - 1 );
+    }
+
+    constexpr U16 CrcBitwise( U16 crc, const U8* data, size_t length ) {
+        return length == 0 ? crc : CrcBitwise( CrcShift( crc ^ ( U16 )( data[ 0 ] << 8 ), 8 ), data + 1, length - 1 );
+    }
+
+    // table 0: crc of single byte; table k: crc of byte followed by k zero bytes
+    constexpr U16 CrcEntry( unsigned table, U16 value ) {
+        return table == 0 ? CrcShift( ( U16 )( value << 8 ), 8 ) :
+               ( U16 )( ( CrcEntry( table - 1, value ) << 8 ) ^ CrcEntry( 0, CrcEntry( table - 1, value ) >> 8 ) );
+    }
+
+    struct CrcTables
+    {
+        U16 mTable[ 8 ][ 256 ];
+    };
+
+    template < unsigned... I >
+    struct IndexList {};
+
+    template < unsigned N, unsigned... I >
+    struct MakeIndexList: MakeIndexList < N - 1, N - 1, I... > {};
+
+    template < unsigned... I >
+    struct MakeIndexList < 0, I... >
+    {
+        typedef IndexList < I... > type;
+    };
+
+    template < unsigned... I >
+    constexpr CrcTables MakeCrcTables( IndexList < I... > ) {
+        return CrcTables { { { CrcEntry( 0, I )... }, { CrcEntry( 1, I )... }, { CrcEntry( 2, I )... }, { CrcEntry( 3, I )... },
+                             { CrcEntry( 4, I )... }, { CrcEntry( 5, I )... }, { CrcEntry( 6, I )... }, { CrcEntry( 7, I )... } } };
+    }
+
+    constexpr CrcTables kCrc = MakeCrcTables( MakeIndexList < 256 >::type() );
+
+    constexpr U16 CrcByte( U16 crc, U8 byte ) {
+        return ( U16 )( ( crc << 8 ) ^ kCrc.mTable[ 0 ][ ( crc >> 8 ) ^ byte ] );
+    }
+
+    constexpr U16 CrcSlice4( U16 crc, const U8* p ) {
+        return kCrc.mTable[ 3 ][ p[ 0 ] ^ ( crc >> 8 ) ] ^ kCrc.mTable[ 2 ][ p[ 1 ] ^ ( crc & 0xFF ) ] ^
+               kCrc.mTable[ 1 ][ p[ 2 ] ] ^ kCrc.mTable[ 0 ][ p[ 3 ] ];
+    }
+
+    constexpr U16 CrcSlice8( U16 crc, const U8* p ) {
+        return kCrc.mTable[ 7 ][ p[ 0 ] ^ ( crc >> 8 ) ] ^ kCrc.mTable[ 6 ][ p[ 1 ] ^ ( crc & 0xFF ) ] ^
+               kCrc.mTable[ 5 ][ p[ 2 ] ] ^ kCrc.mTable[ 4 ][ p[ 3 ] ] ^
+               kCrc.mTable[ 3 ][ p[ 4 ] ] ^ kCrc.mTable[ 2 ][ p[ 5 ] ] ^
+               kCrc.mTable[ 1 ][ p[ 6 ] ] ^ kCrc.mTable[ 0 ][ p[ 7 ] ];
+    }
+
+    // table driven functions must give the same result as bitwise calculation
+    constexpr U8 kCheckData[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9', 0x00, 0xFF, 0x5A, 0xA5 };
+    static_assert( CrcBitwise( 0xFFFF, kCheckData, 9 ) == 0x29B1, "crc check value" );
+    static_assert( CrcByte( CrcSlice8( 0xFFFF, kCheckData ), kCheckData[ 8 ] ) == 0x29B1, "slice-by-8 differs from bitwise crc" );
+    static_assert( CrcSlice4( CrcSlice4( 0xFFFF, kCheckData ), kCheckData + 4 ) == CrcBitwise( 0xFFFF, kCheckData, 8 ),
+                   "slice-by-4 differs from bitwise crc" );
+    static_assert( CrcSlice8( CrcSlice4( 0x1D0F, kCheckData + 1 ), kCheckData + 5 ) == CrcBitwise( 0x1D0F, kCheckData + 1, 12 ),
+                   "slice-by-8 differs from bitwise crc" );
+}
+
 MELIBUCrc::MELIBUCrc() : mCRC( 0xFFFF ) {}
 
 MELIBUCrc::~MELIBUCrc() {}
@@ -9,20 +77,30 @@ void MELIBUCrc::clear() {
 }
 
 U16 MELIBUCrc::add( U8 byte ) {
-    for( int i = 0; i < 8; i++ ) {
-        U16 firstBit16 = this->mCRC & 0x8000;
-        U16 firstBit8 = ( U16 )byte & 0x80;
-        byte <<= 1;
-        this->mCRC <<= 1;
+    this->mCRC = CrcByte( this->mCRC, byte );
+    return this->mCRC;
+}
 
-        firstBit8 <<= 8;
-        if( ( firstBit16 ^ firstBit8 ) != 0 ) {
-            this->mCRC ^= 0x1021;
-        }
+U16 MELIBUCrc::add( const U8* data, size_t length ) {
+    U16 crc = this->mCRC;
+    for( ; length >= 8; length -= 8, data += 8 )
+        crc = CrcSlice8( crc, data );
+    if( length >= 4 ) {
+        crc = CrcSlice4( crc, data );
+        length -= 4;
+        data += 4;
     }
+    for( ; length > 0; length--, data++ )
+        crc = CrcByte( crc, *data );
+    this->mCRC = crc;
     return this->mCRC;
 }
 
 U16 MELIBUCrc::result() {
     return this->mCRC;
 }
+
+U16 MELIBUCrc::calculate( const U8* data, size_t length ) {
+    MELIBUCrc crc;
+    return crc.add( data, length );
+}
@@ -1,8 +1,10 @@
 #ifndef MELIBU_CRC_H
 #define MELIBU_CRC_H
 
-#include <LogicPublicTypes.h>
+#include "MELIBUTypes.h"
+#include <cstddef>
 
+// CRC-16 with polynomial 0x1021 and initial value 0xFFFF, msb first
 class MELIBUCrc
 {
  public:
@@ -11,10 +13,13 @@ class MELIBUCrc
 
     void clear();
     U16 add( U8 byte );
+    U16 add( const U8* data, size_t length ); // slice-by-8 over buffer
     U16 result();
 
+    static U16 calculate( const U8* data, size_t length ); // crc of whole buffer starting with initial value
+
  private:
     U16 mCRC;
 };
 
-#endif // MELIBUCRC_H
\ No newline at end of file
+#endif // MELIBUCRC_H
@@ -0,0 +1,670 @@
+#include "MELIBUDecoder.h"
+#include "MELIBUChannel.h"
+#include "MELIBUInstrumentation.h"
+#include <math.h>
+#include <algorithm>
+
+MELIBUDecoderSettings::MELIBUDecoderSettings()
+    :   mSampleRateHz( 0 ),
+    mBitRate( 1000000 ),
+    mMELIBUVersion( 1.0 ),
+    mACK( false ),
+    mACKValue( 0x7E ),
+    mByteDecoder( byteDecoderSampling ),
+    mMarkerLevel( markersAllBits ),
+    mBus( 0 ) {}
+
+MELIBUDecoder::MELIBUDecoder( MELIBUChannel* channel, MELIBUDecoderListener* listener )
+    :   mChannel( channel ),
+    mListener( listener ),
+    mProtocol( MELIBUProtocol::MeLiBu1 ),
+    mLayouts( &MELIBUFrameLayoutTable::Get( MELIBUProtocol::MeLiBu1 ) ),
+    mDecodeFrame( &MELIBUDecoder::DecodeFrameT < MELIBUProtocol1 > ),
+    mSamplesPerBit( 1.0 ),
+    mBitPeriodFixed( 1 << 16 ),
+    mHalfBitFixed( 1 << 15 ),
+    mMarkerMask( 0xFF ),
+    mFrameState( NoFrame ),
+    mPacketBytes( 0 ),
+    mDataBytes( 0 ),
+    mCrcValue( 0 ) {
+    this->mID[ 0 ] = 0;
+    this->mID[ 1 ] = 0;
+    this->mPacket = MELIBUPacketRecord();
+    this->mLayout = MELIBUFrameLayout();
+}
+
+MELIBUDecoder::~MELIBUDecoder() {}
+
+void MELIBUDecoder::Setup( const MELIBUDecoderSettings& settings ) {
+    this->mSettings = settings;
+    this->mSamplesPerBit = ( double )settings.mSampleRateHz / ( double )settings.mBitRate;
+    this->mBitPeriodFixed = ( ( U64 )settings.mSampleRateHz << 16 ) / settings.mBitRate;
+    this->mHalfBitFixed = this->mBitPeriodFixed / 2;
+
+    // error markers are always added
+    this->mMarkerMask = ( 1 << markerErrorDot ) | ( 1 << markerErrorSquare ) | ( 1 << markerErrorX );
+    if( settings.mMarkerLevel != MELIBUDecoderSettings::markersErrors )
+        this->mMarkerMask |= ( 1 << markerStart ) | ( 1 << markerStop );
+    if( settings.mMarkerLevel == MELIBUDecoderSettings::markersAllBits )
+        this->mMarkerMask |= ( 1 << markerOne ) | ( 1 << markerZero );
+    this->mProtocol = MELIBUProtocol::FromVersion( settings.mMELIBUVersion );
+    this->mLayouts = &MELIBUFrameLayoutTable::Get( this->mProtocol );
+
+    switch( this->mProtocol ) {
+        case MELIBUProtocol::MeLiBu1:
+            this->mDecodeFrame = &MELIBUDecoder::DecodeFrameT < MELIBUProtocol1 >;
+            break;
+        case MELIBUProtocol::MeLiBu1Extended:
+            this->mDecodeFrame = &MELIBUDecoder::DecodeFrameT < MELIBUProtocol1Extended >;
+            break;
+        case MELIBUProtocol::MeLiBu2:
+            this->mDecodeFrame = &MELIBUDecoder::DecodeFrameT < MELIBUProtocol2 >;
+            break;
+    }
+}
+
+void MELIBUDecoder::Start() {
+    this->mFrameState = NoFrame; // initialize frame state
+    this->mDataBytes = 0;
+    this->mPacketBytes = 0;
+    this->mLayout = MELIBUFrameLayout();
+
+    if( !this->mChannel->IsHigh() )
+        this->mChannel->AdvanceToNextEdge();
+}
+
+bool MELIBUDecoder::AtMessageBoundary() const {
+    return this->mFrameState == NoFrame && this->mPacketBytes == 0;
+}
+
+void MELIBUDecoder::Attach( MELIBUChannel* channel, MELIBUDecoderListener* listener ) {
+    this->mChannel = channel;
+    this->mListener = listener;
+}
+
+void MELIBUDecoder::Decode() {
+    Start();
+    while( DecodeFrame() ) {
+    }
+}
+
+bool MELIBUDecoder::DecodeFrame() {
+    return ( this->*mDecodeFrame )();
+}
+
+template < class P >
+bool MELIBUDecoder::DecodeFrameT() {
+    MELIBUByteRecord byteFrame;          // byte frame from start to stop bit
+    bool byteFramingError { false };
+    bool is_data_really_break { false }; // for break field found with ByteFrame function
+    bool ready_to_save { false };
+    bool is_start_of_packet { false };
+    S64 ibs_start = this->mChannel->GetSampleNumber(); // inter byte space is from current sample to starting sample of break or byte field
+
+    ReadFrame < P >( byteFrame, is_data_really_break, byteFramingError ); // read byte frame or header break
+    if( this->mChannel->AtEnd() )
+        return false; // capture ended inside this byte
+    MELIBU_COUNT( counterBytes, 1 );
+    AddToCrc( byteFrame );
+
+    if( is_data_really_break ) { // break field found insted of byte frame; this is not regular situation
+        this->mFrameState = NoFrame;
+        this->mListener->OnMissingByte( ibs_start, byteFrame.mStartingSampleInclusive );
+    }
+
+    // in each case set mFrameState for next iteration
+    switch( this->mFrameState ) {
+        case NoFrame:
+        case headerBreak:
+
+            if( byteFrame.mData == 0x00 ) {
+                this->mFrameState = headerID1;
+                byteFrame.mType = headerBreak;
+                is_start_of_packet = true;
+                this->mCRC.clear(); // reset crc
+                this->mLayout = MELIBUFrameLayout();
+                this->mDataBytes = 0; // data left from message cut short by this break
+            } else { // reset
+                byteFrame.mFlags |= headerBreakExpected;
+                this->mFrameState = NoFrame;
+            }
+            break;
+
+        case headerID1:
+
+            this->mFrameState = headerID2;
+            this->mID[ 0 ] = byteFrame.mData; // save byte value to id1
+            break;
+
+        case headerID2:
+
+            this->mID[ 1 ] = byteFrame.mData; // save byte value to id2
+            this->mLayout = this->mLayouts->Lookup( this->mID[ 0 ], this->mID[ 1 ] );
+            this->mDataBytes = this->mLayout.mDataLength;
+
+            if( this->mDataBytes == 0 )
+                this->mFrameState = responseCRC1;
+            else
+                this->mFrameState = responseDataZero;
+            // if instruction bit is set read two bytes for instruction; only possible for MELIBU 2
+            if( this->mLayout.mFlags & MELIBUFrameLayout::hasInstruction )
+                this->mFrameState = instruction1;
+            break;
+
+        case instruction1:
+
+            this->mFrameState = instruction2;
+            break;
+
+        case instruction2:
+
+            if( this->mDataBytes == 0 )
+                this->mFrameState = responseCRC1;
+            else
+                this->mFrameState = responseDataZero;
+            break;
+
+        case responseDataZero:
+
+            this->mFrameState = responseData;
+            this->mDataBytes--;
+            break;
+
+        case responseData:
+
+            // if all data bytes are read, read response crc 1 field next
+            if( this->mDataBytes == 1 )
+                this->mFrameState = responseCRC1;
+            this->mDataBytes--;
+            break;
+
+        case responseCRC1:
+
+            this->mFrameState = responseCRC2;
+            CrcFrameValue < P >( this->mCrcValue, byteFrame.mData, 0 );
+            break;
+
+        case responseCRC2:
+        {
+            bool ack = this->mSettings.mACK && ( this->mLayout.mFlags & MELIBUFrameLayout::ackExpected );
+            this->mFrameState = ack ? responseACK : NoFrame;
+            ready_to_save = !ack; // if we need to read ack byte data is not ready for saving
+            CrcFrameValue < P >( this->mCrcValue, byteFrame.mData, 1 );
+
+            if( this->mCRC.result() != this->mCrcValue ) { // add flag if calculated crc is not the same as read crc
+                byteFrame.mFlags |= crcMismatch;
+                AddMarker( this->mChannel->GetSampleNumber(), markerErrorSquare );
+            }
+            break;
+        }
+        case responseACK:
+        {
+            this->mFrameState = NoFrame;
+            // ack value means that reception of the frame was OK; it is always 0x7E unless protocol lets it be configured
+            U8 ack_value = P::ConfigurableAck ? this->mSettings.mACKValue : ( U8 )0x7E;
+            if( byteFrame.mData != ack_value ) { // add marker if ack value is not the expected one
+                AddMarker( this->mChannel->GetSampleNumber(), markerErrorSquare );
+                byteFrame.mFlags |= receptionFailed;
+            }
+            this->mDataBytes = 0;
+            ready_to_save = true;
+            break;
+        }
+    }
+
+    byteFrame.mIndex = this->mLayout.mDataLength - this->mDataBytes; // number of data in message
+    byteFrame.mCrc = this->mCRC.result();
+    byteFrame.mBus = this->mSettings.mBus;
+
+    if( is_start_of_packet && this->mPacketBytes != 0 ) {
+        this->mPacket.mComplete = false;
+        this->mListener->OnPacket( this->mPacket ); // report previous, unfinished packet
+        this->mPacketBytes = 0;
+    }
+
+    AddToPacket( byteFrame );
+    this->mListener->OnByte( byteFrame );
+
+    if( ready_to_save ) {
+        this->mPacket.mComplete = true;
+        this->mListener->OnPacket( this->mPacket );
+        this->mPacketBytes = 0;
+    }
+
+    this->mListener->OnProgress( byteFrame.mEndingSampleInclusive );
+    return true;
+}
+
+double MELIBUDecoder::SamplesPerBit() {
+    return this->mSamplesPerBit;
+}
+
+double MELIBUDecoder::HalfSamplesPerBit() {
+    return SamplesPerBit() * 0.5;
+}
+
+void MELIBUDecoder::AdvanceHalfBit() {
+    double numOfSamples = HalfSamplesPerBit();
+    this->mChannel->Advance( numOfSamples );
+}
+
+void MELIBUDecoder::Advance( U16 nBits ) {
+    this->mChannel->Advance( nBits * SamplesPerBit() );
+}
+
+U64 MELIBUDecoder::BitCenterOffset( U32 bit ) {
+    return ( this->mHalfBitFixed + bit * this->mBitPeriodFixed ) >> 16;
+}
+
+U32 MELIBUDecoder::BitsBetween( U64 from, U64 to ) {
+    return ( ( ( to - from ) << 16 ) + this->mHalfBitFixed ) / this->mBitPeriodFixed;
+}
+
+void MELIBUDecoder::AddMarker( U64 sample_number, tMELIBUMarker marker ) {
+    if( this->mMarkerMask & ( 1 << marker ) )
+        this->mListener->OnMarker( sample_number, marker );
+}
+
+U8 MELIBUDecoder::NumberOfDataBytes( U8 idField1, U8 idField2 ) {
+    // number of data bytes in message are calculated based on function select bit and MELIBU version
+    return this->mLayouts->Lookup( idField1, idField2 ).mDataLength;
+}
+
+template < class P >
+U8 MELIBUDecoder::GetBreakField( S64& startingSample, S64& endingSample, bool& framingError, bool& toggling ) {
+    U32 min_break_field_low_bits { P::BreakBits };
+
+    U32 num_break_bits { 0 };
+    bool valid_frame { false };
+    StartingSampleInBreakField( min_break_field_low_bits, startingSample, num_break_bits, valid_frame, toggling );
+    if( this->mChannel->AtEnd() )
+        return 1; // no break field until end of data
+
+    // sample each low bit in break field; bit centers are the same with and without bit markers
+    U64 start = this->mChannel->GetSampleNumber();
+    U32 bit = 0;
+    this->mChannel->AdvanceToAbsPosition( start + BitCenterOffset( bit ) );
+    if( this->mMarkerMask & ( 1 << markerZero ) ) {
+        while( !this->mChannel->IsHigh() && !this->mChannel->AtEnd() ) {
+            AddMarker( this->mChannel->GetSampleNumber(), markerZero );
+            this->mChannel->AdvanceToAbsPosition( start + BitCenterOffset( ++bit ) );
+        }
+    } else {
+        // no bit markers: skip bits without edges and sample only first bit after each edge
+        while( !this->mChannel->IsHigh() && !this->mChannel->AtEnd() ) {
+            U64 next_edge = this->mChannel->GetSampleOfNextEdge();
+            U32 first = bit + 1;
+            bit = std::max( first, BitsBetween( start, next_edge ) );
+            while( start + BitCenterOffset( bit ) < next_edge )
+                bit++;
+            while( bit > first && start + BitCenterOffset( bit - 1 ) >= next_edge )
+                bit--;
+            this->mChannel->AdvanceToAbsPosition( start + BitCenterOffset( bit ) );
+        }
+    }
+
+    // validate stop bit
+    if( this->mChannel->IsHigh() ) {
+        AddMarker( this->mChannel->GetSampleNumber(), markerStop );
+        framingError = false;
+    } else {
+        AddMarker( this->mChannel->GetSampleNumber(), markerErrorSquare );
+        framingError = true;
+    }
+
+    // after all advancing we are now in the middle of stop bit
+    SetEndingSampleInStopBit( endingSample );
+    this->mChannel->AdvanceToAbsPosition( this->mChannel->GetSampleOfNextEdge() - 1 );
+
+    return ( valid_frame ) ? 0 : 1;
+}
+
+template < class P >
+U8 MELIBUDecoder::ByteFrame( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field ) {
+    U8 data = 0;
+    U8 mask = P::LsbFirst ? 0x01 : 0x80; // MELIBU 2: LSB first, MELIBU 1: MSB first
+
+    framingError = false;
+    is_break_field = false;
+
+    // locate start bit
+    this->mChannel->AdvanceToNextEdge();
+    if( this->mChannel->IsHigh() ) {
+        // start bit needs to be low; add error marker and advance to next edge (low)
+        AdvanceHalfBit();
+        AddMarker( this->mChannel->GetSampleNumber(), markerErrorDot );
+        this->mChannel->AdvanceToNextEdge();
+    }
+    startingSample = this->mChannel->GetSampleNumber();
+    AdvanceHalfBit(); // advance to the middle of start bit
+    AddMarker( this->mChannel->GetSampleNumber(), markerStart );
+
+    bool all_break_clear = true;
+    // data bits; add marker at the middle of each bit
+    for( U32 i = 0; i < 8; i++ ) {
+        Advance( 1 );
+        if( this->mChannel->IsHigh() ) {
+            data |= mask; // add bit to data
+            all_break_clear = false; // if at least one bit is high and if there is error frame can't be recognized as break field
+        }
+        AddMarker( this->mChannel->GetSampleNumber(), this->mChannel->IsHigh() ? markerOne : markerZero );
+
+        if( P::LsbFirst )
+            mask = mask << 1;
+        else
+            mask = mask >> 1;
+    }
+
+    // validate stop bit
+    Advance( 1 );
+    if( StopBit < P >( endingSample, framingError, all_break_clear ) ) {
+        is_break_field = true;
+        return 0x00;
+    }
+
+    return data;
+}
+
+template < class P >
+U8 MELIBUDecoder::ByteFrameEdges( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field ) {
+    U8 data = 0;
+
+    framingError = false;
+    is_break_field = false;
+
+    // locate start bit
+    this->mChannel->AdvanceToNextEdge();
+    if( this->mChannel->IsHigh() ) {
+        // start bit needs to be low; add error marker and advance to next edge (low)
+        AdvanceHalfBit();
+        AddMarker( this->mChannel->GetSampleNumber(), markerErrorDot );
+        this->mChannel->AdvanceToNextEdge();
+    }
+    startingSample = this->mChannel->GetSampleNumber();
+
+    // level can change only on edges: walk from edge to edge and sample bit centres between them
+    // bit 0 is start bit, bits 1 - 8 are data bits
+    U64 start = startingSample;
+    U64 next_edge = this->mChannel->GetSampleOfNextEdge();
+    bool high = false;
+    bool all_break_clear = true;
+    for( U32 bit = 0; bit < 9; bit++ ) {
+        U64 sample = start + BitCenterOffset( bit );
+        while( next_edge <= sample && !this->mChannel->AtEnd() ) {
+            this->mChannel->AdvanceToNextEdge();
+            high = !high;
+            next_edge = this->mChannel->GetSampleOfNextEdge();
+        }
+
+        if( bit == 0 ) {
+            AddMarker( sample, markerStart );
+            continue;
+        }
+        if( high ) {
+            data |= P::LsbFirst ? ( 0x01 << ( bit - 1 ) ) : ( 0x80 >> ( bit - 1 ) ); // add bit to data
+            all_break_clear = false;
+        }
+        AddMarker( sample, high ? markerOne : markerZero );
+    }
+
+    // validate stop bit
+    U64 stop_sample = start + BitCenterOffset( 9 );
+    while( next_edge <= stop_sample && !this->mChannel->AtEnd() ) {
+        this->mChannel->AdvanceToNextEdge();
+        next_edge = this->mChannel->GetSampleOfNextEdge();
+    }
+    this->mChannel->AdvanceToAbsPosition( stop_sample );
+    if( StopBit < P >( endingSample, framingError, all_break_clear ) ) {
+        is_break_field = true;
+        return 0x00;
+    }
+
+    return data;
+}
+
+template < class P >
+U8 MELIBUDecoder::ByteFrameTracking( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field ) {
+    U8 data = 0;
+
+    framingError = false;
+    is_break_field = false;
+
+    // locate start bit
+    this->mChannel->AdvanceToNextEdge();
+    if( this->mChannel->IsHigh() ) {
+        // start bit needs to be low; add error marker and advance to next edge (low)
+        AdvanceHalfBit();
+        AddMarker( this->mChannel->GetSampleNumber(), markerErrorDot );
+        this->mChannel->AdvanceToNextEdge();
+    }
+    startingSample = this->mChannel->GetSampleNumber();
+
+    // like ByteFrameEdges, but bit centres are counted from last edge (anchor) instead of start bit;
+    // sender clock error and edge quantization then add up only over bits without edges, so 3 samples per bit are enough
+    U64 anchor = startingSample;
+    U32 anchor_bit = 0; // bit which starts at anchor
+    U64 next_edge = this->mChannel->GetSampleOfNextEdge();
+    bool high = false;
+    bool all_break_clear = true;
+    for( U32 bit = 0; bit < 10; bit++ ) {
+        U64 sample = anchor + BitCenterOffset( bit - anchor_bit );
+        while( next_edge <= sample && !this->mChannel->AtEnd() ) {
+            this->mChannel->AdvanceToNextEdge();
+            high = !high;
+            // edge on bit boundary moves anchor; edges inside anchor bit (glitches) are ignored
+            U32 edge_bit = std::min( anchor_bit + BitsBetween( anchor, next_edge ), bit );
+            if( edge_bit > anchor_bit ) {
+                anchor = next_edge;
+                anchor_bit = edge_bit;
+                sample = anchor + BitCenterOffset( bit - anchor_bit );
+            }
+            next_edge = this->mChannel->GetSampleOfNextEdge();
+        }
+
+        if( bit == 0 ) {
+            AddMarker( sample, markerStart );
+            continue;
+        }
+        if( bit == 9 ) {
+            this->mChannel->AdvanceToAbsPosition( sample ); // stop bit is validated below
+            break;
+        }
+        if( high ) {
+            data |= P::LsbFirst ? ( 0x01 << ( bit - 1 ) ) : ( 0x80 >> ( bit - 1 ) ); // add bit to data
+            all_break_clear = false;
+        }
+        AddMarker( sample, high ? markerOne : markerZero );
+    }
+
+    // validate stop bit
+    if( StopBit < P >( endingSample, framingError, all_break_clear ) ) {
+        is_break_field = true;
+        return 0x00;
+    }
+
+    return data;
+}
+
+template < class P >
+bool MELIBUDecoder::StopBit( S64& endingSample, bool& framingError, bool all_break_clear ) {
+    if( this->mChannel->IsHigh() ) {
+        AddMarker( this->mChannel->GetSampleNumber(), markerStop );
+    } else {
+        //check if we are really in a break frame
+        //10 bits are read: start + 8 data btis + stop; check rest of the bits to see if it is break field
+        int additional_bits = P::BreakCheckBits;
+        all_break_clear &= !( this->mChannel->WouldAdvancingCauseTransition( SamplesPerBit() * additional_bits ) ); // true if all_break_clear was true and no transition to high bit
+
+        // add marker for wrong stop bit
+        if( !all_break_clear ) {
+            AddMarker( this->mChannel->GetSampleNumber(), markerErrorSquare );
+            framingError = true;
+        } else {
+            this->mChannel->AdvanceToNextEdge();
+            bool high_bit_resent = !this->mChannel->WouldAdvancingCauseTransition( HalfSamplesPerBit() );
+            if( high_bit_resent ) {
+                endingSample = this->mChannel->GetSampleNumber();
+                return true;
+            }
+        }
+    }
+
+    SetEndingSampleInStopBit( endingSample );
+    this->mChannel->AdvanceToAbsPosition( this->mChannel->GetSampleOfNextEdge() - 1 );
+    return false;
+}
+
+void MELIBUDecoder::StartingSampleInBreakField( U32& minBreakFieldBits,
+                                                S64& startingSample,
+                                                U32& num_break_bits,
+                                                bool& valid_frame,
+                                                bool& toggling ) {
+    toggling = false;
+    for( ;; ) {
+        this->mChannel->AdvanceToNextEdge();
+        if( this->mChannel->IsHigh() ) {
+            // add marker at every rising edge when searching for brak field
+            AddMarker( this->mChannel->GetSampleNumber(), markerErrorX );
+            toggling = true;
+            this->mChannel->AdvanceToNextEdge();
+        }
+        if( this->mChannel->AtEnd() )
+            break;
+        // do not advance, but only get the sample of next edge and calculate number of low bits
+        num_break_bits =
+            round(
+                ( double )( ( this->mChannel->GetSampleOfNextEdge() - this->mChannel->GetSampleNumber() ) /
+                            SamplesPerBit() ) );
+        if( num_break_bits >= minBreakFieldBits ) { // if number of low bits are greater than minimum frame is valid
+            startingSample = this->mChannel->GetSampleNumber();
+            valid_frame = true;
+            break;
+        }
+    }
+}
+
+void MELIBUDecoder::SetEndingSampleInStopBit( S64& endingSample ) {
+    if( this->mChannel->GetSampleOfNextEdge() - this->mChannel->GetSampleNumber() > HalfSamplesPerBit() )
+        endingSample = this->mChannel->GetSampleNumber() + HalfSamplesPerBit();
+    else
+        endingSample = this->mChannel->GetSampleOfNextEdge();
+}
+
+bool MELIBUDecoder::SendAckByte( U8 idField1, U8 idField2 ) {
+    // ack is sent only when sent message is master to slave
+    return this->mSettings.mACK && ( this->mLayouts->Lookup( idField1, idField2 ).mFlags & MELIBUFrameLayout::ackExpected );
+}
+
+void MELIBUDecoder::AddToCrc( MELIBUByteRecord& byte ) {
+    switch( this->mFrameState ) {
+        case headerID1:
+        case headerID2:
+        case instruction1:
+        case instruction2:
+        case responseDataZero:
+        case responseData:
+            this->mCRC.add( byte.mData );
+            break;
+        default:
+            break;
+    }
+}
+
+template < class P >
+void MELIBUDecoder::ReadFrame( MELIBUByteRecord& byteFrame, bool& is_data_really_break, bool& byteFramingError ) {
+    is_data_really_break = false;
+    // read break or byte field; byteFramingError and is_data_really_break are set in functions
+    byteFrame.mFlags = 0;
+    if( ( this->mFrameState == NoFrame ) || ( this->mFrameState == headerBreak ) ) {
+        MELIBU_TIME( timerBreakSearch );
+        bool toggling = false;
+        byteFrame.mData = GetBreakField < P >( byteFrame.mStartingSampleInclusive,
+                                         byteFrame.mEndingSampleInclusive,
+                                         byteFramingError,
+                                         toggling );
+        byteFrame.mFlags |= ( toggling ? headerToggling : 0 );
+    } else if( this->mSettings.mByteDecoder == MELIBUDecoderSettings::byteDecoderTracking ) {
+        MELIBU_TIME( timerByteDecode );
+        byteFrame.mData = ByteFrameTracking < P >( byteFrame.mStartingSampleInclusive,
+                                             byteFrame.mEndingSampleInclusive,
+                                             byteFramingError,
+                                             is_data_really_break );
+    } else if( this->mSettings.mByteDecoder == MELIBUDecoderSettings::byteDecoderEdges ) {
+        MELIBU_TIME( timerByteDecode );
+        byteFrame.mData = ByteFrameEdges < P >( byteFrame.mStartingSampleInclusive,
+                                          byteFrame.mEndingSampleInclusive,
+                                          byteFramingError,
+                                          is_data_really_break );
+    } else {
+        MELIBU_TIME( timerByteDecode );
+        byteFrame.mData = ByteFrame < P >( byteFrame.mStartingSampleInclusive,
+                                     byteFrame.mEndingSampleInclusive,
+                                     byteFramingError,
+                                     is_data_really_break );
+    }
+    byteFrame.mIndex = 0;
+    byteFrame.mFlags |= ( byteFramingError ? MELIBUDecoder::byteFramingError : 0 );
+    byteFrame.mType = this->mFrameState;
+}
+
+template < class P >
+void MELIBUDecoder::CrcFrameValue( U16& crc, U64 data, U8 frameOrder ) {
+    if( frameOrder == 0 ) {
+        crc = data; // add first byte to crc: just set crc value
+    } else {
+        // add second byte to crc (connect with current value); for MELIBU 2 second byte is msb byte, for MELIBU 1 second byte is lsb
+        if( !P::CrcMsbFirst )
+            crc |= ( data << 8 );
+        else {
+            crc = crc << 8;
+            crc |= data;
+        }
+    }
+}
+
+void MELIBUDecoder::AddToPacket( MELIBUByteRecord& byte ) {
+    if( this->mPacketBytes == 0 ) {
+        this->mPacket = MELIBUPacketRecord();
+        this->mPacket.mStartingSampleInclusive = byte.mStartingSampleInclusive;
+        this->mPacket.mBus = this->mSettings.mBus;
+    }
+    this->mPacketBytes++;
+    this->mPacket.mEndingSampleInclusive = byte.mEndingSampleInclusive;
+    this->mPacket.mFlags |= byte.mFlags;
+
+    switch( byte.mType ) {
+        case headerID1:
+            this->mPacket.mID1 = byte.mData;
+            break;
+        case headerID2:
+            this->mPacket.mID2 = byte.mData;
+            break;
+        case instruction1:
+            this->mPacket.mHasInstruction = true;
+            this->mPacket.mInstruction = byte.mData;
+            break;
+        case instruction2:
+            this->mPacket.mInstruction |= ( U16 )byte.mData << 8;
+            break;
+        case responseDataZero:
+        case responseData:
+            if( this->mPacket.mDataLength == 0 )
+                this->mPacket.mDataStartingSample = byte.mStartingSampleInclusive;
+            if( this->mPacket.mDataLength < MELIBUPacketRecord::MaxDataBytes )
+                this->mPacket.mData[ this->mPacket.mDataLength++ ] = byte.mData;
+            break;
+        case responseCRC1:
+            this->mPacket.mCalculatedCrc = byte.mCrc;
+            break;
+        case responseCRC2:
+            this->mPacket.mReceivedCrc = this->mCrcValue;
+            break;
+        case responseACK:
+            this->mPacket.mHasAck = true;
+            this->mPacket.mAck = byte.mData;
+            break;
+        default:
+            break;
+    }
+}
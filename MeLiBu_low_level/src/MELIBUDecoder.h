@@ -0,0 +1,197 @@
+#ifndef MELIBU_DECODER_H
+#define MELIBU_DECODER_H
+
+#include "MELIBUTypes.h"
+#include "MELIBUCrc.h"
+#include "MELIBUProtocol.h"
+#include "MELIBUFrameLayout.h"
+
+class MELIBUChannel;
+
+// decoder configuration; filled from MELIBUAnalyzerSettings by the plugin or directly by offline tools
+struct MELIBUDecoderSettings
+{
+    typedef enum {
+        byteDecoderSampling = 0, // advance to middle of each bit and sample it
+        byteDecoderEdges = 1,    // reconstruct byte from edge positions
+        byteDecoderTracking = 2  // edge positions, bit clock re-anchored on every edge; works from 3x oversampling
+    } tMELIBUByteDecoder;
+
+    typedef enum {
+        markersAllBits = 0,   // start, stop, data and break bits
+        markersStartStop = 1, // errors, start and stop bits
+        markersErrors = 2     // errors only
+    } tMELIBUMarkerLevel;
+
+    MELIBUDecoderSettings();
+
+    U32 mSampleRateHz;
+    U32 mBitRate;
+    double mMELIBUVersion;
+    bool mACK;
+    U8 mACKValue; // valid ack value of protocols with ConfigurableAck (MeLiBu 2)
+    U32 mByteDecoder; // tMELIBUByteDecoder
+    U32 mMarkerLevel; // tMELIBUMarkerLevel
+    U8 mBus;          // bus index copied to byte and message records; multi-bus decoding
+};
+
+// one decoded byte field: break, header, instruction, data, crc or ack
+struct MELIBUByteRecord
+{
+    S64 mStartingSampleInclusive;
+    S64 mEndingSampleInclusive;
+    U8 mData;  // byte value
+    U8 mIndex; // number of data bytes read in message so far; for data bytes this is data index + 1
+    U8 mType;  // MELIBUDecoder::tMELIBUFrameState
+    U8 mFlags; // MELIBUDecoder::tMELIBUFrameFlags
+    U16 mCrc;  // crc calculated over message bytes read so far
+    U8 mBus;   // MELIBUDecoderSettings::mBus
+};
+
+// one message from break field to crc or ack byte
+struct MELIBUPacketRecord
+{
+    enum { MaxDataBytes = 128 };
+
+    S64 mStartingSampleInclusive;
+    S64 mEndingSampleInclusive;
+    U8 mID1;
+    U8 mID2;
+    bool mHasInstruction;
+    U16 mInstruction; // instruction word; only MeLiBu 2
+    U8 mDataLength;   // number of data bytes read
+    S64 mDataStartingSample; // start of first data byte; only valid if mDataLength is not 0
+    U8 mData[ MaxDataBytes ];
+    U16 mReceivedCrc;
+    U16 mCalculatedCrc;
+    bool mHasAck;
+    U8 mAck;
+    U8 mFlags;      // flags of all bytes in message
+    bool mComplete; // false if message was interrupted by break field or new message
+    U8 mBus;        // MELIBUDecoderSettings::mBus
+};
+
+// receives decoder output; the plugin forwards it to AnalyzerResults
+class MELIBUDecoderListener
+{
+ public:
+    virtual ~MELIBUDecoderListener() {}
+
+    virtual void OnMarker( U64 sample_number, U8 marker ) = 0;           // marker is MELIBUDecoder::tMELIBUMarker
+    virtual void OnByte( const MELIBUByteRecord& byte ) = 0;
+    virtual void OnMissingByte( S64 starting_sample, S64 ending_sample ) = 0; // break field found instead of byte
+    virtual void OnPacket( const MELIBUPacketRecord& packet ) = 0;            // end of message (complete or not)
+    virtual void OnProgress( S64 sample_number ) = 0;                         // called after every byte
+    virtual void OnIdle( S64 /*sample_number*/ ) {} // all captured data is decoded; decoding waits for more data next
+    virtual void OnBus( U8 /*bus*/ ) {} // multi-bus decoding: following calls are output of this bus
+};
+
+// MeLiBu protocol state machine; reads bits from MELIBUChannel and reports bytes and messages to listener
+// protocol dependent functions are templates on protocol traits (MELIBUProtocol.h); Setup selects instantiation once
+class MELIBUDecoder
+{
+ public:
+    typedef enum {
+        NoFrame = 0,
+        // Header
+        headerBreak,
+        headerID1,
+        headerID2,
+        // Instruction
+        instruction1,
+        instruction2,
+        // Response
+        responseDataZero,
+        responseData,
+        responseCRC1,
+        responseCRC2,
+        responseACK
+
+    } tMELIBUFrameState;
+
+    typedef enum {
+        Okay = 0x00,
+        byteFramingError = 0x01,
+        headerBreakExpected = 0x02,
+        crcMismatch = 0x04,
+        receptionFailed = 0x08,
+        headerToggling = 0x10
+    } tMELIBUFrameFlags;
+
+    typedef enum {
+        markerStart,
+        markerStop,
+        markerOne,
+        markerZero,
+        markerErrorDot,
+        markerErrorSquare,
+        markerErrorX
+    } tMELIBUMarker;
+
+ public:
+    MELIBUDecoder( MELIBUChannel* channel, MELIBUDecoderListener* listener );
+    ~MELIBUDecoder();
+
+    void Setup( const MELIBUDecoderSettings& settings );
+    void Start();       // synchronize to idle (high) level; call once before DecodeFrame
+    bool DecodeFrame(); // decode next byte field; returns false when channel has no more data
+    void Decode();      // decode until end of channel data
+
+    // segment decoding: decoders that are at message boundary at the same sample produce the same output from there on
+    // DecodeFrame that returns false does not change protocol state; it can be repeated from the same sample
+    bool AtMessageBoundary() const; // no message in progress
+    void Attach( MELIBUChannel* channel, MELIBUDecoderListener* listener ); // continue on another channel at the same sample
+
+    U8 NumberOfDataBytes( U8 idField1, U8 idField2 ); // calucalte number of expected data bytes after header
+    bool SendAckByte( U8 idField1, U8 idField2 );
+
+ protected:
+    double SamplesPerBit();
+    double HalfSamplesPerBit();
+    void AdvanceHalfBit();
+    void Advance( U16 nBits );
+    U64 BitCenterOffset( U32 bit ); // samples from start of byte to middle of bit; bit 0 is start bit
+    U32 BitsBetween( U64 from, U64 to ); // number of bit periods from one edge to another, rounded
+    void AddMarker( U64 sample_number, tMELIBUMarker marker ); // forward marker to listener if enabled by marker level
+
+    template < class P > bool DecodeFrameT();
+    template < class P > U8 GetBreakField( S64& startingSample, S64& endingSample, bool& framingError, bool& toggling );
+    template < class P > U8 ByteFrame( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field );
+    template < class P > U8 ByteFrameEdges( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field );
+    template < class P > U8 ByteFrameTracking( S64& startingSample, S64& endingSample, bool& framingError, bool& is_break_field );
+    template < class P > bool StopBit( S64& endingSample, bool& framingError, bool all_break_clear ); // true if break field found
+    void StartingSampleInBreakField( U32& minBreakFieldBits,
+                                     S64& startingSample,
+                                     U32& num_break_bits,
+                                     bool& valid_frame,
+                                     bool& toggling );
+    void SetEndingSampleInStopBit( S64& endingSample ); // call this function when stop bit is sampled in the middle
+    void AddToCrc( MELIBUByteRecord& byte );
+    template < class P > void ReadFrame( MELIBUByteRecord& byteFrame, bool& is_data_really_break, bool& byteFramingError );
+    template < class P > void CrcFrameValue( U16& crc, U64 data, U8 frameOrder );
+    void AddToPacket( MELIBUByteRecord& byte );
+
+ protected: //vars
+    MELIBUChannel* mChannel;
+    MELIBUDecoderListener* mListener;
+    MELIBUDecoderSettings mSettings;
+    MELIBUProtocol::tVersion mProtocol;
+    const MELIBUFrameLayoutTable* mLayouts; // layouts of selected protocol
+    bool ( MELIBUDecoder::* mDecodeFrame )(); // DecodeFrameT instantiation for selected protocol
+    double mSamplesPerBit;
+    U64 mBitPeriodFixed;  // samples per bit; 16 fractional bits
+    U64 mHalfBitFixed;
+    U8 mMarkerMask; // bit (1 << tMELIBUMarker) is set for each enabled marker
+
+    tMELIBUFrameState mFrameState;
+    MELIBUCrc mCRC;
+    MELIBUPacketRecord mPacket;
+    U32 mPacketBytes; // bytes reported since last packet boundary
+
+    MELIBUFrameLayout mLayout; // layout of current message; set when header is read
+    U8 mDataBytes; // number of data bytes left in message
+    U8 mID[ 2 ];   // header id values
+    U16 mCrcValue; // crc value read from crc byte fields
+};
+
+#endif //MELIBU_DECODER_H
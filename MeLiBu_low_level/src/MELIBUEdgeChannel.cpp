@@ -0,0 +1,96 @@
+#include "MELIBUEdgeChannel.h"
+#include "MELIBUInstrumentation.h"
+#include <algorithm>
+
+MELIBUEdgeChannel::MELIBUEdgeChannel( const U64* edges, U64 num_edges, bool initial_high, U64 start_sample, U64 end_sample )
+    :   mEdges( edges ),
+    mNumEdges( num_edges ),
+    mNextEdge( 0 ),
+    mInitialHigh( initial_high ),
+    mSample( start_sample ),
+    mEndSample( end_sample ),
+    mOpenEnd( false ) {
+    // initial bit state is the state at start sample; skip edges before it
+    while( mNextEdge < mNumEdges && mEdges[ mNextEdge ] <= mSample )
+        mNextEdge++;
+    if( mNextEdge & 1 )
+        mInitialHigh = !mInitialHigh;
+    mEdges += mNextEdge;
+    mNumEdges -= mNextEdge;
+    mNextEdge = 0;
+}
+
+MELIBUEdgeChannel::MELIBUEdgeChannel( const std::vector < U64 >& edges, bool initial_high, U64 end_sample )
+    :   mEdges( edges.empty() ? 0 : &edges[ 0 ] ),
+    mNumEdges( edges.size() ),
+    mNextEdge( 0 ),
+    mInitialHigh( initial_high ),
+    mSample( 0 ),
+    mEndSample( end_sample ),
+    mOpenEnd( false ) {}
+
+MELIBUEdgeChannel::~MELIBUEdgeChannel() {}
+
+void MELIBUEdgeChannel::OpenEnd() {
+    this->mOpenEnd = true;
+}
+
+U64 MELIBUEdgeChannel::GetSampleNumber() {
+    return this->mSample;
+}
+
+bool MELIBUEdgeChannel::IsHigh() {
+    // every passed edge toggles the initial state
+    return ( this->mNextEdge & 1 ) ? !this->mInitialHigh : this->mInitialHigh;
+}
+
+U32 MELIBUEdgeChannel::Advance( U32 num_samples ) {
+    return AdvanceToAbsPosition( this->mSample + num_samples );
+}
+
+U32 MELIBUEdgeChannel::AdvanceToAbsPosition( U64 sample_number ) {
+    U32 transitions { 0 };
+    MELIBU_COUNT( counterChannelCalls, 1 );
+    if( sample_number < this->mSample )
+        return transitions; // only possible after end of data was reached
+    while( this->mNextEdge < this->mNumEdges && this->mEdges[ this->mNextEdge ] <= sample_number ) {
+        this->mNextEdge++;
+        transitions++;
+    }
+    this->mSample = sample_number;
+    MELIBU_COUNT( counterEdges, transitions );
+    return transitions;
+}
+
+void MELIBUEdgeChannel::AdvanceToNextEdge() {
+    MELIBU_COUNT( counterChannelCalls, 1 );
+    MELIBU_COUNT( counterEdges, 1 );
+    if( this->mNextEdge < this->mNumEdges )
+        this->mSample = this->mEdges[ this->mNextEdge++ ];
+    else
+        this->mSample = this->mEndSample; // no more edges; move to the end of data
+}
+
+U64 MELIBUEdgeChannel::GetSampleOfNextEdge() {
+    if( this->mNextEdge < this->mNumEdges )
+        return this->mEdges[ this->mNextEdge ];
+    if( this->mOpenEnd )
+        this->mEndSample = std::min( this->mEndSample, this->mSample ); // next edge is not known yet
+    return this->mEndSample;
+}
+
+bool MELIBUEdgeChannel::WouldAdvancingCauseTransition( U32 num_samples ) {
+    if( this->mNextEdge < this->mNumEdges )
+        return this->mEdges[ this->mNextEdge ] <= this->mSample + num_samples;
+    if( this->mOpenEnd && this->mSample + num_samples >= this->mEndSample )
+        this->mEndSample = std::min( this->mEndSample, this->mSample ); // line after end sample is not known yet
+    return false;
+}
+
+bool MELIBUEdgeChannel::AtEnd() {
+    return this->mSample >= this->mEndSample;
+}
+
+bool MELIBUEdgeChannel::MoreEdgesAvailable() {
+    return this->mNextEdge < this->mNumEdges;
+}
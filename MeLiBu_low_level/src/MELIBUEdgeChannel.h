@@ -0,0 +1,43 @@
+#ifndef MELIBU_EDGE_CHANNEL_H
+#define MELIBU_EDGE_CHANNEL_H
+
+#include "MELIBUChannel.h"
+#include <vector>
+
+// channel reconstructed from edge timestamps (sample numbers of transitions) and initial bit state
+// used to decode captured bus traffic without the Logic application
+class MELIBUEdgeChannel: public MELIBUChannel
+{
+ public:
+    // edges must be sorted; end_sample is the first sample after the captured data
+    MELIBUEdgeChannel( const U64* edges, U64 num_edges, bool initial_high, U64 start_sample, U64 end_sample );
+    MELIBUEdgeChannel( const std::vector < U64 >& edges, bool initial_high, U64 end_sample );
+    virtual ~MELIBUEdgeChannel();
+
+    // edges after end sample are not known yet; asking for an edge after the last one ends data at current sample
+    void OpenEnd();
+
+    virtual U64 GetSampleNumber();
+    virtual bool IsHigh();
+
+    virtual U32 Advance( U32 num_samples );
+    virtual U32 AdvanceToAbsPosition( U64 sample_number );
+    virtual void AdvanceToNextEdge();
+
+    virtual U64 GetSampleOfNextEdge();
+    virtual bool WouldAdvancingCauseTransition( U32 num_samples );
+
+    virtual bool AtEnd();
+    virtual bool MoreEdgesAvailable();
+
+ protected:
+    const U64* mEdges;
+    U64 mNumEdges;
+    U64 mNextEdge; // index of first edge after current sample
+    bool mInitialHigh;
+    U64 mSample;
+    U64 mEndSample;
+    bool mOpenEnd;
+};
+
+#endif //MELIBU_EDGE_CHANNEL_H
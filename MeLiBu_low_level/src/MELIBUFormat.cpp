@@ -0,0 +1,384 @@
+#include "MELIBUFormat.h"
+#include "MELIBUDecoder.h"
+#include "MELIBUPacketStore.h"
+#include "MELIBUBusStatistics.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    // indexed by MELIBUDecoder::tMELIBUFrameState
+    constexpr const char* kFrameTypeNames[] = {
+        "no_frame",          // NoFrame
+        "breakfield",        // headerBreak
+        "header_ID1",        // headerID1
+        "header_ID2",        // headerID2
+        "instruction_byte1", // instruction1
+        "instruction_byte2", // instruction2
+        "data",              // responseDataZero
+        "data",              // responseData
+        "crc1",              // responseCRC1
+        "crc2",              // responseCRC2
+        "ack"                // responseACK
+    };
+    static_assert( sizeof( kFrameTypeNames ) / sizeof( kFrameTypeNames[ 0 ] ) == MELIBUDecoder::responseACK + 1,
+                   "frame type name missing" );
+
+    // indexed by bit of MELIBUDecoder::tMELIBUFrameFlags
+    constexpr const char* kFlagNames[ MELIBUFormat::FlagCount ] = {
+        "byte_framing_error",    // byteFramingError
+        "header_break_expected", // headerBreakExpected
+        "crc_mismatch",          // crcMismatch
+        "reception_failed",      // receptionFailed
+        "unexpected_data"        // headerToggling
+    };
+    static_assert( ( 1 << ( MELIBUFormat::FlagCount - 1 ) ) == MELIBUDecoder::headerToggling, "flag name missing" );
+
+    // hex strings of all byte and word values; built once when plugin is loaded
+    struct HexStrings
+    {
+        char mByte[ 256 ][ 5 ];
+        char mWord[ 65536 ][ 7 ];
+
+        HexStrings() {
+            static const char digits[] = "0123456789ABCDEF";
+            for( U32 value = 0; value < 65536; value++ ) {
+                char* s = this->mWord[ value ];
+                s[ 0 ] = '0';
+                s[ 1 ] = 'x';
+                for( U32 i = 0; i < 4; i++ )
+                    s[ 2 + i ] = digits[ ( value >> ( 12 - 4 * i ) ) & 0x0F ];
+                s[ 6 ] = '\0';
+            }
+            for( U32 value = 0; value < 256; value++ ) {
+                char* s = this->mByte[ value ];
+                s[ 0 ] = '0';
+                s[ 1 ] = 'x';
+                s[ 2 ] = digits[ value >> 4 ];
+                s[ 3 ] = digits[ value & 0x0F ];
+                s[ 4 ] = '\0';
+            }
+        }
+    };
+
+    const HexStrings kHex;
+}
+
+const char* MELIBUFormat::FrameTypeName( U8 type ) {
+    if( type > MELIBUDecoder::responseACK )
+        return kFrameTypeNames[ MELIBUDecoder::NoFrame ];
+    return kFrameTypeNames[ type ];
+}
+
+const char* MELIBUFormat::FlagName( U8 bit ) {
+    return kFlagNames[ bit ];
+}
+
+const char* MELIBUFormat::ByteHex( U8 value ) {
+    return kHex.mByte[ value ];
+}
+
+const char* MELIBUFormat::WordHex( U16 value ) {
+    return kHex.mWord[ value ];
+}
+
+U32 MELIBUFormat::FormatTime( char* out, S64 samples, U32 sample_rate ) {
+    char* p = out;
+    U64 abs_samples = samples;
+    if( samples < 0 ) {
+        *p++ = '-';
+        abs_samples = -( U64 )samples;
+    }
+    // rounded to nearest nanosecond like AnalyzerHelpers::GetTimeString, which prints the time as double
+    // exact halves (e.g. odd samples at 16 MHz) go to the side the double is on, so they are printed the same way
+    U64 seconds = abs_samples / sample_rate;
+    U64 fraction = ( abs_samples % sample_rate ) * 1000000000ULL; // remainder < 2^32, fits in U64
+    U64 nanoseconds = fraction / sample_rate;
+    U64 rest = fraction % sample_rate;
+    if( 2 * rest == sample_rate )
+        return ( U32 )snprintf( out, 32, "%.9f", ( double )samples / sample_rate );
+    if( 2 * rest > sample_rate && ++nanoseconds == 1000000000ULL ) {
+        seconds++;
+        nanoseconds = 0;
+    }
+
+    char digits[ 20 ];
+    U32 n = 0;
+    do {
+        digits[ n++ ] = '0' + seconds % 10;
+        seconds /= 10;
+    } while( seconds != 0 );
+    while( n != 0 )
+        *p++ = digits[ --n ];
+
+    *p++ = '.';
+    for( int i = 8; i >= 0; i-- ) {
+        p[ i ] = '0' + nanoseconds % 10;
+        nanoseconds /= 10;
+    }
+    p += 9;
+    *p = '\0';
+    return p - out;
+}
+
+const char* MELIBUFormat::ByteRowHeader() {
+    return "Type,Time [s],Value,Error\n";
+}
+
+void MELIBUFormat::AppendByteRow( std::string& out, U8 type, S64 samples, U32 sample_rate, const char* value, U8 flags ) {
+    char time_str[ 32 ];
+    out += FrameTypeName( type );
+    out += ',';
+    out.append( time_str, FormatTime( time_str, samples, sample_rate ) );
+    out += ',';
+    out += value;
+    out += ',';
+    for( U8 bit = 0; bit < FlagCount; bit++ ) {
+        if( flags & ( 1 << bit ) ) {
+            out += FlagName( bit );
+            out += ' ';
+        }
+    }
+    out += '\n';
+}
+
+const char* MELIBUFormat::BusColumnHeader() {
+    return "Bus,";
+}
+
+void MELIBUFormat::AppendBusColumn( std::string& out, U8 bus ) {
+    out += std::to_string( ( U32 )bus + 1 );
+    out += ',';
+}
+
+const char* MELIBUFormat::PacketRowHeader() {
+    return "Start [s],End [s],ID1,ID2,Instruction,Length,Data,CRC received,CRC calculated,ACK,Error\n";
+}
+
+void MELIBUFormat::AppendPacketRow( std::string& out,
+                                    const MELIBUPacketSummary& packet,
+                                    const U8* data,
+                                    U64 trigger_sample,
+                                    U32 sample_rate ) {
+    char str[ 32 ];
+    out.append( str, FormatTime( str, ( S64 )( packet.mStartingSampleInclusive - trigger_sample ), sample_rate ) );
+    out += ',';
+    out.append( str, FormatTime( str, ( S64 )( packet.mEndingSampleInclusive - trigger_sample ), sample_rate ) );
+    out += ',';
+    out += ByteHex( packet.mID1 );
+    out += ',';
+    out += ByteHex( packet.mID2 );
+    out += ',';
+    if( packet.mFields & MELIBUPacketSummary::hasInstruction )
+        out += WordHex( packet.mInstruction );
+    out += ',';
+    out += std::to_string( ( U32 )packet.mDataLength );
+    out += ',';
+    // payload as hex string without separators
+    for( U32 i = 0; i < packet.mDataLength; i++ )
+        out.append( ByteHex( data[ i ] ) + 2, 2 );
+    out += ',';
+    if( packet.mFields & MELIBUPacketSummary::complete ) {
+        out += WordHex( packet.mReceivedCrc );
+        out += ',';
+        out += WordHex( packet.mCalculatedCrc );
+    } else
+        out += ',';
+    out += ',';
+    if( packet.mFields & MELIBUPacketSummary::hasAck )
+        out += ByteHex( packet.mAck );
+    out += ',';
+    for( U8 bit = 0; bit < FlagCount; bit++ ) {
+        if( packet.mFlags & ( 1 << bit ) ) {
+            out += FlagName( bit );
+            out += ' ';
+        }
+    }
+    if( !( packet.mFields & MELIBUPacketSummary::complete ) )
+        out += "incomplete ";
+    out += '\n';
+}
+
+void MELIBUFormat::AppendPacketSummary( std::string& out, const MELIBUPacketSummary& packet, const U8* data ) {
+    out += "ID ";
+    out += ByteHex( packet.mID1 );
+    out += ' ';
+    out += ByteHex( packet.mID2 );
+    if( packet.mFields & MELIBUPacketSummary::hasInstruction ) {
+        out += " | INST ";
+        out += WordHex( packet.mInstruction );
+    }
+    out += " | ";
+    out += std::to_string( ( U32 )packet.mDataLength );
+    out += ':';
+    for( U32 i = 0; i < packet.mDataLength; i++ ) {
+        out += ' ';
+        out.append( ByteHex( data[ i ] ) + 2, 2 );
+    }
+    if( packet.mFields & MELIBUPacketSummary::complete ) {
+        if( packet.mReceivedCrc == packet.mCalculatedCrc )
+            out += " | CRC OK";
+        else {
+            out += " | CRC ";
+            out += WordHex( packet.mReceivedCrc );
+            out += " != ";
+            out += WordHex( packet.mCalculatedCrc );
+        }
+    } else
+        out += " | INCOMPLETE";
+    if( packet.mFields & MELIBUPacketSummary::hasAck ) {
+        out += " | ACK ";
+        out += ByteHex( packet.mAck );
+    }
+    for( U8 bit = 0; bit < FlagCount; bit++ ) {
+        if( packet.mFlags & ( 1 << bit ) ) {
+            out += " !";
+            out += FlagName( bit );
+        }
+    }
+}
+
+namespace
+{
+    void AppendTime( std::string& out, S64 samples, U32 sample_rate ) {
+        char str[ 32 ];
+        out.append( str, MELIBUFormat::FormatTime( str, samples, sample_rate ) );
+    }
+
+    void AppendPercent( std::string& out, U64 part, U64 total ) {
+        char str[ 32 ];
+        snprintf( str, sizeof( str ), "%.2f", total != 0 ? 100.0 * double( part ) / double( total ) : 0.0 );
+        out += str;
+    }
+}
+
+void MELIBUFormat::AppendStatistics( std::string& out,
+                                     const std::vector < MELIBUBusCounters >& buses,
+                                     U64 trigger_sample,
+                                     U32 sample_rate ) {
+    out += "Bus,Start [s],End [s],Bytes,Messages,Incomplete,Missing bytes,Load [%],Gap min [s],Gap mean [s],Gap max [s]\n";
+    for( U8 bus = 0; bus < buses.size(); bus++ ) {
+        const MELIBUBusCounters& counters = buses[ bus ];
+        AppendBusColumn( out, bus );
+        if( counters.mFirstSample >= 0 ) {
+            AppendTime( out, counters.mFirstSample - ( S64 )trigger_sample, sample_rate );
+            out += ',';
+            AppendTime( out, counters.mLastSample - ( S64 )trigger_sample, sample_rate );
+            out += ',';
+        } else
+            out += ",,";
+        out += std::to_string( counters.mBytes );
+        out += ',';
+        out += std::to_string( counters.mPackets );
+        out += ',';
+        out += std::to_string( counters.mIncompletePackets );
+        out += ',';
+        out += std::to_string( counters.mMissingBytes );
+        out += ',';
+        AppendPercent( out, counters.mBusySamples, counters.mFirstSample >= 0 ? counters.mLastSample - counters.mFirstSample + 1 : 0 );
+        out += ',';
+        if( counters.mGapCount != 0 ) {
+            AppendTime( out, counters.mGapSamplesMin, sample_rate );
+            out += ',';
+            AppendTime( out, counters.mGapSamplesSum / counters.mGapCount, sample_rate );
+            out += ',';
+            AppendTime( out, counters.mGapSamplesMax, sample_rate );
+        } else
+            out += ",";
+        out += '\n';
+    }
+
+    // errors by flag; bytes with flag and messages containing such byte
+    out += "\nBus,Error,Bytes,Messages\n";
+    for( U8 bus = 0; bus < buses.size(); bus++ ) {
+        for( U8 bit = 0; bit < FlagCount; bit++ ) {
+            AppendBusColumn( out, bus );
+            out += FlagName( bit );
+            out += ',';
+            out += std::to_string( buses[ bus ].mFlagBytes[ bit ] );
+            out += ',';
+            out += std::to_string( buses[ bus ].mFlagPackets[ bit ] );
+            out += '\n';
+        }
+    }
+
+    out += "\nBus,ID1,ID2,Messages,Data bytes,Incomplete";
+    for( U8 bit = 0; bit < FlagCount; bit++ ) {
+        out += ',';
+        out += FlagName( bit );
+    }
+    out += '\n';
+    for( U8 bus = 0; bus < buses.size(); bus++ ) {
+        std::vector < U16 > ids;
+        for( const auto& id : buses[ bus ].mIds )
+            ids.push_back( id.first );
+        std::sort( ids.begin(), ids.end() );
+        for( U16 key : ids ) {
+            const MELIBUIdCounters& id = buses[ bus ].mIds.at( key );
+            AppendBusColumn( out, bus );
+            out += ByteHex( key >> 8 );
+            out += ',';
+            out += ByteHex( key & 0xFF );
+            out += ',';
+            out += std::to_string( id.mPackets );
+            out += ',';
+            out += std::to_string( id.mDataBytes );
+            out += ',';
+            out += std::to_string( id.mIncompletePackets );
+            for( U8 bit = 0; bit < FlagCount; bit++ ) {
+                out += ',';
+                out += std::to_string( id.mFlagPackets[ bit ] );
+            }
+            out += '\n';
+        }
+    }
+
+    // gap histogram; buckets without messages are left out
+    out += "\nBus,Gap from [bits],Gap to [bits],Messages\n";
+    for( U8 bus = 0; bus < buses.size(); bus++ ) {
+        for( U32 bucket = 0; bucket < MELIBUBusCounters::GapBuckets; bucket++ ) {
+            if( buses[ bus ].mGaps[ bucket ] == 0 )
+                continue;
+            AppendBusColumn( out, bus );
+            out += bucket == 0 ? "0" : std::to_string( 1ULL << ( bucket - 1 ) );
+            out += ',';
+            if( bucket + 1 < MELIBUBusCounters::GapBuckets )
+                out += std::to_string( 1ULL << bucket );
+            out += ',';
+            out += std::to_string( buses[ bus ].mGaps[ bucket ] );
+            out += '\n';
+        }
+    }
+
+    out += "\nBus,Data bytes,Messages\n";
+    for( U8 bus = 0; bus < buses.size(); bus++ ) {
+        for( U32 length = 0; length <= MELIBUPacketRecord::MaxDataBytes; length++ ) {
+            if( buses[ bus ].mLengths[ length ] == 0 )
+                continue;
+            AppendBusColumn( out, bus );
+            out += std::to_string( length );
+            out += ',';
+            out += std::to_string( buses[ bus ].mLengths[ length ] );
+            out += '\n';
+        }
+    }
+
+    out += "\nBus,Interval start [s],Load [%],Bytes,Messages,Error messages,Missing bytes\n";
+    for( U8 bus = 0; bus < buses.size(); bus++ ) {
+        for( const auto& interval : buses[ bus ].mIntervals ) {
+            AppendBusColumn( out, bus );
+            AppendTime( out, interval.mStartingSampleInclusive - ( S64 )trigger_sample, sample_rate );
+            out += ',';
+            AppendPercent( out, interval.mBusySamples, interval.mEndingSampleInclusive - interval.mStartingSampleInclusive + 1 );
+            out += ',';
+            out += std::to_string( interval.mBytes );
+            out += ',';
+            out += std::to_string( interval.mPackets );
+            out += ',';
+            out += std::to_string( interval.mErrorPackets );
+            out += ',';
+            out += std::to_string( interval.mMissingBytes );
+            out += '\n';
+        }
+    }
+}
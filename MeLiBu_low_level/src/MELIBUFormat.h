@@ -0,0 +1,45 @@
+#ifndef MELIBU_FORMAT_H
+#define MELIBU_FORMAT_H
+
+#include "MELIBUTypes.h"
+#include <string>
+#include <vector>
+
+struct MELIBUPacketSummary;
+struct MELIBUBusCounters;
+
+// constant strings for results; returned pointers are valid for whole program run, nothing is allocated per call
+namespace MELIBUFormat
+{
+    enum { FlagCount = 5 }; // number of MELIBUDecoder::tMELIBUFrameFlags bits
+
+    const char* FrameTypeName( U8 type ); // FrameV2 type of MELIBUDecoder::tMELIBUFrameState
+    const char* FlagName( U8 bit );       // name of flag ( 1 << bit ); used as FrameV2 column name and in export
+    const char* ByteHex( U8 value );      // "0x00" - "0xFF"
+    const char* WordHex( U16 value );     // "0x0000" - "0xFFFF"
+
+    // time of samples relative to trigger in seconds with 9 decimals, e.g. "-0.000123456"
+    // out needs space for 32 characters; returns number of written characters without terminating zero
+    U32 FormatTime( char* out, S64 samples, U32 sample_rate );
+
+    // one export row per byte field; value is formatted byte value in selected display base
+    const char* ByteRowHeader();
+    void AppendByteRow( std::string& out, U8 type, S64 samples, U32 sample_rate, const char* value, U8 flags );
+
+    // bus column in front of export rows when several buses are decoded; buses are numbered from 1
+    const char* BusColumnHeader();
+    void AppendBusColumn( std::string& out, U8 bus );
+
+    // one export row per message
+    const char* PacketRowHeader();
+    void AppendPacketRow( std::string& out, const MELIBUPacketSummary& packet, const U8* data, U64 trigger_sample, U32 sample_rate );
+
+    // one line summary of message for tabular view, e.g. "ID 0x10 0x22 | 3: 1A 5C 7E | CRC OK | ACK 0x7E"
+    void AppendPacketSummary( std::string& out, const MELIBUPacketSummary& packet, const U8* data );
+
+    // statistics export: csv sections for bus totals, errors, header ids, gap and length histograms and bus load intervals
+    // sections are separated by empty lines; first column is bus
+    void AppendStatistics( std::string& out, const std::vector < MELIBUBusCounters >& buses, U64 trigger_sample, U32 sample_rate );
+}
+
+#endif //MELIBU_FORMAT_H
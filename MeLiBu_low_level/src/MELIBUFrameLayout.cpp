@@ -0,0 +1,37 @@
+#include "MELIBUFrameLayout.h"
+
+template < class P >
+MELIBUFrameLayoutTable::MELIBUFrameLayoutTable( const P& ) {
+    for( U32 id1 = 0; id1 < 256; id1++ ) {
+        for( U32 id2 = 0; id2 < 256; id2++ ) {
+            MELIBUFrameLayout& layout = this->mLayouts[ ( id1 << 8 ) | id2 ];
+            layout.mDataLength = P::NumberOfDataBytes( id1, id2 );
+            layout.mFlags = 0;
+            if( P::HasInstruction( id1, id2 ) )
+                layout.mFlags |= MELIBUFrameLayout::hasInstruction;
+            if( P::AckExpected( id1, id2 ) )
+                layout.mFlags |= MELIBUFrameLayout::ackExpected;
+        }
+    }
+}
+
+const MELIBUFrameLayoutTable& MELIBUFrameLayoutTable::Get( MELIBUProtocol::tVersion version ) {
+    switch( version ) {
+        case MELIBUProtocol::MeLiBu1:
+        {
+            static const MELIBUFrameLayoutTable table( ( MELIBUProtocol1() ) );
+            return table;
+        }
+        case MELIBUProtocol::MeLiBu1Extended:
+        {
+            static const MELIBUFrameLayoutTable table( ( MELIBUProtocol1Extended() ) );
+            return table;
+        }
+        case MELIBUProtocol::MeLiBu2:
+        default:
+        {
+            static const MELIBUFrameLayoutTable table( ( MELIBUProtocol2() ) );
+            return table;
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef MELIBU_FRAME_LAYOUT_H
+#define MELIBU_FRAME_LAYOUT_H
+
+#include "MELIBUTypes.h"
+#include "MELIBUProtocol.h"
+
+// message layout following header (ID1, ID2)
+struct MELIBUFrameLayout
+{
+    typedef enum {
+        hasInstruction = 0x01, // two instruction bytes follow header
+        ackExpected = 0x02     // ack byte follows crc when ack is enabled; only for master to slave messages
+    } tMELIBULayoutFlags;
+
+    U8 mDataLength; // number of data bytes in message
+    U8 mFlags;      // tMELIBULayoutFlags
+};
+
+// layout of all 65536 (ID1, ID2) combinations for one protocol version
+// tables are built once on first use and shared by all analyzer instances
+class MELIBUFrameLayoutTable
+{
+ public:
+    static const MELIBUFrameLayoutTable& Get( MELIBUProtocol::tVersion version );
+
+    const MELIBUFrameLayout& Lookup( U8 idField1, U8 idField2 ) const {
+        return this->mLayouts[ ( ( U16 )idField1 << 8 ) | idField2 ];
+    }
+
+ protected:
+    template < class P > explicit MELIBUFrameLayoutTable( const P& protocol );
+
+ protected: //vars
+    MELIBUFrameLayout mLayouts[ 65536 ];
+};
+
+#endif //MELIBU_FRAME_LAYOUT_H
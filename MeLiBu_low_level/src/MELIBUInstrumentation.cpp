@@ -0,0 +1,184 @@
+#include "MELIBUInstrumentation.h"
+
+#ifdef MELIBU_INSTRUMENTATION
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const char* const kCounterNames[ MELIBUInstrumentation::CounterCount ] = {
+        "edges", "channel calls", "bytes", "markers", "frames", "table rows", "packets", "commits"
+    };
+    const char* const kTimerNames[ MELIBUInstrumentation::TimerCount ] = {
+        "break search", "byte decode", "results", "commit"
+    };
+
+    // counters of one thread; written only by that thread, atomics make reads from Report well defined
+    struct ThreadCounters
+    {
+        ThreadCounters();
+        ~ThreadCounters();
+
+        std::atomic < U64 > mCounters[ MELIBUInstrumentation::CounterCount ];
+        std::atomic < U64 > mNanoseconds[ MELIBUInstrumentation::TimerCount ];
+        U32 mPhase; // running timer; TimerCount if none
+        Clock::time_point mPhaseStart;
+    };
+
+    // counters of running threads and sums of finished threads
+    struct Registry
+    {
+        Registry() : mStart( Clock::now() ) {
+            for( auto& value : mCounters )
+                value = 0;
+            for( auto& value : mNanoseconds )
+                value = 0;
+        }
+
+        std::mutex mMutex;
+        std::vector < ThreadCounters* > mThreads;
+        U64 mCounters[ MELIBUInstrumentation::CounterCount ];
+        U64 mNanoseconds[ MELIBUInstrumentation::TimerCount ];
+        Clock::time_point mStart;
+    };
+
+    Registry& GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    void Increment( std::atomic < U64 >& value, U64 n ) {
+        value.store( value.load( std::memory_order_relaxed ) + n, std::memory_order_relaxed );
+    }
+
+    ThreadCounters::ThreadCounters() : mPhase( MELIBUInstrumentation::TimerCount ) {
+        for( auto& value : this->mCounters )
+            value = 0;
+        for( auto& value : this->mNanoseconds )
+            value = 0;
+        Registry& registry = GetRegistry();
+        std::lock_guard < std::mutex > lock( registry.mMutex );
+        registry.mThreads.push_back( this );
+    }
+
+    ThreadCounters::~ThreadCounters() {
+        Registry& registry = GetRegistry();
+        std::lock_guard < std::mutex > lock( registry.mMutex );
+        for( U32 i = 0; i < MELIBUInstrumentation::CounterCount; i++ )
+            registry.mCounters[ i ] += this->mCounters[ i ];
+        for( U32 i = 0; i < MELIBUInstrumentation::TimerCount; i++ )
+            registry.mNanoseconds[ i ] += this->mNanoseconds[ i ];
+        registry.mThreads.erase( std::find( registry.mThreads.begin(), registry.mThreads.end(), this ) );
+    }
+
+    ThreadCounters& Local() {
+        static thread_local ThreadCounters counters;
+        return counters;
+    }
+
+    // charge time since last phase change to running phase and switch to phase
+    void SwitchPhase( ThreadCounters& counters, U32 phase ) {
+        Clock::time_point now = Clock::now();
+        if( counters.mPhase != MELIBUInstrumentation::TimerCount )
+            Increment( counters.mNanoseconds[ counters.mPhase ],
+                       std::chrono::duration_cast < std::chrono::nanoseconds >( now - counters.mPhaseStart ).count() );
+        counters.mPhase = phase;
+        counters.mPhaseStart = now;
+    }
+}
+
+void MELIBUInstrumentation::Add( tCounter counter, U64 n ) {
+    Increment( Local().mCounters[ counter ], n );
+}
+
+MELIBUInstrumentation::ScopeTimer::ScopeTimer( tTimer timer ) {
+    ThreadCounters& counters = Local();
+    this->mPrevious = counters.mPhase;
+    SwitchPhase( counters, timer );
+}
+
+MELIBUInstrumentation::ScopeTimer::~ScopeTimer() {
+    SwitchPhase( Local(), this->mPrevious );
+}
+
+void MELIBUInstrumentation::Reset() {
+    Registry& registry = GetRegistry();
+    std::lock_guard < std::mutex > lock( registry.mMutex );
+    for( auto& value : registry.mCounters )
+        value = 0;
+    for( auto& value : registry.mNanoseconds )
+        value = 0;
+    for( auto* thread : registry.mThreads ) {
+        for( auto& value : thread->mCounters )
+            value = 0;
+        for( auto& value : thread->mNanoseconds )
+            value = 0;
+    }
+    registry.mStart = Clock::now();
+}
+
+void MELIBUInstrumentation::Report( std::string& out, S64 last_sample, U32 sample_rate ) {
+    U64 counters[ CounterCount ];
+    U64 nanoseconds[ TimerCount ];
+    double wall_seconds;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard < std::mutex > lock( registry.mMutex );
+        for( U32 i = 0; i < CounterCount; i++ )
+            counters[ i ] = registry.mCounters[ i ];
+        for( U32 i = 0; i < TimerCount; i++ )
+            nanoseconds[ i ] = registry.mNanoseconds[ i ];
+        for( auto* thread : registry.mThreads ) {
+            for( U32 i = 0; i < CounterCount; i++ )
+                counters[ i ] += thread->mCounters[ i ];
+            for( U32 i = 0; i < TimerCount; i++ )
+                nanoseconds[ i ] += thread->mNanoseconds[ i ];
+        }
+        wall_seconds = std::chrono::duration < double >( Clock::now() - registry.mStart ).count();
+    }
+
+    char line[ 128 ];
+    out += "MeLiBu instrumentation\n";
+    for( U32 i = 0; i < CounterCount; i++ ) {
+        snprintf( line, sizeof( line ), "  %-16s %llu\n", kCounterNames[ i ], ( unsigned long long )counters[ i ] );
+        out += line;
+    }
+    // phase times are summed over all threads
+    for( U32 i = 0; i < TimerCount; i++ ) {
+        snprintf( line, sizeof( line ), "  %-16s %.3f ms\n", kTimerNames[ i ], nanoseconds[ i ] * 1e-6 );
+        out += line;
+    }
+
+    double capture_seconds = sample_rate != 0 ? double( std::max < S64 >( 0, last_sample ) ) / sample_rate : 0.0;
+    snprintf( line, sizeof( line ), "  %-16s %.3f s\n", "wall time", wall_seconds );
+    out += line;
+    snprintf( line, sizeof( line ), "  %-16s %.3f s\n", "capture time", capture_seconds );
+    out += line;
+    if( wall_seconds > 0.0 && capture_seconds > 0.0 ) {
+        snprintf( line, sizeof( line ), "  %-16s %.0f bytes/s decoded, %.0f bytes/s captured (%.2fx real time)\n", "rate",
+                  counters[ counterBytes ] / wall_seconds, counters[ counterBytes ] / capture_seconds, capture_seconds / wall_seconds );
+        out += line;
+    }
+}
+
+MELIBUInstrumentation::ExitReport::ExitReport( const S64* last_sample, U32 sample_rate )
+    :   mLastSample( last_sample ),
+    mSampleRate( sample_rate ) {}
+
+MELIBUInstrumentation::ExitReport::~ExitReport() {
+    try {
+        std::string report;
+        Report( report, *this->mLastSample, this->mSampleRate );
+        std::cerr << report;
+    } catch( ... ) {}
+}
+
+#endif //MELIBU_INSTRUMENTATION
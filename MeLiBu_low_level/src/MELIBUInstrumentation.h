@@ -0,0 +1,75 @@
+#ifndef MELIBU_INSTRUMENTATION_H
+#define MELIBU_INSTRUMENTATION_H
+
+#include "MELIBUTypes.h"
+#include <string>
+
+// decode counters and phase timers; compiled in only with cmake option MELIBU_INSTRUMENTATION
+// MELIBU_COUNT( counterEdges, n ) adds n to counter
+// MELIBU_TIME( timerByteDecode ) charges time until end of scope to phase; nested phases are not charged to outer phase
+#ifdef MELIBU_INSTRUMENTATION
+
+namespace MELIBUInstrumentation
+{
+    typedef enum {
+        counterEdges,        // channel transitions passed
+        counterChannelCalls, // Advance, AdvanceToAbsPosition and AdvanceToNextEdge calls
+        counterBytes,        // decoded break and byte fields
+        counterMarkers,
+        counterFrames,
+        counterFramesV2,     // table rows
+        counterPackets,
+        counterCommits,
+        CounterCount
+    } tCounter;
+
+    typedef enum {
+        timerBreakSearch, // GetBreakField
+        timerByteDecode,  // byte field decoding including channel traversal
+        timerResults,     // frames, rows, markers and packets added to results
+        timerCommit,      // CommitResults and ReportProgress
+        TimerCount
+    } tTimer;
+
+    // counters are kept per thread and summed by Report; threads of worker pools are included
+    void Add( tCounter counter, U64 n );
+
+    class ScopeTimer
+    {
+     public:
+        explicit ScopeTimer( tTimer timer );
+        ~ScopeTimer();
+
+     protected: //vars
+        U32 mPrevious; // phase of enclosing scope
+    };
+
+    void Reset(); // clears counters of all threads and starts wall clock; call when decoding starts
+
+    // counters, phase times and decode rate compared to capture rate; last_sample is last decoded sample
+    void Report( std::string& out, S64 last_sample, U32 sample_rate );
+
+    // writes report to stderr at end of scope; also when worker thread is stopped by exception from channel data
+    class ExitReport
+    {
+     public:
+        ExitReport( const S64* last_sample, U32 sample_rate );
+        ~ExitReport();
+
+     protected: //vars
+        const S64* mLastSample;
+        U32 mSampleRate;
+    };
+}
+
+#define MELIBU_COUNT( counter, n ) MELIBUInstrumentation::Add( MELIBUInstrumentation::counter, n )
+#define MELIBU_TIME( timer ) MELIBUInstrumentation::ScopeTimer melibu_scope_timer( MELIBUInstrumentation::timer )
+
+#else
+
+#define MELIBU_COUNT( counter, n ) do {} while( 0 )
+#define MELIBU_TIME( timer ) do {} while( 0 )
+
+#endif //MELIBU_INSTRUMENTATION
+
+#endif //MELIBU_INSTRUMENTATION_H
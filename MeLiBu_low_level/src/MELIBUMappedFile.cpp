@@ -0,0 +1,94 @@
+#include "MELIBUMappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MELIBUMappedFile::MELIBUMappedFile()
+    :   mData( nullptr ),
+    mSize( 0 )
+#ifdef _WIN32
+    ,
+    mFile( INVALID_HANDLE_VALUE ),
+    mMapping( nullptr )
+#endif
+{}
+
+MELIBUMappedFile::~MELIBUMappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MELIBUMappedFile::Open( const char* path ) {
+    Close();
+    this->mFile = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if( this->mFile == INVALID_HANDLE_VALUE )
+        return false;
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( this->mFile, &size ) || size.QuadPart == 0 ) {
+        Close();
+        return false;
+    }
+    this->mMapping = CreateFileMappingA( this->mFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if( this->mMapping == nullptr ) {
+        Close();
+        return false;
+    }
+    this->mData = static_cast < const U8* >( MapViewOfFile( this->mMapping, FILE_MAP_READ, 0, 0, 0 ) );
+    if( this->mData == nullptr ) {
+        Close();
+        return false;
+    }
+    this->mSize = ( U64 )size.QuadPart;
+    return true;
+}
+
+void MELIBUMappedFile::Close() {
+    if( this->mData != nullptr )
+        UnmapViewOfFile( this->mData );
+    if( this->mMapping != nullptr )
+        CloseHandle( this->mMapping );
+    if( this->mFile != INVALID_HANDLE_VALUE )
+        CloseHandle( this->mFile );
+    this->mData = nullptr;
+    this->mSize = 0;
+    this->mMapping = nullptr;
+    this->mFile = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MELIBUMappedFile::Open( const char* path ) {
+    Close();
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 )
+        return false;
+    struct stat info;
+    if( fstat( fd, &info ) != 0 || info.st_size == 0 ) {
+        close( fd );
+        return false;
+    }
+    // mapping stays valid after file is closed
+    void* data = mmap( nullptr, ( size_t )info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if( data == MAP_FAILED )
+        return false;
+    this->mData = static_cast < const U8* >( data );
+    this->mSize = ( U64 )info.st_size;
+    return true;
+}
+
+void MELIBUMappedFile::Close() {
+    if( this->mData != nullptr )
+        munmap( const_cast < U8* >( this->mData ), ( size_t )this->mSize );
+    this->mData = nullptr;
+    this->mSize = 0;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef MELIBU_MAPPED_FILE_H
+#define MELIBU_MAPPED_FILE_H
+
+#include "MELIBUTypes.h"
+
+// read-only memory mapping of a whole file; unmapped when destroyed
+class MELIBUMappedFile
+{
+ public:
+    MELIBUMappedFile();
+    ~MELIBUMappedFile();
+
+    bool Open( const char* path ); // false if file can't be opened, is empty or can't be mapped
+    void Close();
+
+    const U8* Data() const {
+        return this->mData;
+    }
+    U64 Size() const {
+        return this->mSize;
+    }
+
+ protected: //vars
+    const U8* mData;
+    U64 mSize;
+#ifdef _WIN32
+    void* mFile;    // file and mapping handles
+    void* mMapping;
+#endif
+};
+
+#endif //MELIBU_MAPPED_FILE_H
@@ -0,0 +1,196 @@
+#include "MELIBUMultiBusDecoder.h"
+#include "MELIBUChannel.h"
+#include "MELIBUEdgeChannel.h"
+#include <algorithm>
+#include <limits>
+
+MELIBUMultiBusDecoder::MELIBUMultiBusDecoder( MELIBUDecoderListener* listener, MELIBUWorkerPool* pool )
+    :   mListener( listener ),
+    mPool( pool ),
+    mWindowSamples( 1 ),
+    mByteSamples( 1 ) {}
+
+MELIBUMultiBusDecoder::~MELIBUMultiBusDecoder() {}
+
+void MELIBUMultiBusDecoder::Setup( const MELIBUDecoderSettings& settings,
+                                   const std::vector < MELIBUChannel* >& channels,
+                                   U64 window_samples ) {
+    this->mWindowSamples = std::max < U64 >( window_samples, 1 );
+    this->mByteSamples = std::max < U64 >( 1, 10 * ( U64 )settings.mSampleRateHz / std::max( 1U, settings.mBitRate ) );
+    this->mBuses.clear();
+    this->mBuses.resize( channels.size() );
+    for( size_t i = 0; i < channels.size(); i++ ) {
+        Bus& bus = this->mBuses[ i ];
+        MELIBUDecoderSettings bus_settings = settings;
+        bus_settings.mBus = ( U8 )i;
+        bus.mChannel = channels[ i ];
+        bus.mEdges.clear();
+        bus.mInitialHigh = channels[ i ]->IsHigh();
+        bus.mReadUntil = channels[ i ]->GetSampleNumber();
+        bus.mDecodeUntil = bus.mReadUntil;
+        bus.mResume = bus.mReadUntil;
+        bus.mDecoded = bus.mReadUntil;
+        bus.mOutput.reset( new MELIBUOutputBuffer() );
+        bus.mDecoder.reset( new MELIBUDecoder( nullptr, bus.mOutput.get() ) ); // channel is attached for every decoding
+        bus.mDecoder->Setup( bus_settings );
+        bus.mStarted = false;
+        bus.mReading = true;
+        bus.mDone = false;
+    }
+}
+
+void MELIBUMultiBusDecoder::Decode() {
+    U64 window_end = 0;
+    for( ;; ) {
+        bool reading = false;
+        for( auto& bus : this->mBuses )
+            reading = reading || bus.mReading;
+        if( !reading )
+            break;
+        window_end += this->mWindowSamples;
+        Read( window_end );
+        DecodeBuffers( true );
+    }
+    DecodeBuffers( true );
+    PassUnits( std::numeric_limits < S64 >::max() );
+
+    // channel data ended or thread has to stop; pass on exception after output of all buses
+    for( auto& bus : this->mBuses )
+        if( bus.mException )
+            std::rethrow_exception( bus.mException );
+}
+
+void MELIBUMultiBusDecoder::Read( U64 window_end ) {
+    // captured edges of all buses are read first, so a read that waits for data does not hold back other buses
+    for( auto& bus : this->mBuses )
+        ReadBus( bus, window_end, false );
+    for( auto& bus : this->mBuses )
+        ReadBus( bus, window_end, true );
+}
+
+void MELIBUMultiBusDecoder::ReadBus( Bus& bus, U64 window_end, bool wait ) {
+    MELIBUChannel* channel = bus.mChannel;
+    U64 step = this->mByteSamples;
+    try {
+        while( bus.mReading && channel->GetSampleNumber() < window_end ) {
+            U64 sample = channel->GetSampleNumber();
+            if( channel->MoreEdgesAvailable() ) {
+                if( channel->GetSampleOfNextEdge() <= window_end ) {
+                    channel->AdvanceToNextEdge();
+                    bus.mEdges.push_back( channel->GetSampleNumber() );
+                    step = this->mByteSamples;
+                } else
+                    channel->AdvanceToAbsPosition( window_end );
+            } else if( !wait )
+                return;
+            else {
+                // idle line past last captured edge: read may wait for data, at end of a finished capture forever
+                // all output is passed before; small first step completes last byte of capture
+                if( AllIdle() )
+                    this->mListener->OnIdle( DecodeBuffers( false ) );
+                channel->AdvanceToAbsPosition( std::min( window_end, sample + step ) );
+                step *= 2;
+            }
+            bus.mReadUntil = channel->GetSampleNumber();
+            if( channel->AtEnd() )
+                bus.mReading = false;
+        }
+    } catch( ... ) {
+        bus.mException = std::current_exception();
+        bus.mReading = false;
+    }
+}
+
+bool MELIBUMultiBusDecoder::AllIdle() {
+    for( auto& bus : this->mBuses )
+        if( bus.mReading && bus.mChannel->MoreEdgesAvailable() )
+            return false;
+    return true;
+}
+
+S64 MELIBUMultiBusDecoder::DecodeBuffers( bool parallel ) {
+    // line of bus without more captured edges does not change up to sample read on any bus
+    U64 known = 0;
+    for( auto& bus : this->mBuses )
+        known = std::max( known, bus.mReadUntil );
+    std::vector < MELIBUWorkerPool::tJob > jobs;
+    for( auto& bus : this->mBuses ) {
+        if( bus.mDone )
+            continue;
+        bus.mDecodeUntil = ( bus.mReading && bus.mChannel->MoreEdgesAvailable() ) ? bus.mReadUntil : known;
+        Bus* b = &bus;
+        if( parallel )
+            jobs.push_back( [ this, b ]() { DecodeBus( *b ); } );
+        else
+            DecodeBus( bus );
+    }
+    if( !jobs.empty() )
+        this->mPool->Run( jobs );
+
+    // next byte of a bus starts at or after its resume sample; output before earliest of them is complete
+    S64 passed = std::numeric_limits < S64 >::max();
+    for( auto& bus : this->mBuses )
+        if( !bus.mDone )
+            passed = std::min( passed, ( S64 )bus.mResume );
+    PassUnits( passed );
+    S64 decoded = known;
+    for( auto& bus : this->mBuses )
+        if( !bus.mDone )
+            decoded = std::min( decoded, ( S64 )bus.mDecoded );
+    return decoded;
+}
+
+void MELIBUMultiBusDecoder::DecodeBus( Bus& bus ) {
+    MELIBUEdgeChannel channel( bus.mEdges.data(), bus.mEdges.size(), bus.mInitialHigh, bus.mResume, bus.mDecodeUntil );
+    if( bus.mReading )
+        channel.OpenEnd(); // byte that needs next edge after read ones is decoded again later
+    bus.mDecoder->Attach( &channel, bus.mOutput.get() );
+    if( !bus.mStarted ) {
+        if( !channel.IsHigh() && bus.mEdges.empty() ) {
+            // line is low since start; first byte starts after next edge
+            bus.mResume = std::max( bus.mResume, bus.mDecodeUntil );
+            bus.mDecoded = bus.mResume;
+            bus.mDone = !bus.mReading;
+            return;
+        }
+        bus.mDecoder->Start(); // synchronize to idle level
+        bus.mStarted = true;
+    }
+
+    for( ;; ) {
+        U64 resume = channel.GetSampleNumber();
+        if( !bus.mDecoder->DecodeFrame() ) {
+            // read edges ended inside byte; it is decoded again when more edges are read
+            if( bus.mReading )
+                bus.mOutput->DropOpen();
+            else {
+                bus.mOutput->Close(); // channel stopped; keep output of unfinished byte as it is
+                bus.mDone = true;
+            }
+            bus.mResume = resume;
+            bus.mDecoded = std::min( channel.GetSampleNumber(), bus.mDecodeUntil );
+            break;
+        }
+    }
+
+    // edges before resume sample are not needed again
+    auto passed = std::upper_bound( bus.mEdges.begin(), bus.mEdges.end(), bus.mResume );
+    if( ( passed - bus.mEdges.begin() ) & 1 )
+        bus.mInitialHigh = !bus.mInitialHigh;
+    bus.mEdges.erase( bus.mEdges.begin(), passed );
+}
+
+void MELIBUMultiBusDecoder::PassUnits( S64 sample_number ) {
+    for( ;; ) {
+        Bus* first = nullptr;
+        for( auto& bus : this->mBuses ) {
+            if( bus.mOutput->HasUnit() && bus.mOutput->UnitStart() < sample_number &&
+                ( first == nullptr || bus.mOutput->UnitStart() < first->mOutput->UnitStart() ) )
+                first = &bus;
+        }
+        if( first == nullptr )
+            return;
+        this->mListener->OnBus( ( U8 )( first - &this->mBuses[ 0 ] ) );
+        first->mOutput->PassUnit( this->mListener );
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MELIBU_MULTI_BUS_DECODER_H
+#define MELIBU_MULTI_BUS_DECODER_H
+
+#include "MELIBUDecoder.h"
+#include "MELIBUOutputBuffer.h"
+#include "MELIBUWorkerPool.h"
+#include <exception>
+#include <memory>
+#include <vector>
+
+// decodes several MeLiBu buses with the same settings; one decoder per bus, shared frame layout table
+// capture is read in time windows: edges of all buses are read up to end of window by thread that called Decode,
+// then buses are decoded from their read edges in parallel and output is passed to listener byte by byte ordered
+// by starting sample (all calls from thread that called Decode); channels are never used by worker threads
+class MELIBUMultiBusDecoder
+{
+ public:
+    MELIBUMultiBusDecoder( MELIBUDecoderListener* listener, MELIBUWorkerPool* pool );
+    ~MELIBUMultiBusDecoder();
+
+    // bus index of decoded records is position of channel in channels
+    void Setup( const MELIBUDecoderSettings& settings, const std::vector < MELIBUChannel* >& channels, U64 window_samples );
+    void Decode(); // until all channels end
+
+ protected:
+    struct Bus
+    {
+        MELIBUChannel* mChannel;
+        std::vector < U64 > mEdges; // read from channel after mResume
+        bool mInitialHigh;          // bit state at mResume
+        U64 mReadUntil;             // sample number of channel
+        U64 mDecodeUntil;           // line is known up to this sample in next decoding
+        U64 mResume;                // decoding continues here; next byte can't start before
+        U64 mDecoded;               // decoding stopped here for lack of edges
+        std::unique_ptr < MELIBUOutputBuffer > mOutput;
+        std::unique_ptr < MELIBUDecoder > mDecoder;
+        bool mStarted;
+        bool mReading; // false after channel ended or threw
+        bool mDone;    // channel stopped and all its edges are decoded
+        std::exception_ptr mException; // thrown by channel; other buses are decoded to their end before it is rethrown
+    };
+
+    void Read( U64 window_end );                       // read edges of all buses up to window_end
+    void ReadBus( Bus& bus, U64 window_end, bool wait ); // without wait, only edges captured so far are read
+    bool AllIdle();                                      // no bus has more captured edges; next read waits for data
+    S64 DecodeBuffers( bool parallel );                  // decode read edges and pass output; returns sample all buses are decoded to
+    void DecodeBus( Bus& bus );                          // decode edges of bus up to mDecodeUntil
+    void PassUnits( S64 sample_number );                 // pass on output of bytes that start before sample_number
+
+ protected: //vars
+    MELIBUDecoderListener* mListener;
+    MELIBUWorkerPool* mPool;
+    std::vector < Bus > mBuses;
+    U64 mWindowSamples;
+    U64 mByteSamples; // first step on idle line when reading past last captured edge
+};
+
+#endif //MELIBU_MULTI_BUS_DECODER_H
@@ -0,0 +1,128 @@
+#include "MELIBUOutputBuffer.h"
+
+MELIBUOutputBuffer::MELIBUOutputBuffer() : mUnitCount( 0 ) {
+    this->mOpen.mStartingSample = 0;
+    this->mOpen.mEvents = 0;
+}
+
+MELIBUOutputBuffer::~MELIBUOutputBuffer() {}
+
+void MELIBUOutputBuffer::AddEvent( const Event& event ) {
+    if( this->mOpen.mEvents == 0 )
+        this->mOpen.mStartingSample = event.mStartingSample;
+    this->mOpen.mEvents++;
+    this->mEvents.push_back( event );
+}
+
+void MELIBUOutputBuffer::OnMarker( U64 sample_number, U8 marker ) {
+    Event event;
+    event.mType = eventMarker;
+    event.mMarker = marker;
+    event.mStartingSample = sample_number;
+    event.mEndingSample = sample_number;
+    AddEvent( event );
+}
+
+void MELIBUOutputBuffer::OnByte( const MELIBUByteRecord& byte ) {
+    Event event;
+    event.mType = eventByte;
+    event.mStartingSample = byte.mStartingSampleInclusive;
+    event.mEndingSample = byte.mEndingSampleInclusive;
+    this->mBytes.push_back( byte );
+    AddEvent( event );
+    this->mOpen.mStartingSample = byte.mStartingSampleInclusive; // units are ordered by their byte
+}
+
+void MELIBUOutputBuffer::OnMissingByte( S64 starting_sample, S64 ending_sample ) {
+    Event event;
+    event.mType = eventMissingByte;
+    event.mStartingSample = starting_sample;
+    event.mEndingSample = ending_sample;
+    AddEvent( event );
+}
+
+void MELIBUOutputBuffer::OnPacket( const MELIBUPacketRecord& packet ) {
+    Event event;
+    event.mType = eventPacket;
+    event.mStartingSample = packet.mStartingSampleInclusive;
+    event.mEndingSample = packet.mEndingSampleInclusive;
+    this->mPackets.push_back( packet );
+    AddEvent( event );
+}
+
+void MELIBUOutputBuffer::OnProgress( S64 sample_number ) {
+    Event event;
+    event.mType = eventProgress;
+    event.mStartingSample = sample_number;
+    event.mEndingSample = sample_number;
+    AddEvent( event );
+    Close();
+}
+
+void MELIBUOutputBuffer::Close() {
+    if( this->mOpen.mEvents == 0 )
+        return;
+    this->mUnits.push_back( this->mOpen );
+    this->mOpen.mEvents = 0;
+    this->mUnitCount++;
+}
+
+void MELIBUOutputBuffer::DropOpen() {
+    for( ; this->mOpen.mEvents != 0; this->mOpen.mEvents-- ) {
+        if( this->mEvents.back().mType == eventByte )
+            this->mBytes.pop_back();
+        if( this->mEvents.back().mType == eventPacket )
+            this->mPackets.pop_back();
+        this->mEvents.pop_back();
+    }
+}
+
+bool MELIBUOutputBuffer::HasUnit() const {
+    return !this->mUnits.empty();
+}
+
+S64 MELIBUOutputBuffer::UnitStart() const {
+    return this->mUnits.front().mStartingSample;
+}
+
+void MELIBUOutputBuffer::PassUnit( MELIBUDecoderListener* listener ) {
+    for( size_t i = 0; i < this->mUnits.front().mEvents; i++ ) {
+        const Event& event = this->mEvents.front();
+        switch( event.mType ) {
+            case eventMarker:
+                listener->OnMarker( event.mStartingSample, event.mMarker );
+                break;
+            case eventByte:
+                listener->OnByte( this->mBytes.front() );
+                this->mBytes.pop_front();
+                break;
+            case eventMissingByte:
+                listener->OnMissingByte( event.mStartingSample, event.mEndingSample );
+                break;
+            case eventPacket:
+                listener->OnPacket( this->mPackets.front() );
+                this->mPackets.pop_front();
+                break;
+            case eventProgress:
+                listener->OnProgress( event.mStartingSample );
+                break;
+        }
+        this->mEvents.pop_front();
+    }
+    this->mUnits.pop_front();
+}
+
+void MELIBUOutputBuffer::DropUnit() {
+    for( size_t i = 0; i < this->mUnits.front().mEvents; i++ ) {
+        if( this->mEvents.front().mType == eventByte )
+            this->mBytes.pop_front();
+        if( this->mEvents.front().mType == eventPacket )
+            this->mPackets.pop_front();
+        this->mEvents.pop_front();
+    }
+    this->mUnits.pop_front();
+}
+
+U64 MELIBUOutputBuffer::Units() const {
+    return this->mUnitCount;
+}
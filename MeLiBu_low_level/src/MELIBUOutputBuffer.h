@@ -0,0 +1,63 @@
+#ifndef MELIBU_OUTPUT_BUFFER_H
+#define MELIBU_OUTPUT_BUFFER_H
+
+#include "MELIBUDecoder.h"
+#include <deque>
+
+// decoder output kept until it can be passed on, e.g. in sample order with output of other decoders
+class MELIBUOutputBuffer: public MELIBUDecoderListener
+{
+ public:
+    MELIBUOutputBuffer();
+    virtual ~MELIBUOutputBuffer();
+
+    virtual void OnMarker( U64 sample_number, U8 marker );
+    virtual void OnByte( const MELIBUByteRecord& byte );
+    virtual void OnMissingByte( S64 starting_sample, S64 ending_sample );
+    virtual void OnPacket( const MELIBUPacketRecord& packet );
+    virtual void OnProgress( S64 sample_number );
+
+    // output of one DecodeFrame call (byte with its markers and packets) is one unit; it ends with OnProgress
+    void Close();               // end of data; keep output of unfinished unit as it is
+    void DropOpen();            // forget output of unfinished unit; its DecodeFrame call is repeated
+    bool HasUnit() const;       // at least one finished unit
+    S64 UnitStart() const;      // starting sample of byte of oldest finished unit
+    void PassUnit( MELIBUDecoderListener* listener ); // forward oldest finished unit and forget it
+    void DropUnit();            // forget oldest finished unit
+    U64 Units() const;          // number of units finished so far, including passed and dropped ones
+
+ protected:
+    typedef enum {
+        eventMarker,
+        eventByte,
+        eventMissingByte,
+        eventPacket,
+        eventProgress
+    } tMELIBUOutputEvent;
+
+    struct Event
+    {
+        U8 mType; // tMELIBUOutputEvent
+        U8 mMarker;
+        S64 mStartingSample; // marker sample for markers
+        S64 mEndingSample;
+    };
+
+    struct Unit
+    {
+        S64 mStartingSample;
+        size_t mEvents;
+    };
+
+    void AddEvent( const Event& event );
+
+ protected: //vars
+    std::deque < Event > mEvents;
+    std::deque < MELIBUByteRecord > mBytes; // records of byte and packet events, kept apart to keep events small
+    std::deque < MELIBUPacketRecord > mPackets;
+    std::deque < Unit > mUnits; // finished units; events of open unit follow them in mEvents
+    Unit mOpen;
+    U64 mUnitCount;
+};
+
+#endif //MELIBU_OUTPUT_BUFFER_H
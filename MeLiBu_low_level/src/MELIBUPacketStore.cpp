@@ -0,0 +1,65 @@
+#include "MELIBUPacketStore.h"
+#include <algorithm>
+#include <cstring>
+
+MELIBUPacketStore::MELIBUPacketStore() {}
+
+MELIBUPacketStore::~MELIBUPacketStore() {}
+
+void MELIBUPacketStore::Add( const MELIBUPacketRecord& packet, U64 packet_id ) {
+    MELIBUPacketSummary summary;
+    summary.mPacketId = packet_id;
+    summary.mStartingSampleInclusive = packet.mStartingSampleInclusive;
+    summary.mEndingSampleInclusive = packet.mEndingSampleInclusive;
+    summary.mDataLength = packet.mDataLength;
+    summary.mID1 = packet.mID1;
+    summary.mID2 = packet.mID2;
+    summary.mFlags = packet.mFlags;
+    summary.mInstruction = packet.mInstruction;
+    summary.mReceivedCrc = packet.mReceivedCrc;
+    summary.mCalculatedCrc = packet.mCalculatedCrc;
+    summary.mAck = packet.mAck;
+    summary.mFields = ( packet.mHasInstruction ? MELIBUPacketSummary::hasInstruction : 0 ) |
+                      ( packet.mHasAck ? MELIBUPacketSummary::hasAck : 0 ) |
+                      ( packet.mComplete ? MELIBUPacketSummary::complete : 0 );
+    summary.mBus = packet.mBus;
+
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    summary.mPayloadOffset = this->mPayload.size();
+    this->mPayload.insert( this->mPayload.end(), packet.mData, packet.mData + packet.mDataLength );
+    this->mSummaries.push_back( summary );
+}
+
+U64 MELIBUPacketStore::Count() {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    return this->mSummaries.size();
+}
+
+bool MELIBUPacketStore::Find( U64 packet_id, MELIBUPacketSummary& summary, U8* data ) {
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    auto it = std::lower_bound( this->mSummaries.begin(), this->mSummaries.end(), packet_id,
+                                []( const MELIBUPacketSummary& s, U64 id ) { return s.mPacketId < id; } );
+    if( it == this->mSummaries.end() || it->mPacketId != packet_id )
+        return false;
+    summary = *it;
+    if( summary.mDataLength != 0 )
+        memcpy( data, &this->mPayload[ summary.mPayloadOffset ], summary.mDataLength );
+    return true;
+}
+
+void MELIBUPacketStore::Copy( U64 first, U64 count, std::vector < MELIBUPacketSummary >& summaries, std::vector < U8 >& payload ) {
+    summaries.clear();
+    payload.clear();
+
+    std::lock_guard < std::mutex > lock( this->mMutex );
+    if( first >= this->mSummaries.size() )
+        return;
+    count = std::min < U64 >( count, this->mSummaries.size() - first );
+    summaries.assign( this->mSummaries.begin() + first, this->mSummaries.begin() + first + count );
+
+    U64 payload_start = summaries.front().mPayloadOffset;
+    U64 payload_end = summaries.back().mPayloadOffset + summaries.back().mDataLength;
+    payload.assign( this->mPayload.begin() + payload_start, this->mPayload.begin() + payload_end );
+    for( auto& summary : summaries )
+        summary.mPayloadOffset -= payload_start;
+}
@@ -0,0 +1,56 @@
+#ifndef MELIBU_PACKET_STORE_H
+#define MELIBU_PACKET_STORE_H
+
+#include "MELIBUTypes.h"
+#include "MELIBUDecoder.h"
+#include <vector>
+#include <mutex>
+
+// compact message record; payload bytes are kept in byte pool of MELIBUPacketStore
+struct MELIBUPacketSummary
+{
+    typedef enum {
+        hasInstruction = 0x01,
+        hasAck = 0x02,
+        complete = 0x04 // message was not interrupted; crc fields are valid
+    } tMELIBUPacketFields;
+
+    U64 mPacketId; // packet id in analyzer results; INVALID_RESULT_INDEX with several buses
+    S64 mStartingSampleInclusive;
+    S64 mEndingSampleInclusive;
+    U64 mPayloadOffset; // first data byte in payload pool
+    U8 mDataLength;
+    U8 mID1;
+    U8 mID2;
+    U8 mFlags;  // MELIBUDecoder::tMELIBUFrameFlags of all bytes
+    U16 mInstruction;
+    U16 mReceivedCrc;
+    U16 mCalculatedCrc;
+    U8 mAck;
+    U8 mFields; // tMELIBUPacketFields
+    U8 mBus;
+};
+
+// messages decoded so far; filled by analyzer thread and read by export and tabular view at the same time
+class MELIBUPacketStore
+{
+ public:
+    MELIBUPacketStore();
+    ~MELIBUPacketStore();
+
+    void Add( const MELIBUPacketRecord& packet, U64 packet_id );
+    U64 Count();
+
+    // find message by packet id; payload is copied to data
+    bool Find( U64 packet_id, MELIBUPacketSummary& summary, U8* data );
+
+    // copy messages [first, first + count); payload offsets in copied summaries point to payload vector
+    void Copy( U64 first, U64 count, std::vector < MELIBUPacketSummary >& summaries, std::vector < U8 >& payload );
+
+ protected: //vars
+    std::mutex mMutex;
+    std::vector < MELIBUPacketSummary > mSummaries; // sorted by packet id
+    std::vector < U8 > mPayload;
+};
+
+#endif //MELIBU_PACKET_STORE_H
@@ -0,0 +1,127 @@
+#ifndef MELIBU_PROTOCOL_H
+#define MELIBU_PROTOCOL_H
+
+#include "MELIBUTypes.h"
+
+// protocol traits; MELIBUDecoder is instantiated once per traits type so that version checks are resolved at compile time
+// adding new protocol revision: define new traits type and add it to MELIBUProtocol::tVersion and MELIBUProtocol::FromVersion
+
+// MeLiBu 1, normal mode
+struct MELIBUProtocol1
+{
+    static const bool LsbFirst = false;          // bit order of data bits
+    static const U32 BreakBits = 13;             // minimum number of low bits in break field
+    static const U32 BreakCheckBits = 3;         // low bits after stop bit needed to recognize break field instead of byte
+    static const bool CrcMsbFirst = true;        // first crc byte is msb
+    static const bool ConfigurableAck = false;   // ack value is always 0x7E
+
+    static bool HasInstruction( U8 /*idField1*/, U8 /*idField2*/ ) {
+        return false;
+    }
+
+    static U8 NumberOfDataBytes( U8 idField1, U8 idField2 ) {
+        U8 length = idField2 & 0x1c;         // 0x1c = 0001 1100
+        if( ( idField1 & 0x01 ) != 0 )       // function select bit
+            length = idField2 & 0xfc;        // 0xfc = 1111 1100
+        return BitCount( length ) * 6;
+    }
+
+    static bool MasterToSlave( U8 idField1, U8 /*idField2*/ ) {
+        return ( idField1 & 0x02 ) == 0;
+    }
+
+    static bool AckExpected( U8 idField1, U8 idField2 ) {
+        // ack is sent only when sent message is master to slave
+        return MasterToSlave( idField1, idField2 ) && ( ( ( idField1 & 0xFC ) >> 2 ) >= 3 );
+    }
+
+    static U8 BitCount( U8 value ) {
+        U8 count = 0;
+        for( ; value != 0; value &= value - 1 )
+            count++;
+        return count;
+    }
+};
+
+// MeLiBu 1, extended mode; differs only in length encoding when function select bit is set
+struct MELIBUProtocol1Extended: public MELIBUProtocol1
+{
+    static U8 NumberOfDataBytes( U8 idField1, U8 idField2 ) {
+        if( ( idField1 & 0x01 ) == 0 )
+            return MELIBUProtocol1::NumberOfDataBytes( idField1, idField2 );
+        return ( ( ( idField2 & 0xfc ) >> 2 ) + 1 ) * 2;
+    }
+};
+
+// MeLiBu 2
+struct MELIBUProtocol2
+{
+    static const bool LsbFirst = true;
+    static const U32 BreakBits = 11;
+    static const U32 BreakCheckBits = 1;
+    static const bool CrcMsbFirst = false; // second crc byte is msb
+    static const bool ConfigurableAck = true;
+
+    static bool HasInstruction( U8 /*idField1*/, U8 idField2 ) {
+        return ( idField2 & 0x04 ) != 0;
+    }
+
+    static U8 NumberOfDataBytes( U8 /*idField1*/, U8 idField2 ) {
+        U8 length = ( idField2 & 0x38 ) >> 3; // 0x38 = 0011 1000; 3bit length value
+        if( ( idField2 & 0x02 ) == 0 ) {      // function select bit
+            switch( length ) {
+                case 6:
+                    return 18;
+                case 7:
+                    return 24;
+                default: // 0,1,2,3,4,5 cases
+                    return length * 2;
+            }
+        } else {
+            switch( length ) {
+                case 0:
+                    return 6;
+                case 6:
+                    return 84;
+                case 7:
+                    return 128;
+                default: // 1,2,3,4,5 cases
+                    return length * 12;
+            }
+        }
+    }
+
+    static bool MasterToSlave( U8 /*idField1*/, U8 idField2 ) {
+        return ( idField2 & 0x01 ) == 0;
+    }
+
+    static bool AckExpected( U8 idField1, U8 idField2 ) {
+        // ack is sent only when sent message is master to slave
+        return MasterToSlave( idField1, idField2 ) && ( idField1 >= 3 );
+    }
+};
+
+namespace MELIBUProtocol
+{
+    typedef enum {
+        MeLiBu1,
+        MeLiBu1Extended,
+        MeLiBu2
+    } tVersion;
+
+    // map version from settings (1.0, 1.1 or 2.0) to protocol
+    inline tVersion FromVersion( double version ) {
+        if( version >= 2.0 )
+            return MeLiBu2;
+        if( version == 1.0 )
+            return MeLiBu1;
+        return MeLiBu1Extended;
+    }
+
+    // crc byte order for code that is not instantiated per protocol traits
+    inline bool CrcMsbFirst( tVersion version ) {
+        return version == MeLiBu2 ? MELIBUProtocol2::CrcMsbFirst : MELIBUProtocol1::CrcMsbFirst;
+    }
+}
+
+#endif //MELIBU_PROTOCOL_H
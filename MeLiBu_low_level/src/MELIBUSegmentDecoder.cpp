@@ -0,0 +1,200 @@
+#include "MELIBUSegmentDecoder.h"
+#include "MELIBUBufferedChannel.h"
+#include "MELIBUProtocol.h"
+#include <algorithm>
+#include <limits>
+
+MELIBUSegmentDecoder::MELIBUSegmentDecoder( MELIBUDecoderListener* listener, MELIBUWorkerPool* pool )
+    :   mListener( listener ),
+    mPool( pool ),
+    mInitialHigh( true ),
+    mStartSample( 0 ),
+    mDecodedSegments( 0 ),
+    mSegmentCount( 0 ) {}
+
+MELIBUSegmentDecoder::~MELIBUSegmentDecoder() {}
+
+void MELIBUSegmentDecoder::Setup( const MELIBUDecoderSettings& settings ) {
+    this->mSettings = settings;
+}
+
+bool MELIBUSegmentDecoder::Record( MELIBUChannel* channel, size_t max_edges ) {
+    while( this->mEdges.size() < max_edges && channel->MoreEdgesAvailable() ) {
+        channel->AdvanceToNextEdge();
+        this->mEdges.push_back( channel->GetSampleNumber() );
+    }
+    return !channel->MoreEdgesAvailable();
+}
+
+void MELIBUSegmentDecoder::Trim( U64 sample_number ) {
+    auto passed = std::upper_bound( this->mEdges.begin(), this->mEdges.end(), sample_number );
+    if( ( passed - this->mEdges.begin() ) & 1 )
+        this->mInitialHigh = !this->mInitialHigh;
+    this->mEdges.erase( this->mEdges.begin(), passed );
+    this->mStartSample = sample_number;
+}
+
+U32 MELIBUSegmentDecoder::Segments() const {
+    return this->mSegmentCount;
+}
+
+void MELIBUSegmentDecoder::FindCuts( std::vector < U64 >& cuts ) {
+    // low run must be at least half a bit longer than break field, so every decoder reads it as break field
+    U32 break_bits = MELIBUProtocol::FromVersion( this->mSettings.mMELIBUVersion ) == MELIBUProtocol::MeLiBu2 ?
+                     MELIBUProtocol2::BreakBits : MELIBUProtocol1::BreakBits;
+    U64 min_low = ( ( U64 )( 2 * break_bits + 1 ) * this->mSettings.mSampleRateHz ) / ( 2 * ( U64 )this->mSettings.mBitRate );
+
+    // run after edge i is low if initial state was high and i is even
+    // part after last cut is decoded after the parallel ones or in next round, so it gets SegmentEdges edges too
+    size_t i = SegmentEdges;
+    while( i + SegmentEdges < this->mEdges.size() ) {
+        bool falling = ( ( i & 1 ) == 0 ) == this->mInitialHigh;
+        if( falling && this->mEdges[ i + 1 ] - this->mEdges[ i ] >= min_low ) {
+            cuts.push_back( this->mEdges[ i ] );
+            i += SegmentEdges;
+        } else
+            i++;
+    }
+}
+
+void MELIBUSegmentDecoder::DecodeSegment( Segment& segment ) {
+    segment.mChannel.reset( new MELIBUEdgeChannel( this->mEdges.data(), this->mEdges.size(), this->mInitialHigh,
+                                                   segment.mStart, this->mEdges.back() ) );
+    segment.mOutput.reset( new MELIBUOutputBuffer() );
+    if( segment.mDecoder )
+        segment.mDecoder->Attach( segment.mChannel.get(), segment.mOutput.get() ); // continues from previous round
+    else {
+        segment.mDecoder.reset( new MELIBUDecoder( segment.mChannel.get(), segment.mOutput.get() ) );
+        segment.mDecoder->Setup( this->mSettings );
+        segment.mDecoder->Start(); // line is high before break field
+    }
+
+    for( ;; ) {
+        segment.mResume = segment.mChannel->GetSampleNumber();
+        if( segment.mDecoder->AtMessageBoundary() ) {
+            Boundary boundary = { segment.mResume, segment.mOutput->Units() };
+            segment.mBoundaries.push_back( boundary );
+            if( boundary.mSample >= segment.mLimit )
+                return;
+        }
+        if( !segment.mDecoder->DecodeFrame() ) {
+            segment.mEnded = true;
+            return;
+        }
+    }
+}
+
+void MELIBUSegmentDecoder::DecodeBatch( size_t first ) {
+    // segments are decoded in batches, so output kept in memory does not grow with capture length
+    size_t last = std::min( this->mSegments.size(), first + this->mPool->NumThreads() * BatchSegmentsPerThread );
+    std::vector < MELIBUWorkerPool::tJob > jobs;
+    for( size_t i = first; i < last; i++ ) {
+        Segment* segment = &this->mSegments[ i ];
+        jobs.push_back( [ this, segment ]() { DecodeSegment( *segment ); } );
+    }
+    this->mPool->Run( jobs );
+    this->mDecodedSegments = last;
+}
+
+bool MELIBUSegmentDecoder::Step( Segment& segment ) {
+    do {
+        segment.mResume = segment.mChannel->GetSampleNumber();
+        if( !segment.mDecoder->DecodeFrame() ) {
+            segment.mEnded = true;
+            return false;
+        }
+    } while( !segment.mDecoder->AtMessageBoundary() );
+    return true;
+}
+
+void MELIBUSegmentDecoder::Pass( Segment& segment ) {
+    while( segment.mOutput->HasUnit() )
+        segment.mOutput->PassUnit( this->mListener );
+}
+
+void MELIBUSegmentDecoder::Decode( MELIBUChannel* channel ) {
+    this->mEdges.clear();
+    this->mStartSample = channel->GetSampleNumber();
+    this->mInitialHigh = channel->IsHigh();
+    this->mSegmentCount = 0;
+    size_t round_edges = ( size_t )this->mPool->NumThreads() * BatchSegmentsPerThread * SegmentEdges; // one batch per round
+
+    // decoder of last segment of a round continues in next round at resume
+    std::unique_ptr < MELIBUDecoder > tail;
+    U64 resume = this->mStartSample;
+    for( ;; ) {
+        // segment i ends at cut i; in last round part after last cut is decoded on channel,
+        // in other rounds it is one more segment that is decoded up to end of recorded edges
+        bool last_round = Record( channel, round_edges );
+        std::vector < U64 > cuts;
+        FindCuts( cuts );
+        this->mSegments.clear();
+        this->mSegments.resize( cuts.size() + ( last_round ? 0 : 1 ) );
+        for( size_t i = 0; i < this->mSegments.size(); i++ ) {
+            this->mSegments[ i ].mStart = ( i == 0 ) ? this->mStartSample : cuts[ i - 1 ] - 1;
+            this->mSegments[ i ].mLimit = i < cuts.size() ? cuts[ i ] - 1 : std::numeric_limits < U64 >::max();
+            this->mSegments[ i ].mResume = this->mSegments[ i ].mStart;
+            this->mSegments[ i ].mEnded = false;
+        }
+        if( this->mSegments.empty() )
+            break;
+        this->mSegments[ 0 ].mDecoder = std::move( tail );
+        this->mSegmentCount += ( U32 )this->mSegments.size();
+        this->mDecodedSegments = 0;
+
+        DecodeBatch( 0 );
+        size_t current = 0; // segment whose output is passed on next
+        for( size_t next = 1; next < this->mSegments.size() && !this->mSegments[ current ].mEnded; next++ ) {
+            if( next >= this->mDecodedSegments )
+                DecodeBatch( next );
+            Segment& segment = this->mSegments[ current ];
+            Segment& following = this->mSegments[ next ];
+            for( ;; ) {
+                // following segment takes over at first message boundary both decoders share
+                U64 sample = segment.mChannel->GetSampleNumber();
+                auto boundary = std::lower_bound( following.mBoundaries.begin(), following.mBoundaries.end(), sample,
+                                                  []( const Boundary& b, U64 s ) { return b.mSample < s; } );
+                if( boundary == following.mBoundaries.end() ) {
+                    following = Segment(); // current decoder passed whole segment; its output is not needed
+                    break;
+                }
+                if( boundary->mSample == sample ) {
+                    for( U64 unit = 0; unit < boundary->mUnits; unit++ )
+                        following.mOutput->DropUnit();
+                    Pass( segment );
+                    segment = Segment();
+                    current = next;
+                    break;
+                }
+                if( !Step( segment ) )
+                    break;
+            }
+        }
+
+        // if recorded edges ended inside byte, it is read again
+        Segment& segment = this->mSegments[ current ];
+        Pass( segment );
+        U64 position = segment.mEnded ? segment.mResume : segment.mChannel->GetSampleNumber();
+        tail = std::move( segment.mDecoder );
+        this->mSegments.clear();
+        // a byte that needs more than a round of edges (e.g. long noise) is decoded on channel
+        bool stuck = position == resume;
+        resume = position;
+        if( last_round || stuck )
+            break;
+        Trim( resume );
+    }
+
+    // decoder of last segment continues on channel
+    MELIBUBufferedChannel tail_channel( channel, this->mEdges, this->mInitialHigh, this->mStartSample );
+    if( tail ) {
+        tail_channel.AdvanceToAbsPosition( resume );
+        tail->Attach( &tail_channel, this->mListener );
+    } else {
+        tail.reset( new MELIBUDecoder( &tail_channel, this->mListener ) );
+        tail->Setup( this->mSettings );
+        tail->Start();
+    }
+    while( tail->DecodeFrame() ) {
+    }
+}
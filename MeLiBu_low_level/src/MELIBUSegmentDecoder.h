@@ -0,0 +1,74 @@
+#ifndef MELIBU_SEGMENT_DECODER_H
+#define MELIBU_SEGMENT_DECODER_H
+
+#include "MELIBUDecoder.h"
+#include "MELIBUEdgeChannel.h"
+#include "MELIBUOutputBuffer.h"
+#include "MELIBUWorkerPool.h"
+#include <memory>
+#include <vector>
+
+// decodes recorded capture in parallel: capture is cut into segments at break fields, segments are decoded
+// independently on a worker pool, and their output is passed to listener in sample order (from thread that called Decode)
+// decoder of a segment continues past end of segment to next message boundary; next segment's output is used from
+// first message boundary both decoders share, so output is the same as of one MELIBUDecoder over whole capture
+// edges are read and decoded in rounds of a few segments per thread, so memory does not grow with capture length
+class MELIBUSegmentDecoder
+{
+ public:
+    typedef enum {
+        decodeSequential = 0, // one decoder; results are shown while capture is running
+        decodeSegments = 1    // recorded capture is decoded in parallel segments before results are shown
+    } tMELIBUDecodeMode;
+
+    MELIBUSegmentDecoder( MELIBUDecoderListener* listener, MELIBUWorkerPool* pool );
+    ~MELIBUSegmentDecoder();
+
+    void Setup( const MELIBUDecoderSettings& settings );
+    void Decode( MELIBUChannel* channel ); // decode edges available now in parallel, then continue on channel
+
+    U32 Segments() const; // number of segments decoded in parallel by last Decode
+
+ protected:
+    enum { SegmentEdges = 32768, BatchSegmentsPerThread = 2 };
+
+    // message boundary passed by segment decoder
+    struct Boundary
+    {
+        U64 mSample;
+        U64 mUnits; // units of output before boundary
+    };
+
+    struct Segment
+    {
+        U64 mStart; // first sample; break field follows (or start of capture)
+        U64 mLimit; // decoding stops at first message boundary at or after this sample
+        std::unique_ptr < MELIBUEdgeChannel > mChannel;
+        std::unique_ptr < MELIBUOutputBuffer > mOutput;
+        std::unique_ptr < MELIBUDecoder > mDecoder;
+        std::vector < Boundary > mBoundaries;
+        U64 mResume; // sample where last DecodeFrame call started
+        bool mEnded; // recorded edges ended in last DecodeFrame call; its output is incomplete
+    };
+
+    bool Record( MELIBUChannel* channel, size_t max_edges ); // add edges up to max_edges in buffer; false if more are available
+    void Trim( U64 sample_number );             // forget edges up to sample_number; buffer starts there
+    void FindCuts( std::vector < U64 >& cuts ); // falling edges of break fields, at least SegmentEdges edges apart
+    void DecodeSegment( Segment& segment );     // until limit; segment that has a decoder continues with it
+    void DecodeBatch( size_t first );           // decode next batch of segments starting with first
+    bool Step( Segment& segment );              // decode to next message boundary; false if recorded edges ended
+    void Pass( Segment& segment );              // pass on finished output of segment
+
+ protected: //vars
+    MELIBUDecoderListener* mListener;
+    MELIBUWorkerPool* mPool;
+    MELIBUDecoderSettings mSettings;
+    std::vector < U64 > mEdges; // edges of current round after mStartSample
+    bool mInitialHigh;          // bit state at mStartSample
+    U64 mStartSample;
+    std::vector < Segment > mSegments;
+    size_t mDecodedSegments;
+    U32 mSegmentCount;
+};
+
+#endif //MELIBU_SEGMENT_DECODER_H
@@ -0,0 +1,465 @@
+#include "MELIBUSignalLayout.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    bool ParseNumber( const std::string& text, U32& value ) {
+        char* end;
+        unsigned long number = strtoul( text.c_str(), &end, 0 );
+        if( text.empty() || *end != '\0' )
+            return false;
+        value = ( U32 )number;
+        return true;
+    }
+
+    bool ParseDouble( const std::string& text, double& value ) {
+        char* end;
+        value = strtod( text.c_str(), &end );
+        return !text.empty() && *end == '\0';
+    }
+
+    const char kBinaryMagic[ 8 ] = { 'M', 'L', 'B', 'L', 'A', 'Y', 'T', '\0' };
+
+    static_assert( sizeof( MELIBUSignalLayoutFrame ) == 16 && sizeof( MELIBUSignalLayoutSignal ) == 16 &&
+                   sizeof( MELIBUSignalLayoutChunk ) == 4 && sizeof( MELIBUSignalLayoutEncodingType ) == 12 &&
+                   sizeof( MELIBUSignalLayoutEncoding ) == 32 && sizeof( MELIBUSignalLayoutSlot ) == 12 &&
+                   sizeof( MELIBUSignalLayoutHeader ) == 104,
+                   "binary layout records changed" );
+
+    // rest of line after current position without leading space; texts and units may contain spaces
+    std::string Rest( std::istringstream& line ) {
+        std::string rest;
+        std::getline( line >> std::ws, rest );
+        return rest;
+    }
+}
+
+MELIBUSignalLayout::MELIBUSignalLayout()
+    :   mVersion( 0.0 ),
+    mMask1( 0xFF ),
+    mMask2( 0xFF ) {}
+
+MELIBUSignalLayout::~MELIBUSignalLayout() {}
+
+// line based format:
+//   melibu_signal_layout 1
+//   protocol <version>
+//   header_mask <id1 mask> <id2 mask>
+//   slave <nad>
+//   encoding_type <name>                  followed by its encodings:
+//   logical <value> <text>
+//   physical <min> <max> <scale> <offset> <unit>
+//   frame <name> <id1> <id2> <instruction or ->   followed by its signals:
+//   signal <name> <encoding type or -> <offset>:<size> ...   chunks from most to least significant
+bool MELIBUSignalLayout::Load( const char* path, std::string& error ) {
+    char magic[ sizeof( kBinaryMagic ) ] = {};
+    std::ifstream file( path, std::ios::binary );
+    if( !file ) {
+        error = std::string( "Can't open signal layout " ) + path;
+        return false;
+    }
+    file.read( magic, sizeof( magic ) );
+    file.close();
+    if( memcmp( magic, kBinaryMagic, sizeof( magic ) ) == 0 )
+        return LoadBinary( path, error );
+    return LoadText( path, error );
+}
+
+bool MELIBUSignalLayout::LoadText( const char* path, std::string& error ) {
+    std::ifstream file( path );
+    if( !file ) {
+        error = std::string( "Can't open signal layout " ) + path;
+        return false;
+    }
+
+    std::unordered_map < std::string, S32 > encoding_types;
+    std::string text;
+    U32 line_number = 0;
+    bool header = false;
+    while( std::getline( file, text ) ) {
+        line_number++;
+        std::istringstream line( text );
+        std::string keyword;
+        if( !( line >> keyword ) || keyword[ 0 ] == '#' )
+            continue;
+
+        bool valid = true;
+        if( keyword == "melibu_signal_layout" ) {
+            U32 format;
+            std::string value;
+            valid = ( line >> value ) && ParseNumber( value, format ) && format == 1;
+            header = valid;
+        } else if( !header ) {
+            valid = false;
+        } else if( keyword == "protocol" ) {
+            std::string value;
+            valid = ( line >> value ) && ParseDouble( value, this->mVersion );
+        } else if( keyword == "header_mask" ) {
+            std::string mask1, mask2;
+            U32 value1 = 0xFF, value2 = 0xFF;
+            valid = ( line >> mask1 >> mask2 ) && ParseNumber( mask1, value1 ) && ParseNumber( mask2, value2 );
+            this->mMask1 = ( U8 )value1;
+            this->mMask2 = ( U8 )value2;
+        } else if( keyword == "slave" ) {
+            std::string value;
+            U32 nad = 0;
+            valid = ( line >> value ) && ParseNumber( value, nad );
+            this->mSlaveStore.push_back( ( U8 )nad );
+        } else if( keyword == "encoding_type" ) {
+            std::string name;
+            valid = ( line >> name ) && !name.empty();
+            MELIBUSignalLayoutEncodingType type;
+            type.mName = AddName( name );
+            type.mFirstEncoding = ( U32 )this->mEncodingStore.size();
+            type.mNumEncodings = 0;
+            encoding_types[ name ] = ( S32 )this->mEncodingTypeStore.size();
+            this->mEncodingTypeStore.push_back( type );
+        } else if( keyword == "logical" || keyword == "physical" ) {
+            MELIBUSignalLayoutEncoding encoding = MELIBUSignalLayoutEncoding();
+            std::string min, max, scale, offset;
+            if( keyword == "logical" ) {
+                encoding.mType = MELIBUSignalLayoutEncoding::encodingLogical;
+                valid = ( line >> min ) && ParseNumber( min, encoding.mMin );
+                encoding.mMax = encoding.mMin;
+                encoding.mScale = 1.0;
+                encoding.mOffset = 0.0;
+            } else {
+                encoding.mType = MELIBUSignalLayoutEncoding::encodingPhysical;
+                valid = ( line >> min >> max >> scale >> offset ) && ParseNumber( min, encoding.mMin ) &&
+                        ParseNumber( max, encoding.mMax ) && ParseDouble( scale, encoding.mScale ) &&
+                        ParseDouble( offset, encoding.mOffset );
+            }
+            encoding.mText = AddName( Rest( line ) );
+            valid = valid && !this->mEncodingTypeStore.empty();
+            if( valid ) {
+                this->mEncodingStore.push_back( encoding );
+                this->mEncodingTypeStore.back().mNumEncodings++;
+            }
+        } else if( keyword == "frame" ) {
+            std::string name, id1, id2, instruction;
+            U32 value1 = 0, value2 = 0, instruction_value = 0;
+            valid = ( line >> name >> id1 >> id2 >> instruction ) && ParseNumber( id1, value1 ) && ParseNumber( id2, value2 ) &&
+                    ( instruction == "-" || ParseNumber( instruction, instruction_value ) );
+            MELIBUSignalLayoutFrame frame;
+            frame.mName = AddName( name );
+            frame.mID1 = ( U8 )value1 & this->mMask1;
+            frame.mID2 = ( U8 )value2 & this->mMask2;
+            frame.mInstruction = ( U16 )instruction_value;
+            frame.mFirstSignal = ( U32 )this->mSignalStore.size();
+            frame.mNumSignals = 0;
+            this->mFrameStore.push_back( frame );
+        } else if( keyword == "signal" ) {
+            std::string name, encoding_type, chunk;
+            valid = ( line >> name >> encoding_type ) && !this->mFrameStore.empty();
+            MELIBUSignalLayoutSignal signal;
+            signal.mName = AddName( name );
+            signal.mFirstChunk = ( U32 )this->mChunkStore.size();
+            signal.mNumChunks = 0;
+            signal.mEncodingType = -1;
+            if( encoding_type != "-" ) {
+                auto type = encoding_types.find( encoding_type );
+                valid = valid && type != encoding_types.end();
+                if( type != encoding_types.end() )
+                    signal.mEncodingType = type->second;
+            }
+            while( valid && ( line >> chunk ) ) {
+                size_t colon = chunk.find( ':' );
+                U32 offset = 0, size = 0;
+                valid = colon != std::string::npos && ParseNumber( chunk.substr( 0, colon ), offset ) &&
+                        ParseNumber( chunk.substr( colon + 1 ), size ) && offset <= 0xFFFF && size >= 1 && size <= 64;
+                MELIBUSignalLayoutChunk signal_chunk;
+                signal_chunk.mOffset = ( U16 )offset;
+                signal_chunk.mSize = ( U16 )size;
+                this->mChunkStore.push_back( signal_chunk );
+                signal.mNumChunks++;
+            }
+            valid = valid && signal.mNumChunks != 0;
+            if( valid ) {
+                this->mSignalStore.push_back( signal );
+                this->mFrameStore.back().mNumSignals++;
+            }
+        } else
+            valid = false;
+
+        if( !valid ) {
+            error = std::string( "Signal layout " ) + path + ", line " + std::to_string( line_number ) + ": " +
+                    ( header ? "invalid line" : "not a signal layout file" );
+            return false;
+        }
+    }
+
+    this->mFrames.mData = this->mFrameStore.data();
+    this->mFrames.mCount = ( U32 )this->mFrameStore.size();
+    this->mSignals.mData = this->mSignalStore.data();
+    this->mSignals.mCount = ( U32 )this->mSignalStore.size();
+    this->mChunks.mData = this->mChunkStore.data();
+    this->mChunks.mCount = ( U32 )this->mChunkStore.size();
+    this->mEncodingTypes.mData = this->mEncodingTypeStore.data();
+    this->mEncodingTypes.mCount = ( U32 )this->mEncodingTypeStore.size();
+    this->mEncodings.mData = this->mEncodingStore.data();
+    this->mEncodings.mCount = ( U32 )this->mEncodingStore.size();
+    this->mSlaves.mData = this->mSlaveStore.data();
+    this->mSlaves.mCount = ( U32 )this->mSlaveStore.size();
+    this->mNames.mData = this->mNameStore.data();
+    this->mNames.mCount = ( U32 )this->mNameStore.size();
+    BuildIndex();
+    return true;
+}
+
+bool MELIBUSignalLayout::LoadBinary( const char* path, std::string& error ) {
+    std::unique_ptr < MELIBUMappedFile > file( new MELIBUMappedFile() );
+    if( !file->Open( path ) ) {
+        error = std::string( "Can't map signal layout " ) + path;
+        return false;
+    }
+    error = std::string( "Signal layout " ) + path + ": invalid binary layout";
+    const MELIBUSignalLayoutHeader* header = reinterpret_cast < const MELIBUSignalLayoutHeader* >( file->Data() );
+    if( file->Size() < sizeof( MELIBUSignalLayoutHeader ) || header->mFileSize != file->Size() )
+        return false;
+    if( header->mFormat != MELIBUSignalLayoutHeader::BinaryFormat ) {
+        error = std::string( "Signal layout " ) + path + ": unsupported binary format " + std::to_string( header->mFormat );
+        return false;
+    }
+
+    // sections are used in place; only their bounds and alignment are checked
+    static const U32 record_sizes[ MELIBUSignalLayoutHeader::SectionCount ] = {
+        sizeof( MELIBUSignalLayoutFrame ), sizeof( MELIBUSignalLayoutSignal ), sizeof( MELIBUSignalLayoutChunk ),
+        sizeof( MELIBUSignalLayoutEncodingType ), sizeof( MELIBUSignalLayoutEncoding ), 1, 1,
+        sizeof( MELIBUSignalLayoutSlot ), sizeof( U32 )
+    };
+    const void* sections[ MELIBUSignalLayoutHeader::SectionCount ];
+    for( U32 i = 0; i < MELIBUSignalLayoutHeader::SectionCount; i++ ) {
+        U64 offset = header->mSections[ i ].mOffset;
+        U64 size = ( U64 )header->mSections[ i ].mCount * record_sizes[ i ];
+        if( offset % 8 != 0 || offset < sizeof( MELIBUSignalLayoutHeader ) || offset + size > file->Size() )
+            return false;
+        sections[ i ] = file->Data() + offset;
+    }
+    U32 num_slots = header->mSections[ MELIBUSignalLayoutHeader::sectionSlots ].mCount;
+    U32 num_names = header->mSections[ MELIBUSignalLayoutHeader::sectionNames ].mCount;
+    if( num_slots == 0 || ( num_slots & ( num_slots - 1 ) ) != 0 || num_names == 0 ||
+        static_cast < const char* >( sections[ MELIBUSignalLayoutHeader::sectionNames ] )[ num_names - 1 ] != '\0' )
+        return false;
+
+    this->mVersion = header->mVersion;
+    this->mMask1 = header->mMask1;
+    this->mMask2 = header->mMask2;
+    this->mFrames.mData = static_cast < const MELIBUSignalLayoutFrame* >( sections[ MELIBUSignalLayoutHeader::sectionFrames ] );
+    this->mFrames.mCount = header->mSections[ MELIBUSignalLayoutHeader::sectionFrames ].mCount;
+    this->mSignals.mData = static_cast < const MELIBUSignalLayoutSignal* >( sections[ MELIBUSignalLayoutHeader::sectionSignals ] );
+    this->mSignals.mCount = header->mSections[ MELIBUSignalLayoutHeader::sectionSignals ].mCount;
+    this->mChunks.mData = static_cast < const MELIBUSignalLayoutChunk* >( sections[ MELIBUSignalLayoutHeader::sectionChunks ] );
+    this->mChunks.mCount = header->mSections[ MELIBUSignalLayoutHeader::sectionChunks ].mCount;
+    this->mEncodingTypes.mData = static_cast < const MELIBUSignalLayoutEncodingType* >( sections[ MELIBUSignalLayoutHeader::sectionEncodingTypes ] );
+    this->mEncodingTypes.mCount = header->mSections[ MELIBUSignalLayoutHeader::sectionEncodingTypes ].mCount;
+    this->mEncodings.mData = static_cast < const MELIBUSignalLayoutEncoding* >( sections[ MELIBUSignalLayoutHeader::sectionEncodings ] );
+    this->mEncodings.mCount = header->mSections[ MELIBUSignalLayoutHeader::sectionEncodings ].mCount;
+    this->mSlaves.mData = static_cast < const U8* >( sections[ MELIBUSignalLayoutHeader::sectionSlaves ] );
+    this->mSlaves.mCount = header->mSections[ MELIBUSignalLayoutHeader::sectionSlaves ].mCount;
+    this->mNames.mData = static_cast < const char* >( sections[ MELIBUSignalLayoutHeader::sectionNames ] );
+    this->mNames.mCount = num_names;
+    this->mSlots.mData = static_cast < const MELIBUSignalLayoutSlot* >( sections[ MELIBUSignalLayoutHeader::sectionSlots ] );
+    this->mSlots.mCount = num_slots;
+    this->mIndexFrames.mData = static_cast < const U32* >( sections[ MELIBUSignalLayoutHeader::sectionIndexFrames ] );
+    this->mIndexFrames.mCount = header->mSections[ MELIBUSignalLayoutHeader::sectionIndexFrames ].mCount;
+    std::string record_error;
+    if( !CheckRecords( record_error ) ) {
+        error += ": " + record_error;
+        return false;
+    }
+
+    this->mFile = std::move( file );
+    error.clear();
+    return true;
+}
+
+// damaged layout must not make decoding read outside of records; error names first bad record
+bool MELIBUSignalLayout::CheckRecords( std::string& error ) const {
+    for( U32 i = 0; i < this->mFrames.mCount; i++ ) {
+        const MELIBUSignalLayoutFrame& frame = this->mFrames.mData[ i ];
+        if( frame.mName >= this->mNames.mCount || frame.mFirstSignal > this->mSignals.mCount ||
+            frame.mNumSignals > this->mSignals.mCount - frame.mFirstSignal ) {
+            error = "frame " + std::to_string( i ) + " has name or signals outside of their sections";
+            return false;
+        }
+    }
+    for( U32 i = 0; i < this->mSignals.mCount; i++ ) {
+        const MELIBUSignalLayoutSignal& signal = this->mSignals.mData[ i ];
+        if( signal.mName >= this->mNames.mCount || signal.mFirstChunk > this->mChunks.mCount ||
+            signal.mNumChunks > this->mChunks.mCount - signal.mFirstChunk ||
+            signal.mEncodingType >= ( S32 )this->mEncodingTypes.mCount ) {
+            error = "signal " + std::to_string( i ) + " has name, chunks or encoding type outside of their sections";
+            return false;
+        }
+    }
+    for( U32 i = 0; i < this->mChunks.mCount; i++ ) {
+        if( this->mChunks.mData[ i ].mSize == 0 || this->mChunks.mData[ i ].mSize > 64 ) {
+            error = "chunk " + std::to_string( i ) + " has size " + std::to_string( this->mChunks.mData[ i ].mSize ) +
+                    ", not 1 to 64 bits";
+            return false;
+        }
+    }
+    for( U32 i = 0; i < this->mEncodingTypes.mCount; i++ ) {
+        const MELIBUSignalLayoutEncodingType& type = this->mEncodingTypes.mData[ i ];
+        if( type.mName >= this->mNames.mCount || type.mFirstEncoding > this->mEncodings.mCount ||
+            type.mNumEncodings > this->mEncodings.mCount - type.mFirstEncoding ) {
+            error = "encoding type " + std::to_string( i ) + " has name or encodings outside of their sections";
+            return false;
+        }
+    }
+    for( U32 i = 0; i < this->mEncodings.mCount; i++ ) {
+        if( this->mEncodings.mData[ i ].mText >= this->mNames.mCount ) {
+            error = "encoding " + std::to_string( i ) + " has text outside of name section";
+            return false;
+        }
+    }
+    U32 used_slots = 0;
+    for( U32 i = 0; i < this->mSlots.mCount; i++ ) {
+        const MELIBUSignalLayoutSlot& slot = this->mSlots.mData[ i ];
+        used_slots += slot.mCount != 0 ? 1 : 0;
+        if( slot.mFirst > this->mIndexFrames.mCount || slot.mCount > this->mIndexFrames.mCount - slot.mFirst ) {
+            error = "hash slot " + std::to_string( i ) + " has frames outside of index section";
+            return false;
+        }
+    }
+    for( U32 i = 0; i < this->mIndexFrames.mCount; i++ ) {
+        if( this->mIndexFrames.mData[ i ] >= this->mFrames.mCount ) {
+            error = "index entry " + std::to_string( i ) + " refers to frame " + std::to_string( this->mIndexFrames.mData[ i ] ) +
+                    " of " + std::to_string( this->mFrames.mCount );
+            return false;
+        }
+    }
+    // lookup stops at first empty slot
+    if( used_slots == this->mSlots.mCount ) {
+        error = "hash table has no empty slot";
+        return false;
+    }
+    return true;
+}
+
+double MELIBUSignalLayout::Version() const {
+    return this->mVersion;
+}
+
+U32 MELIBUSignalLayout::Key( U8 id1, U8 id2, U16 instruction ) const {
+    return ( ( U32 )( id1 & this->mMask1 ) << 24 ) | ( ( U32 )( id2 & this->mMask2 ) << 16 ) | instruction;
+}
+
+U32 MELIBUSignalLayout::Hash( U32 key ) {
+    U32 hash = key * 0x9E3779B1u;
+    return hash ^ ( hash >> 16 );
+}
+
+// open addressing with linear probing; at least half of slots stay empty
+void MELIBUSignalLayout::BuildIndex() {
+    std::vector < U32 > keys; // in order of first frame
+    std::vector < std::vector < U32 > > frames;
+    std::unordered_map < U32, size_t > positions;
+    for( U32 i = 0; i < this->mFrameStore.size(); i++ ) {
+        const MELIBUSignalLayoutFrame& frame = this->mFrameStore[ i ];
+        U32 key = Key( frame.mID1, frame.mID2, frame.mInstruction );
+        auto position = positions.find( key );
+        if( position == positions.end() ) {
+            position = positions.emplace( key, keys.size() ).first;
+            keys.push_back( key );
+            frames.push_back( std::vector < U32 >() );
+        }
+        frames[ position->second ].push_back( i );
+    }
+
+    U32 num_slots = 1;
+    while( num_slots < 2 * keys.size() + 1 )
+        num_slots <<= 1;
+    this->mSlotStore.assign( num_slots, MELIBUSignalLayoutSlot() );
+    this->mIndexFrameStore.clear();
+    for( size_t k = 0; k < keys.size(); k++ ) {
+        U32 slot = Hash( keys[ k ] ) & ( num_slots - 1 );
+        while( this->mSlotStore[ slot ].mCount != 0 )
+            slot = ( slot + 1 ) & ( num_slots - 1 );
+        this->mSlotStore[ slot ].mKey = keys[ k ];
+        this->mSlotStore[ slot ].mFirst = ( U32 )this->mIndexFrameStore.size();
+        this->mSlotStore[ slot ].mCount = ( U32 )frames[ k ].size();
+        this->mIndexFrameStore.insert( this->mIndexFrameStore.end(), frames[ k ].begin(), frames[ k ].end() );
+    }
+    this->mSlots.mData = this->mSlotStore.data();
+    this->mSlots.mCount = num_slots;
+    this->mIndexFrames.mData = this->mIndexFrameStore.data();
+    this->mIndexFrames.mCount = ( U32 )this->mIndexFrameStore.size();
+}
+
+U32 MELIBUSignalLayout::Lookup( U8 id1, U8 id2, U16 instruction, const U32*& frames ) const {
+    if( this->mSlots.mCount == 0 )
+        return 0;
+    U32 key = Key( id1, id2, instruction );
+    U32 mask = this->mSlots.mCount - 1;
+    for( U32 slot = Hash( key ) & mask; this->mSlots.mData[ slot ].mCount != 0; slot = ( slot + 1 ) & mask ) {
+        if( this->mSlots.mData[ slot ].mKey == key ) {
+            frames = this->mIndexFrames.mData + this->mSlots.mData[ slot ].mFirst;
+            return this->mSlots.mData[ slot ].mCount;
+        }
+    }
+    return 0;
+}
+
+// same bit order as MeLiBu HLA: bytes containing chunk are joined (MeLiBu 1 first byte is msb, MeLiBu 2 first byte is lsb)
+// and chunk bits are counted from msb of joined value
+bool MELIBUSignalLayout::SignalValue( const MELIBUSignalLayoutSignal& signal, const U8* data, U32 length, U64& raw ) const {
+    bool msb_first = this->mVersion < 2.0;
+    raw = 0;
+    for( U32 c = 0; c < signal.mNumChunks; c++ ) {
+        const MELIBUSignalLayoutChunk& chunk = this->mChunks.mData[ signal.mFirstChunk + c ];
+        U32 first = chunk.mOffset / 8;
+        U32 last = ( chunk.mOffset + chunk.mSize - 1 ) / 8;
+        U32 num_bytes = last - first + 1;
+        if( last >= length || num_bytes > 8 )
+            return false;
+
+        U64 value = 0;
+        for( U32 i = first; i <= last; i++ ) {
+            if( msb_first )
+                value = ( value << 8 ) | data[ i ];
+            else
+                value |= ( U64 )data[ i ] << ( 8 * ( i - first ) );
+        }
+        U32 shift = 8 * num_bytes - chunk.mSize - chunk.mOffset % 8;
+        U64 mask = chunk.mSize >= 64 ? ~0ULL : ( ( 1ULL << chunk.mSize ) - 1 );
+        raw = ( chunk.mSize >= 64 ? 0 : ( raw << chunk.mSize ) ) | ( ( value >> shift ) & mask );
+    }
+    return true;
+}
+
+const MELIBUSignalLayoutEncoding* MELIBUSignalLayout::FindEncoding( const MELIBUSignalLayoutSignal& signal, U64 raw ) const {
+    if( signal.mEncodingType < 0 )
+        return nullptr;
+    const MELIBUSignalLayoutEncodingType& type = this->mEncodingTypes.mData[ signal.mEncodingType ];
+    for( U32 i = 0; i < type.mNumEncodings; i++ ) {
+        const MELIBUSignalLayoutEncoding& encoding = this->mEncodings.mData[ type.mFirstEncoding + i ];
+        if( encoding.mMin <= raw && raw <= encoding.mMax )
+            return &encoding;
+    }
+    return nullptr;
+}
+
+bool MELIBUSignalLayout::IsSlave( U8 nad ) const {
+    if( this->mSlaves.mCount == 0 )
+        return true;
+    for( U32 i = 0; i < this->mSlaves.mCount; i++ )
+        if( this->mSlaves.mData[ i ] == nad )
+            return true;
+    return false;
+}
+
+U8 MELIBUSignalLayout::SlaveAddress( U8 id1 ) const {
+    return this->mVersion < 2.0 ? id1 >> 2 : id1;
+}
+
+U32 MELIBUSignalLayout::AddName( const std::string& name ) {
+    U32 offset = ( U32 )this->mNameStore.size();
+    this->mNameStore.append( name );
+    this->mNameStore.push_back( '\0' );
+    return offset;
+}
@@ -0,0 +1,187 @@
+#ifndef MELIBU_SIGNAL_LAYOUT_H
+#define MELIBU_SIGNAL_LAYOUT_H
+
+#include "MELIBUTypes.h"
+#include "MELIBUMappedFile.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+// frames, signals and encodings of a bus description; compiled from MBDF by MeLiBu_high_level/mbdf_to_layout.py
+// all names are offsets into one string pool; records refer to each other by index
+// records are stored unchanged in binary layout files, so their size must not change
+struct MELIBUSignalLayoutFrame
+{
+    U32 mName;
+    U8 mID1;          // header bits selected by header mask; slave address bits are not part of frame
+    U8 mID2;
+    U16 mInstruction; // MeLiBu 2 instruction word; 0 if frame has no instruction
+    U32 mFirstSignal;
+    U32 mNumSignals;
+};
+
+struct MELIBUSignalLayoutSignal
+{
+    U32 mName;
+    U32 mFirstChunk;   // chunks from most to least significant
+    U32 mNumChunks;
+    S32 mEncodingType; // -1 if raw value only
+};
+
+// bits of signal in payload; offset counts from first bit of payload as read by HLA (msb of first byte)
+struct MELIBUSignalLayoutChunk
+{
+    U16 mOffset;
+    U16 mSize;
+};
+
+struct MELIBUSignalLayoutEncodingType
+{
+    U32 mName;
+    U32 mFirstEncoding;
+    U32 mNumEncodings;
+};
+
+struct MELIBUSignalLayoutEncoding
+{
+    typedef enum {
+        encodingLogical = 0, // raw value mMin is shown as text
+        encodingPhysical = 1 // raw values mMin to mMax are scaled; text is unit
+    } tMELIBUEncoding;
+
+    U32 mType; // tMELIBUEncoding
+    U32 mText;
+    U32 mMin;
+    U32 mMax;
+    double mScale;
+    double mOffset;
+};
+
+// hash table slot; frames with key are mCount entries of frame index list from mFirst; empty if mCount is 0
+struct MELIBUSignalLayoutSlot
+{
+    U32 mKey;
+    U32 mFirst;
+    U32 mCount;
+};
+
+// binary layout file: header followed by record sections, all little endian and 8 byte aligned
+// written by mbdf_to_layout.py --binary and used in place through memory mapping
+struct MELIBUSignalLayoutHeader
+{
+    enum { BinaryFormat = 1 };
+
+    typedef enum {
+        sectionFrames,
+        sectionSignals,
+        sectionChunks,
+        sectionEncodingTypes,
+        sectionEncodings,
+        sectionSlaves,
+        sectionNames,
+        sectionSlots,       // number of slots is a power of 2
+        sectionIndexFrames, // U32 frame indices referred to by slots
+        SectionCount
+    } tMELIBULayoutSection;
+
+    char mMagic[ 8 ]; // "MLBLAYT\0"
+    U32 mFormat;      // BinaryFormat
+    U32 mFileSize;
+    double mVersion;
+    U8 mMask1;
+    U8 mMask2;
+    U16 mReserved;
+    struct
+    {
+        U32 mOffset; // from start of file
+        U32 mCount;  // records; bytes for names and slaves
+    } mSections[ SectionCount ];
+    U32 mReserved2;
+};
+
+// signal layout loaded from text or binary file; frames are indexed by (ID1, ID2, instruction word) in a hash table
+// loaded once by settings and shared read-only by decoding threads
+class MELIBUSignalLayout
+{
+ public:
+    MELIBUSignalLayout();
+    ~MELIBUSignalLayout();
+
+    // binary layouts are mapped without parsing, other files are read as text layout
+    // returns false and sets error if file can't be used
+    bool Load( const char* path, std::string& error );
+
+    double Version() const; // MeLiBu version of bus description
+
+    // indices of frames matching header; several MBDF frames may share the same header bits
+    U32 Lookup( U8 id1, U8 id2, U16 instruction, const U32*& frames ) const;
+
+    // raw signal value from message payload; false if payload is too short for signal
+    bool SignalValue( const MELIBUSignalLayoutSignal& signal, const U8* data, U32 length, U64& raw ) const;
+    // first encoding of signal that covers raw value; nullptr if there is none
+    const MELIBUSignalLayoutEncoding* FindEncoding( const MELIBUSignalLayoutSignal& signal, U64 raw ) const;
+
+    bool IsSlave( U8 nad ) const; // true if no slaves are listed
+    U8 SlaveAddress( U8 id1 ) const;
+
+    const MELIBUSignalLayoutFrame& Frame( U32 index ) const {
+        return this->mFrames.mData[ index ];
+    }
+    const MELIBUSignalLayoutSignal& Signal( U32 index ) const {
+        return this->mSignals.mData[ index ];
+    }
+    const char* Name( U32 offset ) const {
+        return this->mNames.mData + offset;
+    }
+
+    static U32 Hash( U32 key ); // slot of key is Hash( key ) & ( number of slots - 1 ); same function in mbdf_to_layout.py
+
+ protected:
+    template < class T >
+    struct Records
+    {
+        Records() : mData( nullptr ), mCount( 0 ) {}
+
+        const T* mData;
+        U32 mCount;
+    };
+
+    bool LoadText( const char* path, std::string& error );
+    bool LoadBinary( const char* path, std::string& error );
+    bool CheckRecords( std::string& error ) const; // all indices and name offsets are inside their sections; error tells which are not
+
+    U32 AddName( const std::string& name );
+    void BuildIndex();
+    U32 Key( U8 id1, U8 id2, U16 instruction ) const;
+
+ protected: //vars
+    double mVersion;
+    U8 mMask1; // header bits that select frame
+    U8 mMask2;
+
+    // point into records of text layout below or into mapped binary layout
+    Records < MELIBUSignalLayoutFrame > mFrames;
+    Records < MELIBUSignalLayoutSignal > mSignals;
+    Records < MELIBUSignalLayoutChunk > mChunks;
+    Records < MELIBUSignalLayoutEncodingType > mEncodingTypes;
+    Records < MELIBUSignalLayoutEncoding > mEncodings;
+    Records < U8 > mSlaves;
+    Records < char > mNames; // zero terminated names
+    Records < MELIBUSignalLayoutSlot > mSlots;
+    Records < U32 > mIndexFrames;
+
+    // records of text layout
+    std::vector < MELIBUSignalLayoutFrame > mFrameStore;
+    std::vector < MELIBUSignalLayoutSignal > mSignalStore;
+    std::vector < MELIBUSignalLayoutChunk > mChunkStore;
+    std::vector < MELIBUSignalLayoutEncodingType > mEncodingTypeStore;
+    std::vector < MELIBUSignalLayoutEncoding > mEncodingStore;
+    std::vector < U8 > mSlaveStore;
+    std::string mNameStore;
+    std::vector < MELIBUSignalLayoutSlot > mSlotStore;
+    std::vector < U32 > mIndexFrameStore;
+
+    std::unique_ptr < MELIBUMappedFile > mFile; // binary layout
+};
+
+#endif //MELIBU_SIGNAL_LAYOUT_H
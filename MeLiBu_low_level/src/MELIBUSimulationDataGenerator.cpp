@@ -5,7 +5,6 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
-#include <regex>
 
 #ifdef BUILD_WIN32
 #include <Windows.h>
@@ -23,7 +22,24 @@ void MELIBUSimulationDataGenerator::Initialize( U32 simulation_sample_rate, MELI
     mSerialSimulationData.SetSampleRate( simulation_sample_rate );
     mSerialSimulationData.SetInitialBitState( BIT_HIGH );
 
-    ReadSimulationBytes(); // read messages from simulated_data.csv and save to simulation_bytes vector
+    if( mSettings->mSimulationSource == simulationSynthetic ) {
+        MELIBUTrafficSettings traffic;
+        traffic.mMELIBUVersion = mSettings->mMELIBUVersion;
+        traffic.mBusLoad = mSettings->mSimulationBusLoad;
+        traffic.mACK = mSettings->mACK;
+        traffic.mACKValue = mSettings->mACKValue;
+        // one fault per faulty message, type chosen evenly, so selected share is share of faulty messages
+        traffic.mFaultRate = mSettings->mSimulationFaults * 10;
+        mTrafficGenerator.Setup( traffic );
+        return;
+    }
+
+    ReadSimulationBytes(); // read messages from simulated_data.csv and save to mProgram
+
+    // settings don't change after initialization; waveform of every message is rendered only once
+    mMessageTemplates.resize( mProgram.size() );
+    for( size_t i = 0; i < mProgram.size(); i++ )
+        RenderMessage( mProgram[ i ], mMessageTemplates[ i ] );
 }
 
 U32 MELIBUSimulationDataGenerator::GenerateSimulationData( U64 largest_sample_requested,
@@ -34,7 +50,10 @@ U32 MELIBUSimulationDataGenerator::GenerateSimulationData( U64 largest_sample_re
                                                                                            mSimulationSampleRateHz );
 
     while( mSerialSimulationData.GetCurrentSampleNumber() < adjusted_largest_sample_requested ) {
-        CreateFrame();
+        if( mSettings->mSimulationSource == simulationSynthetic )
+            CreateSyntheticFrame();
+        else
+            CreateFrame();
     }
 
     *simulation_channel = &mSerialSimulationData;
@@ -45,90 +64,80 @@ void MELIBUSimulationDataGenerator::CreateFrame() {
     U32 samples_per_bit = mSimulationSampleRateHz / mSettings->mBitRate;
     mSerialSimulationData.Advance( samples_per_bit * Random( 1, 4 ) ); // simulate jitter
 
-    // iterate through simulaton bytes - vector of vectors of string
-    // each vector is one message with more data to generate
-    for( std::vector < std::vector < std::string >> ::iterator frame = simulation_bytes.begin();
-         frame != simulation_bytes.end();
-         ++frame ) {
-        CreateBreakField(); // create break field before every message
-        for( std::vector < std::string > ::iterator byte = ( *frame ).begin(); byte != ( *frame ).end(); ++byte ) {
-            std::regex reg( "^[0-9a-fA-F]{1,2}$" );
-            if( std::regex_match( *byte, reg ) )
-                CreateSerialByte( stoi( *byte, 0, 16 ) );
-
-            reg = "^-[0-9a-fA-F]{1,2}$"; // this is for creating byte with wrong stop bit
-            if( std::regex_match( *byte, reg ) )
-                CreateSerialByteWrongStop( stoi( ( *byte ).erase( 0, 1 ), 0, 16 ) );
-        }
+    // replay all messages
+    for( std::vector < std::vector < SimulationRun >> ::const_iterator message = mMessageTemplates.begin();
+         message != mMessageTemplates.end();
+         ++message )
+        ReplayRuns( *message );
+}
+
+// one generated message followed by idle time
+void MELIBUSimulationDataGenerator::CreateSyntheticFrame() {
+    mTrafficGenerator.Next( mTrafficMessage );
+
+    mTrafficRuns.clear();
+    RenderBreakField( mTrafficRuns );
+    for( std::vector < MELIBUTrafficByte > ::const_iterator byte = mTrafficMessage.mBytes.begin(); byte != mTrafficMessage.mBytes.end(); ++byte )
+        RenderSerialByte( mTrafficRuns, byte->mValue, byte->mWrongStop ? BIT_LOW : BIT_HIGH );
+    AddRun( mTrafficRuns, BIT_HIGH, ( mSimulationSampleRateHz / mSettings->mBitRate ) * mTrafficMessage.mIdleBits );
+    ReplayRuns( mTrafficRuns );
+}
+
+void MELIBUSimulationDataGenerator::ReplayRuns( const std::vector < SimulationRun >& runs ) {
+    for( std::vector < SimulationRun > ::const_iterator run = runs.begin(); run != runs.end(); ++run ) {
+        mSerialSimulationData.TransitionIfNeeded( run->mState );
+        mSerialSimulationData.Advance( run->mSamples );
     }
 }
 
-void MELIBUSimulationDataGenerator::CreateBreakField() {
+void MELIBUSimulationDataGenerator::RenderMessage( const std::vector < SimulationByte >& message, std::vector < SimulationRun >& runs ) {
+    runs.clear();
+    RenderBreakField( runs ); // create break field before every message
+    for( std::vector < SimulationByte > ::const_iterator byte = message.begin(); byte != message.end(); ++byte )
+        RenderSerialByte( runs, byte->mValue, byte->mWrongStop ? BIT_LOW : BIT_HIGH );
+}
+
+void MELIBUSimulationDataGenerator::RenderBreakField( std::vector < SimulationRun >& runs ) {
     // The break field.
     U32 samples_per_bit = ( mSimulationSampleRateHz / mSettings->mBitRate ) + 1; // to fix round off error
-    U8 byte1 = 0x0; // 0000 0000
-    U8 byte2 = 0xE0;// 1110 0000
-
-    SwapEnds( byte1 );
-    SwapEnds( byte2 );
 
     // inter-byte space.....
-    mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-    mSerialSimulationData.Advance( samples_per_bit * 2 );
-
-    // there is no start bit on the break field.
-    //// start bit...
-    // mSerialSimulationData.Transition( );                 //low-going edge for start bit
-    // mSerialSimulationData.Advance( samples_per_bit );	//add start bit time
-
-    U16 mask_byte = byte1; // 0000 0000 0000 0000
-    mask_byte |= ( ( U16 )byte2 << 8 ); // 1110 0000 0000 0000
-    U16 mask = 0x1 << 7; // 0000 0000 1000 0000
-    U32 accumulator = 0;
-    for( U32 i = 0; i < 13; i++ ) {
-        // mask_byte & mask = 0000 0000 0000 0000
-        if( ( mask_byte & mask ) != 0 )
-            mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-        else
-            mSerialSimulationData.TransitionIfNeeded( BIT_LOW );
+    AddRun( runs, BIT_HIGH, samples_per_bit * 2 );
 
-        mSerialSimulationData.Advance( samples_per_bit );
-        mask = mask >> 1;
-    }
+    // there is no start bit on the break field; 13 low bits
+    AddRun( runs, BIT_LOW, samples_per_bit * 13 );
 
     // stop bit...
-    mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-    mSerialSimulationData.Advance( samples_per_bit );
+    AddRun( runs, BIT_HIGH, samples_per_bit );
 }
 
-void MELIBUSimulationDataGenerator::CreateSerialByte( U8 byte ) {
+void MELIBUSimulationDataGenerator::RenderSerialByte( std::vector < SimulationRun >& runs, U8 byte, BitState stop_bit ) {
     U32 samples_per_bit = mSimulationSampleRateHz / mSettings->mBitRate;
 
-    if(mSettings->mMELIBUVersion == 2.0)
+    if( mSettings->mMELIBUVersion == 2.0 )
         SwapEnds( byte );
 
-    // inter-byte space.....
-    //mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-    //mSerialSimulationData.Advance( samples_per_bit );
-
     // start bit...
-    mSerialSimulationData.TransitionIfNeeded( BIT_LOW );
-    mSerialSimulationData.Advance( samples_per_bit ); // add start bit time
+    AddRun( runs, BIT_LOW, samples_per_bit ); // add start bit time
 
     U8 mask = 0x1 << 7;
     for( U32 i = 0; i < 8; i++ ) {
-        if( ( byte & mask ) != 0 )
-            mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-        else
-            mSerialSimulationData.TransitionIfNeeded( BIT_LOW );
-
-        mSerialSimulationData.Advance( samples_per_bit );
+        AddRun( runs, ( byte & mask ) != 0 ? BIT_HIGH : BIT_LOW, samples_per_bit );
         mask = mask >> 1;
     }
 
-    // stop bit...
-    mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-    mSerialSimulationData.Advance( samples_per_bit );
+    // stop bit; low for byte with wrong stop bit
+    AddRun( runs, stop_bit, samples_per_bit );
+}
+
+// consecutive bits with same level are merged into one run
+void MELIBUSimulationDataGenerator::AddRun( std::vector < SimulationRun >& runs, BitState state, U32 samples ) {
+    if( !runs.empty() && runs.back().mState == state ) {
+        runs.back().mSamples += samples;
+    } else {
+        SimulationRun run = { state, samples };
+        runs.push_back( run );
+    }
 }
 
 void MELIBUSimulationDataGenerator::SwapEnds( U8& byte ) {
@@ -145,36 +154,28 @@ U32 MELIBUSimulationDataGenerator::Random( U32 min, U32 max ) {
     return min + ( rand() % ( max - min + 1 ) );
 }
 
-void MELIBUSimulationDataGenerator::CreateSerialByteWrongStop( U8 byte ) {
-    U32 samples_per_bit = mSimulationSampleRateHz / mSettings->mBitRate;
-
-    // mChecksum.add( byte );
-    if( mSettings->mMELIBUVersion == 2.0 )
-        SwapEnds( byte );
-
-    // inter-byte space.....
-    // mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-    // mSerialSimulationData.Advance( samples_per_bit );
-
-    // start bit...
-    mSerialSimulationData.TransitionIfNeeded( BIT_LOW );
-    // mSerialSimulationData.Transition();               // low-going edge for start bit
-    mSerialSimulationData.Advance( samples_per_bit ); // add start bit time
-
-    U8 mask = 0x1 << 7;
-    for( U32 i = 0; i < 8; i++ ) {
-        if( ( byte & mask ) != 0 )
-            mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
+// valid entries are one or two hex digits, optionally prefixed with '-' for wrong stop bit; anything else is skipped
+bool MELIBUSimulationDataGenerator::ParseSimulationByte( const std::string& text, SimulationByte& byte ) {
+    size_t first = ( !text.empty() && text[ 0 ] == '-' ) ? 1 : 0;
+    size_t digits = text.size() - first;
+    if( digits < 1 || digits > 2 )
+        return false;
+
+    U8 value = 0;
+    for( size_t i = first; i < text.size(); i++ ) {
+        char c = text[ i ];
+        if( c >= '0' && c <= '9' )
+            value = ( value << 4 ) | ( c - '0' );
+        else if( c >= 'a' && c <= 'f' )
+            value = ( value << 4 ) | ( c - 'a' + 10 );
+        else if( c >= 'A' && c <= 'F' )
+            value = ( value << 4 ) | ( c - 'A' + 10 );
         else
-            mSerialSimulationData.TransitionIfNeeded( BIT_LOW );
-
-        mSerialSimulationData.Advance( samples_per_bit );
-        mask = mask >> 1;
+            return false;
     }
-
-    // stop bit...
-    mSerialSimulationData.TransitionIfNeeded( BIT_LOW );
-    mSerialSimulationData.Advance( samples_per_bit );
+    byte.mValue = value;
+    byte.mWrongStop = first != 0;
+    return true;
 }
 
 void helper() {}; // this is only for finding path of dll; this function can't be class member function
@@ -202,13 +203,15 @@ void MELIBUSimulationDataGenerator::ReadSimulationBytes() {
     std::string line;
     while( std::getline( fin, line ) ) {
         // one line has more hex numbers in message separated with comma
-        std::vector < std::string > bytes_in_line;
-        std::string byte;
-        std::stringstream ss(line);
-        // read element from line and save to byte
-        while( std::getline( ss, byte, ',' ) )
-            bytes_in_line.push_back( byte ); // add to vector of bytes in message
-
-        simulation_bytes.push_back( bytes_in_line ); // add message vector to vector of messages
+        std::vector < SimulationByte > message;
+        std::string text;
+        std::stringstream ss( line );
+        while( std::getline( ss, text, ',' ) ) {
+            SimulationByte byte;
+            if( ParseSimulationByte( text, byte ) )
+                message.push_back( byte );
+        }
+
+        mProgram.push_back( message ); // add message to program; empty line still creates break field
     }
 }
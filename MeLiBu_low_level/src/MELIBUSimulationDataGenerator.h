@@ -4,12 +4,17 @@
 #include <SimulationChannelDescriptor.h>
 #include <string>
 #include <vector>
-#include "MELIBUCrc.h"
+#include "MELIBUTrafficGenerator.h"
 class MELIBUAnalyzerSettings;
 
 class MELIBUSimulationDataGenerator
 {
  public:
+    typedef enum {
+        simulationCsv = 0,      // messages from simulated_data.csv
+        simulationSynthetic = 1 // MELIBUTrafficGenerator
+    } tMELIBUSimulationSource;
+
     MELIBUSimulationDataGenerator();
     ~MELIBUSimulationDataGenerator();
 
@@ -19,24 +24,45 @@ class MELIBUSimulationDataGenerator
                                 SimulationChannelDescriptor** simulation_channel );
 
  protected:
+    // one byte from simulated_data.csv; "-xx" is byte with wrong stop bit
+    struct SimulationByte
+    {
+        U8 mValue;
+        bool mWrongStop;
+    };
+
+    // bus level held for number of samples; message is rendered once to list of runs and replayed on every pass
+    struct SimulationRun
+    {
+        BitState mState;
+        U32 mSamples;
+    };
+
     MELIBUAnalyzerSettings* mSettings;
     U32 mSimulationSampleRateHz;
 
-    std::vector < std::vector < std::string >> simulation_bytes;
+    std::vector < std::vector < SimulationByte >> mProgram;      // messages read from simulated_data.csv
+    std::vector < std::vector < SimulationRun >> mMessageTemplates; // rendered messages, same order as mProgram
+
+    MELIBUTrafficGenerator mTrafficGenerator;
+    MELIBUTrafficMessage mTrafficMessage;
+    std::vector < SimulationRun > mTrafficRuns;
 
  protected:
     void CreateFrame();
-    void CreateBreakField();
-    void CreateSerialByte( U8 byte );
+    void CreateSyntheticFrame();
+    void ReplayRuns( const std::vector < SimulationRun >& runs );
+    void RenderMessage( const std::vector < SimulationByte >& message, std::vector < SimulationRun >& runs );
+    void RenderBreakField( std::vector < SimulationRun >& runs );
+    void RenderSerialByte( std::vector < SimulationRun >& runs, U8 byte, BitState stop_bit );
+    void AddRun( std::vector < SimulationRun >& runs, BitState state, U32 samples );
     void SwapEnds( U8& byte );
     U32 Random( U32 min, U32 max );
 
-    void CreateSerialByteWrongStop( U8 byte );
-
     void ReadSimulationBytes();
+    static bool ParseSimulationByte( const std::string& text, SimulationByte& byte );
 
     SimulationChannelDescriptor mSerialSimulationData;
-    MELIBUCrc mCRC;
 
 };
-#endif //MELIBU_SIMULATION_DATA_GENERATOR
\ No newline at end of file
+#endif //MELIBU_SIMULATION_DATA_GENERATOR
@@ -0,0 +1,123 @@
+#include "MELIBUTrafficGenerator.h"
+#include "MELIBUCrc.h"
+
+MELIBUTrafficSettings::MELIBUTrafficSettings()
+    :   mMELIBUVersion( 2.0 ),
+    mBusLoad( 50 ),
+    mIdCount( 0 ),
+    mShortWeight( 1 ),
+    mMediumWeight( 1 ),
+    mLongWeight( 1 ),
+    mACK( false ),
+    mACKValue( 0x7E ),
+    mCrcErrorRate( 0 ),
+    mFramingErrorRate( 0 ),
+    mMissingByteRate( 0 ),
+    mFaultRate( 0 ),
+    mSeed( 1 ) {}
+
+MELIBUTrafficGenerator::MELIBUTrafficGenerator() : mLayouts( nullptr ), mAckValue( 0x7E ), mCrcMsbFirst( false ) {}
+
+MELIBUTrafficGenerator::~MELIBUTrafficGenerator() {}
+
+void MELIBUTrafficGenerator::Setup( const MELIBUTrafficSettings& settings ) {
+    this->mSettings = settings;
+    if( this->mSettings.mBusLoad < 1 )
+        this->mSettings.mBusLoad = 1;
+    if( this->mSettings.mBusLoad > 100 )
+        this->mSettings.mBusLoad = 100;
+
+    MELIBUProtocol::tVersion version = MELIBUProtocol::FromVersion( settings.mMELIBUVersion );
+    this->mLayouts = &MELIBUFrameLayoutTable::Get( version );
+    this->mAckValue = version == MELIBUProtocol::MeLiBu2 ? settings.mACKValue : 0x7E;
+    this->mCrcMsbFirst = MELIBUProtocol::CrcMsbFirst( version );
+    this->mRandom.seed( settings.mSeed );
+
+    for( U32 i = 0; i < 3; i++ )
+        this->mIdsByLength[ i ].clear();
+    for( U32 ids = 0; ids < 65536; ids++ ) {
+        U8 length = this->mLayouts->Lookup( ids >> 8, ids & 0xFF ).mDataLength;
+        this->mIdsByLength[ length <= 6 ? 0 : length <= 30 ? 1 : 2 ].push_back( ids );
+    }
+
+    this->mIdPool.clear();
+    for( U32 i = 0; i < this->mSettings.mIdCount; i++ )
+        this->mIdPool.push_back( RandomIds() );
+}
+
+void MELIBUTrafficGenerator::Next( MELIBUTrafficMessage& message ) {
+    message.mBytes.clear();
+    message.mFaults = 0;
+    U8 fault = Chance( this->mSettings.mFaultRate ) ? 1 << Random( 3 ) : 0; // tMELIBUTrafficFault
+
+    U16 ids = this->mIdPool.empty() ? RandomIds() : this->mIdPool[ Random( this->mIdPool.size() ) ];
+    const MELIBUFrameLayout& layout = this->mLayouts->Lookup( ids >> 8, ids & 0xFF );
+
+    AddByte( message, ids >> 8 );
+    AddByte( message, ids & 0xFF );
+    U32 length = layout.mDataLength + ( ( layout.mFlags & MELIBUFrameLayout::hasInstruction ) ? 2 : 0 );
+    for( U32 i = 0; i < length; i++ )
+        AddByte( message, Random( 256 ) );
+
+    // crc over header, instruction and data
+    MELIBUCrc crc;
+    for( size_t i = 0; i < message.mBytes.size(); i++ )
+        crc.add( message.mBytes[ i ].mValue );
+    U16 crc_value = crc.result();
+    if( fault == MELIBUTrafficMessage::faultCrc || Chance( this->mSettings.mCrcErrorRate ) ) {
+        crc_value ^= 1 << Random( 16 );
+        message.mFaults |= MELIBUTrafficMessage::faultCrc;
+    }
+    AddByte( message, this->mCrcMsbFirst ? crc_value >> 8 : crc_value & 0xFF );
+    AddByte( message, this->mCrcMsbFirst ? crc_value & 0xFF : crc_value >> 8 );
+
+    if( this->mSettings.mACK && ( layout.mFlags & MELIBUFrameLayout::ackExpected ) )
+        AddByte( message, this->mAckValue );
+
+    if( fault == MELIBUTrafficMessage::faultFraming || Chance( this->mSettings.mFramingErrorRate ) ) {
+        message.mBytes[ Random( message.mBytes.size() ) ].mWrongStop = true;
+        message.mFaults |= MELIBUTrafficMessage::faultFraming;
+    }
+    if( fault == MELIBUTrafficMessage::faultMissingByte || Chance( this->mSettings.mMissingByteRate ) ) {
+        // keep header so that message is recognized
+        message.mBytes.resize( 2 + Random( message.mBytes.size() - 2 ) );
+        message.mFaults |= MELIBUTrafficMessage::faultMissingByte;
+    }
+
+    // idle time varies between 0 and twice the average needed for requested bus load
+    U32 message_bits = BreakFieldBits + 10 * message.mBytes.size();
+    U32 average_idle = message_bits * ( 100 - this->mSettings.mBusLoad ) / this->mSettings.mBusLoad;
+    message.mIdleBits = Random( 2 * average_idle + 1 );
+}
+
+U32 MELIBUTrafficGenerator::Random( U32 range ) {
+    return range == 0 ? 0 : this->mRandom() % range;
+}
+
+bool MELIBUTrafficGenerator::Chance( U32 per_mille ) {
+    return per_mille != 0 && Random( 1000 ) < per_mille;
+}
+
+U16 MELIBUTrafficGenerator::RandomIds() {
+    U32 weights[ 3 ] = { this->mSettings.mShortWeight, this->mSettings.mMediumWeight, this->mSettings.mLongWeight };
+    U32 total = 0;
+    for( U32 i = 0; i < 3; i++ ) {
+        if( this->mIdsByLength[ i ].empty() )
+            weights[ i ] = 0;
+        total += weights[ i ];
+    }
+
+    if( total == 0 ) // no weights set; every id pair has same probability
+        return Random( 65536 );
+
+    U32 group = 0;
+    for( U32 pick = Random( total ); pick >= weights[ group ]; group++ )
+        pick -= weights[ group ];
+    const std::vector < U16 >& ids = this->mIdsByLength[ group ];
+    return ids[ Random( ids.size() ) ];
+}
+
+void MELIBUTrafficGenerator::AddByte( MELIBUTrafficMessage& message, U8 value ) {
+    MELIBUTrafficByte byte = { value, false };
+    message.mBytes.push_back( byte );
+}
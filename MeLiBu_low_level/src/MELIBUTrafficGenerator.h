@@ -0,0 +1,78 @@
+#ifndef MELIBU_TRAFFIC_GENERATOR_H
+#define MELIBU_TRAFFIC_GENERATOR_H
+
+#include "MELIBUTypes.h"
+#include "MELIBUFrameLayout.h"
+#include <random>
+#include <vector>
+
+// parameters of synthetic bus traffic
+struct MELIBUTrafficSettings
+{
+    MELIBUTrafficSettings();
+
+    double mMELIBUVersion;
+    U32 mBusLoad;          // percent of bus time occupied by messages, 1 - 100
+    U32 mIdCount;          // number of different (ID1, ID2) pairs on the bus; 0 = new random pair for every message
+    U32 mShortWeight;      // relative share of messages with up to 6 data bytes
+    U32 mMediumWeight;     // 7 - 30 data bytes
+    U32 mLongWeight;       // more than 30 data bytes
+    bool mACK;             // slave sends ack after messages that expect it
+    U8 mACKValue;          // MeLiBu 2 only; MeLiBu 1 ack is always 0x7E
+    U32 mCrcErrorRate;     // per mille of messages with wrong crc
+    U32 mFramingErrorRate; // per mille of messages with one byte with low stop bit
+    U32 mMissingByteRate;  // per mille of messages that end early; next break field comes instead of byte
+    U32 mFaultRate;        // per mille of messages with one of the three faults above, chosen evenly
+    U32 mSeed;
+};
+
+struct MELIBUTrafficByte
+{
+    U8 mValue;
+    bool mWrongStop; // stop bit is low
+};
+
+// one generated message: bytes following break field and idle time before next break field
+struct MELIBUTrafficMessage
+{
+    typedef enum {
+        faultCrc = 0x01,
+        faultFraming = 0x02,
+        faultMissingByte = 0x04
+    } tMELIBUTrafficFault;
+
+    std::vector < MELIBUTrafficByte > mBytes; // header, instruction, data, crc and ack in bus order
+    U32 mIdleBits;
+    U8 mFaults; // tMELIBUTrafficFault
+};
+
+// generates random messages with valid crc at requested bus load, optionally with injected faults
+// output depends only on settings (seeded generator), so traffic is the same on every run and platform
+class MELIBUTrafficGenerator
+{
+ public:
+    enum { BreakFieldBits = 16 }; // 2 idle bits, 13 low bits and stop bit
+
+    MELIBUTrafficGenerator();
+    ~MELIBUTrafficGenerator();
+
+    void Setup( const MELIBUTrafficSettings& settings );
+    void Next( MELIBUTrafficMessage& message );
+
+ protected:
+    U32 Random( U32 range ); // 0 .. range - 1
+    bool Chance( U32 per_mille );
+    U16 RandomIds();         // (ID1 << 8) | ID2 with data length from configured mix
+    void AddByte( MELIBUTrafficMessage& message, U8 value );
+
+ protected: //vars
+    MELIBUTrafficSettings mSettings;
+    const MELIBUFrameLayoutTable* mLayouts;
+    U8 mAckValue;
+    bool mCrcMsbFirst;
+    std::mt19937 mRandom;
+    std::vector < U16 > mIdsByLength[ 3 ]; // all id pairs grouped to short, medium and long messages
+    std::vector < U16 > mIdPool;           // ids used on the bus when mIdCount is set
+};
+
+#endif //MELIBU_TRAFFIC_GENERATOR_H
@@ -0,0 +1,14 @@
+#ifndef MELIBU_TYPES_H
+#define MELIBU_TYPES_H
+
+// integer types used by the decoder core; identical to the ones in LogicPublicTypes.h so the core
+// can be built and used without the Analyzer SDK (offline tools, build servers)
+typedef int S32;
+typedef long long int S64;
+
+typedef unsigned char U8;
+typedef unsigned short U16;
+typedef unsigned int U32;
+typedef unsigned long long int U64;
+
+#endif //MELIBU_TYPES_H
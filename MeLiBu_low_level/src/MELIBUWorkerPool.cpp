@@ -0,0 +1,92 @@
+#include "MELIBUWorkerPool.h"
+#include <algorithm>
+
+MELIBUWorkerPool::MELIBUWorkerPool( U32 num_threads )
+    :   mJobs( nullptr ),
+    mNextJob( 0 ),
+    mPendingJobs( 0 ),
+    mBatch( 0 ),
+    mStop( false ) {
+    if( num_threads == 0 )
+        num_threads = std::max( 1U, std::thread::hardware_concurrency() );
+    for( U32 i = 1; i < num_threads; i++ )
+        this->mThreads.push_back( std::thread( &MELIBUWorkerPool::WorkerLoop, this ) );
+}
+
+MELIBUWorkerPool::~MELIBUWorkerPool() {
+    {
+        std::lock_guard < std::mutex > lock( this->mMutex );
+        this->mStop = true;
+    }
+    this->mWorkAvailable.notify_all();
+    for( auto& thread : this->mThreads )
+        thread.join();
+}
+
+U32 MELIBUWorkerPool::NumThreads() const {
+    return ( U32 )this->mThreads.size() + 1;
+}
+
+void MELIBUWorkerPool::Run( std::vector < tJob >& jobs ) {
+    if( jobs.empty() )
+        return;
+    {
+        std::lock_guard < std::mutex > lock( this->mMutex );
+        this->mJobs = &jobs;
+        this->mNextJob = 0;
+        this->mPendingJobs = jobs.size();
+        this->mBatch++;
+    }
+    this->mWorkAvailable.notify_all();
+
+    while( RunNextJob() ) {
+    }
+
+    std::unique_lock < std::mutex > lock( this->mMutex );
+    this->mBatchDone.wait( lock, [ this ]() { return this->mPendingJobs == 0; } );
+    this->mJobs = nullptr;
+    if( this->mException ) {
+        std::exception_ptr exception = this->mException;
+        this->mException = nullptr;
+        std::rethrow_exception( exception );
+    }
+}
+
+bool MELIBUWorkerPool::RunNextJob() {
+    tJob* job;
+    {
+        std::lock_guard < std::mutex > lock( this->mMutex );
+        if( this->mJobs == nullptr || this->mNextJob >= this->mJobs->size() )
+            return false;
+        job = &( *this->mJobs )[ this->mNextJob++ ];
+    }
+    std::exception_ptr exception;
+    try {
+        ( *job )();
+    } catch( ... ) {
+        exception = std::current_exception();
+    }
+    {
+        std::lock_guard < std::mutex > lock( this->mMutex );
+        if( exception && !this->mException )
+            this->mException = exception;
+        if( --this->mPendingJobs == 0 )
+            this->mBatchDone.notify_all();
+    }
+    return true;
+}
+
+void MELIBUWorkerPool::WorkerLoop() {
+    U64 batch = 0;
+    for( ;; ) {
+        {
+            std::unique_lock < std::mutex > lock( this->mMutex );
+            this->mWorkAvailable.wait( lock, [ this, batch ]() { return this->mStop || this->mBatch != batch; } );
+            if( this->mStop )
+                return;
+            batch = this->mBatch;
+        }
+        while( RunNextJob() ) {
+        }
+    }
+}
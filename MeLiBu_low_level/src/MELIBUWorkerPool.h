@@ -0,0 +1,43 @@
+#ifndef MELIBU_WORKER_POOL_H
+#define MELIBU_WORKER_POOL_H
+
+#include "MELIBUTypes.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of threads that run batches of independent jobs; Run returns when all jobs of the batch are done
+// calling thread takes part in the work, so a pool of one thread runs everything inline
+// exception thrown by a job (e.g. by SDK channel data when analyzer thread must exit) is rethrown by Run
+class MELIBUWorkerPool
+{
+ public:
+    typedef std::function < void() > tJob;
+
+    explicit MELIBUWorkerPool( U32 num_threads = 0 ); // 0: one thread per core
+    ~MELIBUWorkerPool();
+
+    U32 NumThreads() const; // including calling thread
+    void Run( std::vector < tJob >& jobs );
+
+ protected:
+    void WorkerLoop();
+    bool RunNextJob(); // false if there is no job left in current batch
+
+ protected: //vars
+    std::vector < std::thread > mThreads;
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mBatchDone;
+    std::vector < tJob >* mJobs; // current batch
+    size_t mNextJob;
+    size_t mPendingJobs; // jobs of current batch not finished yet
+    U64 mBatch;          // incremented for every batch; workers wait for new one
+    std::exception_ptr mException; // first exception of current batch
+    bool mStop;
+};
+
+#endif //MELIBU_WORKER_POOL_H